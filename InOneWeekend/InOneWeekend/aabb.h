@@ -0,0 +1,97 @@
+#ifndef AABB_H
+#define AABB_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "ray.h"
+#include "vec3.h"
+
+#include <cmath>
+#include <utility> // std::swap 사용을 위해 포함
+
+// aabb(axis-aligned bounding box, 축 정렬 경계 상자) 클래스 정의
+/*
+	x, y, z 축에 평행한 면들로 이루어진 직육면체로 물체를 감싸두면,
+	반직선이 이 상자와 만나지 않는 경우에는 상자 안의 물체들을 검사할 필요가 없음.
+
+	상자와 반직선의 교차 검사는 물체 자체와의 교차 검사보다 훨씬 간단하기 때문에,
+	BVH 같은 가속 구조의 노드들이 이 상자를 사용함.
+*/
+class aabb
+{
+public:
+	point3 minimum; // 상자의 각 축 최솟값
+	point3 maximum; // 상자의 각 축 최댓값
+
+	// 기본 생성자는 아무것도 감싸지 않는 빈 상자를 만듦. (최솟값은 +무한대, 최댓값은 -무한대)
+	aabb() : minimum(infinity, infinity, infinity), maximum(-infinity, -infinity, -infinity) {}
+
+	// 두 점을 꼭지점으로 하는 상자 (두 점의 순서는 상관없음.)
+	aabb(const point3& a, const point3& b)
+		: minimum(std::fmin(a.x(), b.x()), std::fmin(a.y(), b.y()), std::fmin(a.z(), b.z())),
+		  maximum(std::fmax(a.x(), b.x()), std::fmax(a.y(), b.y()), std::fmax(a.z(), b.z())) {}
+
+	// 두 상자를 모두 감싸는 상자
+	aabb(const aabb& a, const aabb& b)
+		: minimum(std::fmin(a.minimum.x(), b.minimum.x()), std::fmin(a.minimum.y(), b.minimum.y()), std::fmin(a.minimum.z(), b.minimum.z())),
+		  maximum(std::fmax(a.maximum.x(), b.maximum.x()), std::fmax(a.maximum.y(), b.maximum.y()), std::fmax(a.maximum.z(), b.maximum.z())) {}
+
+	bool empty() const { return minimum.x() > maximum.x(); }
+
+	point3 centroid() const { return 0.5 * (minimum + maximum); }
+
+	// 가장 긴 축의 번호를 반환 (0: x, 1: y, 2: z)
+	int longest_axis() const
+	{
+		vec3 size = maximum - minimum;
+		if (size.x() > size.y()) return size.x() > size.z() ? 0 : 2;
+		return size.y() > size.z() ? 1 : 2;
+	}
+
+	// 상자의 겉넓이
+	double surface_area() const
+	{
+		if (empty()) return 0.0;
+		vec3 size = maximum - minimum;
+		return 2.0 * (size.x() * size.y() + size.y() * size.z() + size.z() * size.x());
+	}
+
+	// 반직선이 [ray_tmin, ray_tmax] 범위 안에서 상자와 만나는지 검사 (하단 필기 'slab 교차 검사' 참고)
+	bool hit(const ray& r, double ray_tmin, double ray_tmax) const
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			auto inv_d = 1.0 / r.direction()[a];
+			auto t0 = (minimum[a] - r.origin()[a]) * inv_d;
+			auto t1 = (maximum[a] - r.origin()[a]) * inv_d;
+			if (inv_d < 0.0) std::swap(t0, t1);
+
+			ray_tmin = t0 > ray_tmin ? t0 : ray_tmin;
+			ray_tmax = t1 < ray_tmax ? t1 : ray_tmax;
+			if (ray_tmax < ray_tmin) return false; // 두께가 0 인 상자도 통과시키기 위해 < 로 비교함. (하단 필기 참고)
+		}
+		return true;
+	}
+};
+
+#endif // !AABB_H
+
+/*
+	slab 교차 검사
+
+
+	축 정렬 상자는 x, y, z 각 축마다 두 개의 평행한 평면 사이의 구간(slab)이
+	세 개 겹쳐진 영역이라고 볼 수 있음.
+
+	반직선이 각 축의 slab 을 통과하는 비율값 t 의 구간 [t0, t1] 을 축마다 구한 뒤,
+	세 구간이 모두 겹치는 부분이 존재하면 반직선이 상자를 통과한다는 뜻임.
+
+	반직선의 방향벡터 성분이 음수이면 먼 평면을 먼저 만나게 되므로 t0, t1 을 뒤바꿔줘야 하고,
+	방향벡터 성분이 0 이면 inv_d 가 무한대가 되는데,
+	이때도 IEEE 754 부동소수점 규칙에 따라 t0, t1 이 +-무한대가 되어 올바르게 처리됨.
+
+	축에 평행한 평면 물체(바닥 사각형 메쉬 등)의 상자는 그 축의 두께가 0 이라서 t0 == t1 이 되므로,
+	구간이 비어있는지는 ray_tmax < ray_tmin 으로 판단해야 함. (<= 로 판단하면 이런 물체가 BVH 안에서 사라짐.)
+	triangle_mesh, sphere_cloud, scene_hierarchy 의 노드 검사도 같은 기준을 사용함.
+*/
@@ -0,0 +1,304 @@
+#ifndef BATCH_H
+#define BATCH_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "bvh.h" // 씬마다 BVH 를 한 번만 만들어서 작업들이 공유하기 위해 포함
+#include "camera.h"
+#include "color.h"
+#include "hittable_list.h"
+#include "postprocess.h"
+#include "renderer.h" // 각 작업의 타일을 렌더링할 때 render_region() 을 사용하기 위해 포함
+#include "sphere.h"
+#include "thread_pool.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// 배치 렌더링 작업 하나 (이미지 한 장)
+struct batch_job
+{
+	std::string name; // 리포트에 출력할 작업 이름
+	std::string output; // 결과 .ppm 파일 경로
+	shared_ptr<hittable> world; // 씬의 BVH. 같은 씬을 사용하는 작업들은 같은 객체를 공유함.
+	camera cam;
+	render_settings settings;
+	postprocess_options post; // 노출, 톤매핑, 감마 보정, 양자화 설정
+};
+
+// 매니페스트 파일에서 읽어들인 씬과 작업 목록
+struct batch_manifest
+{
+	std::map<std::string, shared_ptr<hittable_list>> scenes; // 씬 이름 -> 씬 (한 번만 만들어서 공유)
+	std::map<std::string, shared_ptr<bvh_node>> hierarchies; // 씬 이름 -> 씬이 닫힐 때 한 번만 만든 BVH (작업들이 공유)
+	std::vector<batch_job> jobs;
+};
+
+// 매니페스트를 읽어들임. 잘못된 줄은 std::cerr 로 알리고 건너뜀. (하단 필기 '매니페스트 형식' 참고)
+/*
+	default_cam, default_settings 는 각 작업에서 따로 지정하지 않은 값들의 기본값으로 사용됨.
+*/
+inline batch_manifest load_batch_manifest(std::istream& in, const camera& default_cam, const render_settings& default_settings,
+										  const postprocess_options& default_post = postprocess_options())
+{
+	batch_manifest manifest;
+	shared_ptr<hittable_list> current_scene; // scene ~ end 사이에서 구체를 추가할 씬
+	std::string current_name, line;
+	int line_number = 0;
+
+	// 열려있는 씬을 닫고 BVH 를 만듦. (end 를 빠뜨린 채로 다음 scene / job 이 오거나 파일이 끝나도 닫음.)
+	auto close_scene = [&]()
+	{
+		if (!current_scene) return;
+		manifest.hierarchies[current_name] = make_shared<bvh_node>(*current_scene);
+		current_scene = nullptr;
+	};
+
+	while (std::getline(in, line))
+	{
+		++line_number;
+		std::istringstream tokens(line);
+		std::string keyword;
+		if (!(tokens >> keyword) || keyword[0] == '#') continue; // 빈 줄과 주석은 무시
+
+		if (keyword == "scene")
+		{
+			close_scene();
+			tokens >> current_name;
+			current_scene = make_shared<hittable_list>();
+			manifest.scenes[current_name] = current_scene;
+		}
+		else if (keyword == "sphere" && current_scene)
+		{
+			double x, y, z, radius, x2, y2, z2, t0 = 0.0, t1 = 1.0;
+			if (!(tokens >> x >> y >> z >> radius))
+				std::cerr << "Batch manifest:" << line_number << ": expected 'sphere x y z radius [x2 y2 z2 [t0 t1]]'\n";
+			else if (tokens >> x2 >> y2 >> z2)
+			{
+				// 끝 위치의 중점까지 지정하면 움직이는 구체 (움직이는 시각 구간은 생략하면 0 ~ 1)
+				if (tokens >> t0 && !(tokens >> t1)) t1 = t0 + 1.0;
+				current_scene->add(make_shared<sphere>(point3(x, y, z), point3(x2, y2, z2), radius, t0, t1));
+			}
+			else
+				current_scene->add(make_shared<sphere>(point3(x, y, z), radius));
+		}
+		else if (keyword == "end")
+		{
+			close_scene();
+		}
+		else if (keyword == "job")
+		{
+			close_scene();
+
+			batch_job job;
+			job.cam = default_cam;
+			job.settings = default_settings;
+			job.post = default_post;
+			tokens >> job.name >> job.output;
+
+			// 나머지 토큰들은 key=value 형태의 작업별 설정값
+			std::string option;
+			while (tokens >> option)
+			{
+				size_t eq = option.find('=');
+				std::string key = option.substr(0, eq);
+				std::string value = (eq == std::string::npos) ? std::string() : option.substr(eq + 1);
+				double number = std::atof(value.c_str());
+
+				if (key == "scene")
+				{
+					auto it = manifest.hierarchies.find(value);
+					if (it != manifest.hierarchies.end()) job.world = it->second;
+				}
+				else if (key == "width") job.cam.image_width = std::max(1, static_cast<int>(number));
+				else if (key == "aspect") job.cam.aspect_ratio = number;
+				else if (key == "x") job.cam.center[0] = number;
+				else if (key == "y") job.cam.center[1] = number;
+				else if (key == "z") job.cam.center[2] = number;
+				else if (key == "focal_length") job.cam.focal_length = number;
+				else if (key == "viewport_height") job.cam.viewport_height = number;
+				else if (key == "shutter") job.cam.shutter_close = job.cam.shutter_open + number;
+				else if (key == "spp") job.settings.samples_per_pixel = std::max(1, static_cast<int>(number));
+				else if (key == "depth") job.settings.max_depth = std::max(1, static_cast<int>(number));
+				else if (key == "shading") job.settings.shading = (value == "diffuse") ? shading_mode::diffuse : shading_mode::normal;
+				else if (key == "exposure") job.post.exposure = number;
+				else if (key == "bits") job.post.bit_depth = static_cast<int>(number);
+				else if (key == "dither") job.post.dither = (value != "0");
+				else if (key == "tonemap" || key == "gamma")
+				{
+					bool known = (key == "tonemap") ? parse_tonemap(value, job.post.tonemap) : parse_gamma(value, job.post.gamma);
+					if (!known) std::cerr << "Batch manifest:" << line_number << ": unknown " << key << " '" << value << "'\n";
+				}
+				else std::cerr << "Batch manifest:" << line_number << ": unknown option '" << key << "'\n";
+			}
+
+			if (job.name.empty() || job.output.empty() || !job.world)
+			{
+				std::cerr << "Batch manifest:" << line_number << ": job needs a name, an output path and a known scene\n";
+				continue;
+			}
+
+			job.cam.initialize();
+			manifest.jobs.push_back(job);
+		}
+		else
+		{
+			std::cerr << "Batch manifest:" << line_number << ": unknown keyword '" << keyword << "'\n";
+		}
+	}
+
+	close_scene();
+	return manifest;
+}
+
+// 매니페스트의 모든 작업을 하나의 스레드 풀에서 타일 단위로 렌더링하고, 작업별 소요 시간을 report 로 출력함.
+/*
+	각 작업의 타일들은 스레드 풀의 하나의 큐에 순서대로 들어가기 때문에,
+	작은 작업의 마지막 타일을 처리하는 동안 놀고 있는 스레드들은
+	곧바로 다음 작업의 타일들을 가져가서 처리하게 됨.
+
+	다만 모든 작업의 프레임버퍼를 처음부터 할당하면
+	작업이 수천 개일 때 메모리가 부족할 수 있으므로,
+	동시에 진행 중인 작업의 개수는 스레드 개수의 4배로 제한함.
+*/
+inline void run_batch(const batch_manifest& manifest, int thread_count, int tile_size, std::ostream& report)
+{
+	using clock = std::chrono::steady_clock;
+
+	// 진행 중인 작업 하나의 상태
+	struct job_state
+	{
+		const batch_job* job = nullptr;
+		std::vector<color> framebuffer;
+		std::atomic<int> remaining_tiles{ 0 };
+		std::atomic<long long> busy_ns{ 0 }; // 모든 타일의 렌더링 시간 합 (CPU 시간에 해당)
+		clock::time_point submitted;
+		double latency = 0.0; // 타일을 큐에 넣은 시점 ~ 결과 파일 저장까지 걸린 시간
+		bool written = false;
+	};
+
+	thread_pool pool(thread_count);
+	const size_t max_in_flight = static_cast<size_t>(pool.size()) * 4;
+	std::vector<std::unique_ptr<job_state>> states(manifest.jobs.size());
+
+	std::mutex mtx;
+	std::condition_variable slot_cv;
+	size_t in_flight = 0;
+	long long total_pixels = 0;
+
+	auto batch_start = clock::now();
+
+	for (size_t k = 0; k < manifest.jobs.size(); ++k)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			slot_cv.wait(lock, [&]() { return in_flight < max_in_flight; });
+			++in_flight;
+		}
+
+		const batch_job& job = manifest.jobs[k];
+		states[k].reset(new job_state());
+		job_state* state = states[k].get();
+		state->job = &job;
+		state->framebuffer.assign(static_cast<size_t>(job.cam.image_width) * job.cam.image_height, color(0, 0, 0));
+		total_pixels += static_cast<long long>(job.cam.image_width) * job.cam.image_height;
+
+		int tiles_x = (job.cam.image_width + tile_size - 1) / tile_size;
+		int tiles_y = (job.cam.image_height + tile_size - 1) / tile_size;
+		state->remaining_tiles = tiles_x * tiles_y;
+		state->submitted = clock::now();
+
+		for (int ty = 0; ty < tiles_y; ++ty)
+		{
+			for (int tx = 0; tx < tiles_x; ++tx)
+			{
+				int x0 = tx * tile_size, y0 = ty * tile_size;
+				int x1 = std::min(x0 + tile_size, job.cam.image_width), y1 = std::min(y0 + tile_size, job.cam.image_height);
+
+				pool.submit([&, state, x0, y0, x1, y1]()
+				{
+					const batch_job& j = *state->job;
+					auto start = clock::now();
+					render_region(j.cam, *j.world, j.settings, state->framebuffer, nullptr, x0, y0, x1, y1);
+					state->busy_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - start).count();
+
+					// 마지막 타일을 끝낸 스레드가 후처리와 파일 저장까지 맡음.
+					if (--state->remaining_tiles == 0)
+					{
+						postprocess(state->framebuffer, j.post);
+						auto pixels = quantize(state->framebuffer, j.cam.image_width, j.cam.image_height, j.post);
+
+						std::ofstream out(j.output);
+						if (out) write_ppm(out, j.cam.image_width, j.cam.image_height, pixels, output_maxval(j.post));
+						state->written = static_cast<bool>(out);
+
+						state->latency = std::chrono::duration<double>(clock::now() - state->submitted).count();
+						std::vector<color>().swap(state->framebuffer); // 다 쓴 프레임버퍼 메모리는 바로 해제함.
+
+						std::lock_guard<std::mutex> lock(mtx);
+						--in_flight;
+						slot_cv.notify_one();
+					}
+				});
+			}
+		}
+	}
+
+	pool.wait_idle();
+	double total_time = std::chrono::duration<double>(clock::now() - batch_start).count();
+
+	// 작업별 리포트: 이름, 해상도, 샘플 수, 렌더링 시간(모든 타일 시간의 합), 대기 포함 소요 시간
+	report << "job\tsize\tspp\trender_ms\tlatency_ms\tstatus\n";
+	for (const auto& state : states)
+	{
+		const batch_job& j = *state->job;
+		report << j.name << '\t' << j.cam.image_width << 'x' << j.cam.image_height << '\t' << j.settings.samples_per_pixel << '\t'
+			   << state->busy_ns / 1e6 << '\t' << state->latency * 1e3 << '\t' << (state->written ? "ok" : "write failed") << '\n';
+	}
+
+	report << "total: " << manifest.jobs.size() << " jobs, " << manifest.scenes.size() << " scenes, " << pool.size() << " threads, "
+		   << total_time << " s, " << manifest.jobs.size() / total_time << " jobs/s, "
+		   << total_pixels / total_time / 1e6 << " Mpixel/s\n";
+}
+
+#endif // !BATCH_H
+
+/*
+	매니페스트 형식
+
+
+	한 줄에 하나씩 씬 또는 작업을 정의하는 텍스트 파일이며, # 으로 시작하는 줄은 주석임.
+
+	scene two_spheres
+	sphere 0 0 -1 0.5
+	sphere 0 -100.5 -1 100
+	sphere 0.8 0 -1.5 0.2 0.8 0.3 -1.5
+	end
+
+	job thumb_0001 out/thumb_0001.ppm scene=two_spheres width=64 spp=4 z=0.5
+	job thumb_0002 out/thumb_0002.ppm scene=two_spheres width=64 spp=4 x=0.2 shading=diffuse
+
+	sphere 줄 끝에 x2 y2 z2 를 더 적으면, 시각 0 ~ 1 동안 (x, y, z) 에서 (x2, y2, z2) 로 움직이는 구체가 됨.
+	그 뒤에 t0 t1 까지 적으면 움직이는 시각 구간을 t0 ~ t1 로 바꿀 수 있고, 구간 밖의 시각에는 양 끝 위치에 멈춰있음.
+
+	scene ~ end 사이의 sphere 들은 하나의 씬(hittable_list)으로 한 번만 만들어지고,
+	end 에서 씬을 닫을 때 그 씬의 BVH(bvh_node)도 한 번만 만들어서, 같은 씬 이름을 사용하는 작업들은 모두 이 BVH 를 공유함.
+	(작업마다 가속 구조를 다시 만들거나, 물체 수에 비례하는 hittable_list 순회를 하지 않음.)
+
+	job 줄에서 사용할 수 있는 설정값은
+	scene, width, aspect, x, y, z, focal_length, viewport_height, spp, depth, shading(normal / diffuse),
+	shutter(셔터가 열려있는 시간. 0 보다 크면 모션 블러 적용),
+	exposure, tonemap(none / reinhard / aces), gamma(linear / srgb / fast / lut), bits(8 / 16), dither(0 / 1) 이고,
+	지정하지 않은 값은 main() 에서 설정한 카메라와 렌더링 설정값을 그대로 사용함.
+*/
@@ -0,0 +1,129 @@
+#ifndef BVH_H
+#define BVH_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "aabb.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include "trace_stats.h"
+
+#include <algorithm>
+#include <vector>
+
+// 씬의 물체들을 경계 상자 계층 구조(BVH, bounding volume hierarchy)로 묶는 노드 클래스
+/*
+	hittable_list 는 반직선 하나마다 모든 물체와 교차 검사를 하므로, 물체 수에 비례해서 느려짐.
+
+	bvh_node 는 물체들을 공간적으로 가까운 것끼리 두 그룹으로 나누는 과정을 재귀적으로 반복해서 트리를 만들고,
+	반직선이 어떤 노드의 경계 상자와 만나지 않으면 그 아래의 물체들은 검사하지 않고 건너뜀.
+
+	각 물체의 bounding_box() 는 셔터가 열려있는 동안 물체가 움직이는 범위 전체를 감싸므로 (sphere.h 참고),
+	움직이는 물체가 섞여 있어도 트리를 시각마다 다시 만들 필요가 없음. (하단 필기 '움직이는 물체와 BVH' 참고)
+*/
+class bvh_node : public hittable
+{
+public:
+	bvh_node(const hittable_list& list) : bvh_node(list.objects(), 0, list.objects().size()) {}
+
+	// objects[start, end) 구간의 물체들로 노드를 만듦. (objects 는 복사본이므로 정렬해도 원래 씬에는 영향이 없음.)
+	bvh_node(std::vector<shared_ptr<hittable>> objects, size_t start, size_t end)
+	{
+		build(objects, start, end);
+	}
+
+	bool hit(const ray& r, double ray_tmin, double ray_tmax, hit_record& rec) const override
+	{
+		TRACE_COUNT(node_visits, 1);
+		if (!bbox.hit(r, ray_tmin, ray_tmax)) return false;
+
+		// 왼쪽 자식에서 충돌 지점을 찾았으면, 오른쪽 자식은 그보다 가까운 충돌만 찾으면 됨.
+		bool hit_left = left->hit(r, ray_tmin, ray_tmax, rec);
+		bool hit_right = right->hit(r, ray_tmin, hit_left ? rec.t : ray_tmax, rec);
+
+		return hit_left || hit_right;
+	}
+
+	aabb bounding_box() const override { return bbox; }
+
+	// 두 자식 (물체가 하나뿐인 노드는 두 자식이 같은 물체를 가리킴. scene_hierarchy 가 트리를 펼칠 때 사용함. interleaved.h 참고)
+	const shared_ptr<hittable>& left_child() const { return left; }
+	const shared_ptr<hittable>& right_child() const { return right; }
+
+	shared_ptr<hittable> clone() const override
+	{
+		auto copy = shared_ptr<bvh_node>(new bvh_node());
+		copy->bbox = bbox;
+		copy->left = left->clone();
+		copy->right = (right == left) ? copy->left : right->clone(); // 물체가 하나뿐인 노드는 두 자식이 같은 물체를 가리킴.
+		return copy;
+	}
+
+private:
+	shared_ptr<hittable> left;
+	shared_ptr<hittable> right;
+	aabb bbox;
+
+	bvh_node() {}
+
+	void build(std::vector<shared_ptr<hittable>>& objects, size_t start, size_t end)
+	{
+		// 구간 안의 모든 물체를 감싸는 상자를 구하고, 그 상자의 가장 긴 축을 기준으로 물체들을 나눔.
+		for (size_t k = start; k < end; ++k) bbox = aabb(bbox, objects[k]->bounding_box());
+		const int axis = bbox.longest_axis();
+
+		const size_t span = end - start;
+		if (span == 0)
+		{
+			// 빈 씬: 아무것도 담지 않은 리스트를 두 자식으로 둬서, 어떤 반직선과도 충돌하지 않는 노드를 만듦.
+			left = right = make_shared<hittable_list>();
+		}
+		else if (span == 1)
+		{
+			left = right = objects[start];
+		}
+		else if (span == 2)
+		{
+			left = objects[start];
+			right = objects[start + 1];
+		}
+		else
+		{
+			// 경계 상자 중점 기준으로 가운데에 오는 물체를 찾아서 절반씩 나눔. (전체 정렬 대신 nth_element 로 O(n))
+			const size_t mid = start + span / 2;
+			std::nth_element(objects.begin() + start, objects.begin() + mid, objects.begin() + end,
+							 [axis](const shared_ptr<hittable>& a, const shared_ptr<hittable>& b)
+							 { return a->bounding_box().centroid()[axis] < b->bounding_box().centroid()[axis]; });
+
+			auto l = shared_ptr<bvh_node>(new bvh_node());
+			auto r = shared_ptr<bvh_node>(new bvh_node());
+			l->build(objects, start, mid);
+			r->build(objects, mid, end);
+			left = l;
+			right = r;
+		}
+	}
+};
+
+#endif // !BVH_H
+
+/*
+	움직이는 물체와 BVH
+
+
+	모션 블러를 표현하려면 반직선마다 셔터가 열려있는 구간 안의 서로 다른 시각을 가지고,
+	움직이는 물체는 그 시각의 위치에서 교차 검사를 해야 함.
+
+	이때, 가속 구조를 만드는 방법은 크게 두 가지가 있음.
+
+	1. 시각마다(혹은 시간 구간마다) 따로 트리를 만드는 방법
+	2. 물체가 셔터 구간 동안 지나가는 범위 전체를 감싸는 경계 상자로 트리를 하나만 만드는 방법
+
+	여기서는 2번 방법을 사용함.
+	트리는 한 번만 만들면 되고, 반직선의 시각과 상관없이 같은 트리를 순회하면 되므로
+	정지한 씬을 렌더링할 때와 거의 같은 비용으로 모션 블러를 렌더링할 수 있음.
+
+	다만 물체가 셔터 구간 동안 많이 움직일수록 경계 상자가 커져서 서로 겹치는 노드가 많아지므로,
+	정지한 씬보다 건너뛸 수 있는 노드가 줄어들어 조금 느려짐.
+*/
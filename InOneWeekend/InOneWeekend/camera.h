@@ -0,0 +1,181 @@
+#ifndef CAMERA_H
+#define CAMERA_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "ray.h" // 카메라에서 각 픽셀로 향하는 반직선을 생성하기 위해 ray 클래스 포함
+#include "vec3.h"
+
+// camera 클래스 정의
+/*
+	main() 함수에 지역변수로 흩어져 있던 이미지 크기와 viewport 관련 계산을
+	하나의 클래스로 모아둔 것.
+
+	렌더링 모드(일반 렌더링, 프리뷰 서버 등)가 여러 개로 늘어나면서
+	같은 카메라 설정을 여러 곳에서 재사용하고,
+	카메라 파라미터가 바뀔 때마다 viewport 관련 값들을 다시 계산해야 하기 때문에
+	public 멤버변수로 설정값을 받고, initialize() 에서 나머지 값들을 계산하도록 구성함.
+*/
+class camera
+{
+public:
+	double aspect_ratio = 1.0; // 이미지의 종횡비 (이미지 너비 / 이미지 높이)
+	int image_width = 100; // 이미지 너비는 상수이며, 이미지 너비 값에 따라 이미지 높이 값이 종횡비와 곱해져서 계산됨.
+	double focal_length = 1.0; // 카메라 중점(eye point)과 viewport 사이의 거리
+	double viewport_height = 2.0; // 3D Scene 상에 존재하는 가상의 viewport 높이
+	point3 center = point3(0, 0, 0); // 3D Scene 상에서 카메라 중점(eye point) > viewport 로 casting 되는 모든 ray 의 출발점이기도 함.
+	double shutter_open = 0.0; // 셔터가 열리는 시각
+	double shutter_close = 0.0; // 셔터가 닫히는 시각 (shutter_open 보다 크면 샘플마다 그 사이의 무작위 시각으로 반직선을 쏴서 모션 블러가 생김.)
+
+	int image_height = 1; // initialize() 에서 image_width 와 aspect_ratio 로부터 계산됨.
+
+	// 설정된 public 멤버변수들로부터 이미지 높이와 viewport 관련 벡터들을 계산함.
+	// 카메라 설정값을 변경한 뒤에는 반드시 다시 호출해줘야 함.
+	void initialize()
+	{
+		// 이미지(.ppm 파일)의 rows 와 column(너비와 높이 해상도) 정의
+		/*
+			우선 이미지 사이즈는 rows 와 columns 개수를 정의하다보니
+			반드시 정수형으로 떨어져야 한다는 전제조건이 있음.
+
+			또한, 이미지의 aspect_ratio 를 16:9 로 설정했더라도,
+			두 가지 이유에 의해 정확히 16:9 로 비율이 딱 떨어지진 않음.
+
+			1. 우선 이미지 너비를 aspect_ratio 와 곱한 결과를
+			int 타입으로 형변환하므로(이미지 사이즈가 정수형이어야 한다고 했었지?),
+			가장 가까운 정수형으로 소수점이 버림되어서
+			정확한 aspect_ratio 에 딱 맞는 height 을 계산할 수 없음.
+
+			2. 심지어 1번 처럼 계산한 image_height 이 1보다 작아지면
+			무조건 1로 덮어쓰기 때문에, 16:9 비율로 딱 떨어지게 계산될 수 없음.
+
+			aspect_ratio 로 설정한 이미지의 종횡비는
+			어디까지나 이상적인 값이며, 실제 이미지 크기는
+			여기에 근사된 수치로 정해진다.
+		*/
+		image_height = static_cast<int>(image_width / aspect_ratio); // 이미지 높이는 정수형이므로, 너비와 종횡비를 곱한 실수값을 정수형으로 형변환함.
+		image_height = (image_height < 1) ? 1 : image_height; // 이미지 너비는 항상 1보다는 크도록 함.
+
+		// 실제로 계산된 색상을 저장하는 이미지 외에도, 3D Scene 에 존재하는 가상의 viewport 사이즈도 정의해야 함.
+		/*
+			viewport
+
+			카메라 지점(눈 지점)으로부터 ray 를 쏘면,
+			이 ray 가 가상의 viewport 에 일정 간격으로 정렬된 픽셀들을 통과시킴.
+
+			이러한 픽셀들이 grid 형태로 정렬되어 있는
+			3D Scene 안에 존재하는 가상의 직사각형을
+			'viewport' 라고 함.
+
+			이때, viewport 의 가로 / 세로 종횡비는
+			이미지의 가로 / 세로 종횡비와 일치시켜야 함.
+
+			단, viewport 사이즈는 이미지처럼 rows, column 으로
+			사용되는 개념이 아니기 때문에, 반드시 정수형일 필요가 없어
+			실수형으로 계산할 것임.
+		*/
+		auto viewport_width = viewport_height * (static_cast<double>(image_width) / image_height); // aspect_ratio 는 실제 이미지 사이즈의 종횡비와 달라, 실제 이미지 크기로부터 종횡비를 다시 계산해서 적용함.
+
+		/*
+			여기서부터 계산되는 변수들은
+			https://raytracing.github.io/books/RayTracingInOneWeekend.html > Figure 4 에 정리된
+			viewport 구조에 존재하는 벡터와 정점들을 선언 및 초기화한 것임.
+		*/
+		// 뷰포트 왼쪽 끝에서 오른쪽 끝으로 향하는 수평 방향 벡터(viewport_u) 와
+		// 뷰포트 위쪽 끝에서 아래쪽 끝으로 향하는 수직 방향 벡터(viewport_v) 정의
+		auto viewport_u = vec3(viewport_width, 0, 0);
+		auto viewport_v = vec3(0, -viewport_height, 0);
+
+		// pixel grid 의 각 픽셀 사이의 수평 방향 간격을 나타내는 벡터(pixel_delta_u)와
+		// pixel grid 의 각 픽셀 사이의 수직 방향 간격을 나타내는 벡터(pixel_delta_v) 정의
+		pixel_delta_u = viewport_u / image_width;
+		pixel_delta_v = viewport_v / image_height;
+
+		// 뷰포트의 좌상단 꼭지점의 '3D 공간 상의' 좌표 계산 (이미지 좌표 아님 주의!!) (Figure 4 에서 Q 로 표시)
+		// 카메라 원점에서 focal_length 만큼 음의 z축으로 이동 후, 뷰포트 수평 길이의 절반만큼 왼쪽으로,
+		// 뷰포트 수직 길이의 절반만큼 위쪽으로 이동
+		auto viewport_upper_left = center
+								- vec3(0, 0, focal_length) - viewport_u / 2 - viewport_v / 2;
+
+		// 'pixel grid'의 좌상단 픽셀(이미지 좌표 상으로 (0,0)에 해당하는 픽셀)의 '3D 공간 상의' 좌표 계산 (Figure 4 에서 P0,0 으로 표시)
+		// '뷰포트 좌상단 꼭지점'에서 픽셀 간격의 절반씩만큼 오른쪽, 아래쪽으로 이동
+		pixel00_loc = viewport_upper_left + 0.5 * (pixel_delta_u + pixel_delta_v);
+	}
+
+	// 카메라 중점에서 이미지 좌표 (i, j) 픽셀의 중점으로 향하는 반직선을 생성해서 반환함.
+	ray get_ray(int i, int j) const
+	{
+		// 뷰포트 각 픽셀 중점의 '3D 공간 상의' 좌표 계산
+		auto pixel_center = pixel00_loc + (i * pixel_delta_u) + (j * pixel_delta_v);
+
+		// 카메라 중점 ~ 뷰포트 각 픽셀 중점까지 향하는 방향벡터 계산
+		auto ray_direction = pixel_center - center;
+
+		return ray(center, ray_direction, shutter_open);
+	}
+
+	// 픽셀 중점이 아닌, (i, j) 픽셀 영역 내의 무작위 지점으로 향하는 반직선을 반환함.
+	// 한 픽셀에 여러 개의 샘플을 쏴서 평균을 내면, 물체의 경계선이 계단처럼 보이는 현상(aliasing)을 줄일 수 있음.
+	ray get_sample_ray(int i, int j) const
+	{
+		// 픽셀 중점을 기준으로 -0.5 ~ 0.5 픽셀 범위 내에서 무작위로 이동
+		auto px = -0.5 + random_double();
+		auto py = -0.5 + random_double();
+		return get_ray(i, j, px, py, sample_time());
+	}
+
+	// 픽셀 하나에 sample_count 개의 샘플을 쏠 때 sample 번째 샘플의 반직선
+	// 셔터 구간을 sample_count 개의 구간으로 나눠서 샘플마다 서로 다른 구간 안의 시각을 사용함. (하단 필기 '셔터 시각의 층화 샘플링' 참고)
+	ray get_sample_ray(int i, int j, int sample, int sample_count) const
+	{
+		auto px = -0.5 + random_double();
+		auto py = -0.5 + random_double();
+		return get_ray(i, j, px, py, sample_time(sample, sample_count));
+	}
+
+	// (i, j) 픽셀 중점에서 (px, py) 픽셀만큼 이동한 지점으로 향하고, 시각 time 에 쏘아진 반직선을 반환함.
+	// 같은 오프셋을 다시 넘기면 항상 같은 반직선이 만들어지므로, 샘플 위치를 저장해뒀다가 재현할 때 사용함. (hit_cache.h 참고)
+	ray get_ray(int i, int j, double px, double py, double time) const
+	{
+		auto pixel_center = pixel00_loc + (i * pixel_delta_u) + (j * pixel_delta_v);
+		auto pixel_sample = pixel_center + ((px * pixel_delta_u) + (py * pixel_delta_v));
+
+		return ray(center, pixel_sample - center, time);
+	}
+
+	// 셔터가 열려있는 구간 안의 무작위 시각 (셔터 구간의 길이가 0 이면 난수를 소모하지 않고 shutter_open 을 반환)
+	double sample_time() const
+	{
+		return (shutter_close > shutter_open) ? random_double(shutter_open, shutter_close) : shutter_open;
+	}
+
+	// 셔터 구간을 sample_count 등분한 것 중 sample 번째 구간 안의 무작위 시각
+	double sample_time(int sample, int sample_count) const
+	{
+		if (shutter_close <= shutter_open) return shutter_open;
+		return shutter_open + (shutter_close - shutter_open) * (sample + random_double()) / sample_count;
+	}
+
+private:
+	point3 pixel00_loc; // 'pixel grid' 좌상단 픽셀의 '3D 공간 상의' 좌표
+	vec3 pixel_delta_u; // pixel grid 의 각 픽셀 사이의 수평 방향 간격
+	vec3 pixel_delta_v; // pixel grid 의 각 픽셀 사이의 수직 방향 간격
+};
+
+#endif // !CAMERA_H
+
+/*
+	셔터 시각의 층화 샘플링 (stratified sampling)
+
+
+	모션 블러는 셔터가 열려있는 동안 물체가 지나간 모든 위치의 색상을 평균낸 것이므로,
+	픽셀마다 여러 개의 샘플을 서로 다른 시각에 쏴서 평균을 내면 됨.
+
+	이때, 샘플마다 셔터 구간 전체에서 시각을 무작위로 고르면,
+	운이 나쁜 픽셀은 샘플들이 한쪽 시각에 몰려서 노이즈가 커짐.
+
+	그래서 셔터 구간을 샘플 개수만큼 등분하고, 각 샘플은 자기 구간 안에서만 무작위 시각을 고르도록 하면,
+	샘플들이 셔터 구간 전체에 고르게 퍼지게 되어 같은 샘플 수로도 노이즈가 줄어듦.
+
+	여러 장의 서브프레임을 평균내는 방식은 시각을 몇 개의 고정된 값으로만 샘플링하는 것과 같아서,
+	서브프레임 수가 적으면 빠르게 움직이는 물체가 여러 개로 겹쳐 보이는 계단 현상(strobing)이 생김.
+*/
@@ -4,7 +4,10 @@
 
 #include "vec3.h" // color 를 vec3 클래스에 대한 별칭으로 선언하기 위해 포함
 
+#include <cstdint>
 #include <iostream>
+#include <string>
+#include <vector>
 
 // vec3 에 대한 별칭으로써 color 선언
 /*
@@ -56,4 +59,31 @@ void write_color(std::ostream& out, color pixel_color)
         << static_cast<int>(255.999 * pixel_color.z()) << '\n';
 }
 
+// 후처리(postprocess.h)까지 끝나고 정수형으로 양자화된 버퍼 전체를 .ppm 형식으로 한 번에 출력하는 함수
+// maxval 은 채널 값의 최댓값으로, 8비트 양자화면 255, 16비트 양자화면 65535 가 전달됨.
+inline void write_ppm(std::ostream& out, int width, int height, const std::vector<std::uint16_t>& pixels, int maxval)
+{
+    out << "P3\n" << width << ' ' << height << '\n' << maxval << '\n'; // PPM 메타 정보 출력
+
+    for (std::size_t k = 0; k + 2 < pixels.size(); k += 3)
+    {
+        out << pixels[k] << ' ' << pixels[k + 1] << ' ' << pixels[k + 2] << '\n';
+    }
+}
+
+// write_ppm() 으로 출력한 P3 형식의 .ppm 을 다시 읽어들이는 함수 (이미지 비교에 사용)
+// 형식이 잘못되었거나 픽셀 수가 부족하면 false 를 반환함.
+inline bool read_ppm(std::istream& in, int& width, int& height, std::vector<std::uint16_t>& pixels, int& maxval)
+{
+    std::string magic;
+    if (!(in >> magic >> width >> height >> maxval) || magic != "P3" || width <= 0 || height <= 0) return false;
+
+    pixels.resize(static_cast<std::size_t>(width) * height * 3);
+    for (auto& channel : pixels)
+    {
+        if (!(in >> channel)) return false;
+    }
+    return true;
+}
+
 #endif // !COLOR_H
@@ -0,0 +1,196 @@
+#ifndef DENOISER_H
+#define DENOISER_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "color.h"
+#include "vec3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+// 반직선이 처음 충돌한 지점(primary hit)에서 기록하는 보조 정보
+struct aux_sample
+{
+	color albedo = color(0, 0, 0); // 표면 자체의 색상 (조명과 무관한 반사율)
+	vec3 normal = vec3(0, 0, 0); // hit_record::normal (충돌하지 않았으면 영벡터)
+	double depth = 0.0; // hit_record::t (충돌하지 않았으면 0)
+};
+
+// 렌더링 루프가 색상 프레임버퍼와 함께 채워넣는 보조 버퍼들 (픽셀 당 샘플들의 평균값을 저장함.)
+struct aux_buffers
+{
+	int width = 0;
+	int height = 0;
+	std::vector<color> albedo;
+	std::vector<vec3> normal;
+	std::vector<double> depth;
+
+	void resize(int w, int h)
+	{
+		width = w;
+		height = h;
+		size_t n = static_cast<size_t>(w) * h;
+		albedo.assign(n, color(0, 0, 0));
+		normal.assign(n, vec3(0, 0, 0));
+		depth.assign(n, 0.0);
+	}
+
+	// 픽셀 하나의 샘플들로 누적한 보조 정보를 samples 로 나눠서 평균값으로 저장
+	void store(size_t index, const aux_sample& sum, int samples)
+	{
+		double scale = 1.0 / samples;
+		albedo[index] = scale * sum.albedo;
+		normal[index] = scale * sum.normal;
+		depth[index] = scale * sum.depth;
+	}
+};
+
+// 디노이저 설정값
+struct denoise_options
+{
+	int iterations = 5; // à-trous 반복 횟수 (i 번째 반복은 2^i 간격의 5x5 필터를 사용하므로, 5번이면 약 65x65 범위)
+	double sigma_color = 0.6; // 색상 차이에 대한 edge-stopping 민감도 (반복할 때마다 절반으로 줄어듦)
+	double sigma_normal = 0.1; // 노멀 차이에 대한 edge-stopping 민감도
+	double sigma_depth = 0.05; // 깊이(t) 차이에 대한 edge-stopping 민감도
+	double sigma_albedo = 0.05; // 알베도 차이에 대한 edge-stopping 민감도
+	int thread_count = 0; // 0 이면 std::thread::hardware_concurrency() 사용
+};
+
+/*
+	edge-avoiding à-trous wavelet 필터 (Dammertz et al. 2010)
+
+	5x5 B3-spline 커널을 반복할 때마다 2^i 간격으로 벌려서 적용하면,
+	적은 수의 샘플(25개)만으로 넓은 범위를 블러링할 수 있음.
+	('à trous' 는 프랑스어로 '구멍이 뚫린' 이라는 뜻으로, 커널 사이가 비어있는 모양에서 따온 이름)
+
+	이때, 색상 / 노멀 / 깊이 / 알베도가 크게 다른 이웃 픽셀은 가중치를 낮춰서
+	물체의 경계선이나 표면의 방향이 바뀌는 곳은 흐려지지 않도록 함. (하단 필기 '보조 버퍼와 edge-stopping' 참고)
+*/
+inline void denoise(std::vector<color>& framebuffer, const aux_buffers& aux, const denoise_options& opt)
+{
+	const int w = aux.width, h = aux.height;
+	const size_t n = static_cast<size_t>(w) * h;
+	if (framebuffer.size() != n || n == 0) return;
+
+	// 색상을 알베도로 나눠서 조명 성분(irradiance)만 남긴 뒤 필터링함. (텍스처 디테일이 흐려지지 않도록)
+	const double eps = 1e-3;
+	std::vector<color> current(n), next(n);
+	for (size_t k = 0; k < n; ++k)
+	{
+		const color& a = aux.albedo[k];
+		current[k] = color(framebuffer[k].x() / std::max(a.x(), eps),
+						   framebuffer[k].y() / std::max(a.y(), eps),
+						   framebuffer[k].z() / std::max(a.z(), eps));
+	}
+
+	static const double kernel[5] = { 1.0 / 16, 1.0 / 4, 3.0 / 8, 1.0 / 4, 1.0 / 16 };
+
+	int workers = opt.thread_count > 0 ? opt.thread_count : static_cast<int>(std::thread::hardware_concurrency());
+	workers = std::max(1, std::min(workers, h));
+
+	for (int it = 0; it < opt.iterations; ++it)
+	{
+		const int step = 1 << it;
+		const double sigma_c = opt.sigma_color / step;
+		const double inv_c = 1.0 / (sigma_c * sigma_c);
+		const double inv_n = 1.0 / (opt.sigma_normal * opt.sigma_normal);
+		const double inv_z = 1.0 / opt.sigma_depth;
+		const double inv_a = 1.0 / (opt.sigma_albedo * opt.sigma_albedo);
+
+		// 행(row) 단위로 나눠서 여러 스레드가 동시에 필터링함.
+		auto filter_rows = [&](int row_begin, int row_end)
+		{
+			for (int y = row_begin; y < row_end; ++y)
+			{
+				for (int x = 0; x < w; ++x)
+				{
+					const size_t p = static_cast<size_t>(y) * w + x;
+					const color cp = current[p];
+					const vec3 np = aux.normal[p];
+					const double zp = aux.depth[p];
+					const color ap = aux.albedo[p];
+
+					color sum(0, 0, 0);
+					double weight_sum = 0.0;
+
+					for (int dy = -2; dy <= 2; ++dy)
+					{
+						const int qy = y + dy * step;
+						if (qy < 0 || qy >= h) continue;
+
+						for (int dx = -2; dx <= 2; ++dx)
+						{
+							const int qx = x + dx * step;
+							if (qx < 0 || qx >= w) continue;
+
+							const size_t q = static_cast<size_t>(qy) * w + qx;
+							const double e = (current[q] - cp).length_squared() * inv_c
+										   + (aux.normal[q] - np).length_squared() * inv_n
+										   + std::fabs(aux.depth[q] - zp) * inv_z
+										   + (aux.albedo[q] - ap).length_squared() * inv_a;
+
+							// 각 edge-stopping 가중치의 곱 exp(a) * exp(b) ... 를 exp(a + b + ...) 한 번으로 계산함.
+							const double weight = kernel[dx + 2] * kernel[dy + 2] * std::exp(-e);
+							sum += weight * current[q];
+							weight_sum += weight;
+						}
+					}
+
+					next[p] = sum / weight_sum; // 중심 픽셀은 항상 포함되므로 weight_sum 은 0 이 아님
+				}
+			}
+		};
+
+		std::vector<std::thread> threads;
+		int rows_per_worker = (h + workers - 1) / workers;
+		for (int k = 1; k < workers; ++k)
+			threads.emplace_back(filter_rows, std::min(h, k * rows_per_worker), std::min(h, (k + 1) * rows_per_worker));
+		filter_rows(0, std::min(h, rows_per_worker));
+		for (auto& th : threads) th.join();
+
+		current.swap(next);
+	}
+
+	// 필터링된 조명 성분에 다시 알베도를 곱해서 최종 색상으로 복원
+	for (size_t k = 0; k < n; ++k)
+	{
+		const color& a = aux.albedo[k];
+		framebuffer[k] = color(current[k].x() * std::max(a.x(), eps),
+							   current[k].y() * std::max(a.y(), eps),
+							   current[k].z() * std::max(a.z(), eps));
+	}
+}
+
+// 두 프레임버퍼 사이의 RMSE(root mean squared error)를 계산 (디노이저 품질 측정용)
+inline double image_rmse(const std::vector<color>& a, const std::vector<color>& b)
+{
+	if (a.size() != b.size() || a.empty()) return 0.0;
+
+	double sum = 0.0;
+	for (size_t k = 0; k < a.size(); ++k) sum += (a[k] - b[k]).length_squared();
+	return std::sqrt(sum / (3.0 * a.size()));
+}
+
+#endif // !DENOISER_H
+
+/*
+	보조 버퍼와 edge-stopping
+
+
+	샘플 수가 적은 이미지에서 노이즈를 없애려고 단순히 블러링을 하면,
+	노이즈뿐만 아니라 물체의 경계선까지 함께 뭉개져 버림.
+
+	그래서 렌더링할 때 색상 외에도
+	반직선이 처음 충돌한 지점의 알베도, 노멀(hit_record::normal), 깊이(hit_record::t)를
+	보조 버퍼에 함께 기록해두는 것임.
+
+	이 값들은 조명 계산과 무관하게 결정되기 때문에,
+	샘플 수가 적더라도 노이즈가 거의 없음.
+
+	따라서, 필터링할 때 이웃 픽셀과 노멀이나 깊이가 크게 다르다면
+	서로 다른 물체이거나 표면이 꺾이는 지점이라고 판단해서 가중치를 낮추고,
+	비슷하다면 같은 표면이라고 판단해서 마음껏 평균을 내는 것!
+*/
@@ -0,0 +1,152 @@
+#ifndef FAST_MATH_H
+#define FAST_MATH_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring> // 비트 패턴을 복사하는 std::memcpy() 를 사용하기 위해 포함
+
+// 정규화, 역제곱근, 역수 계산을 근사식으로 대체할 지 여부 (하단 필기 '근사 역제곱근' 참고)
+/*
+	RT_FAST_MATH 가 1 이면 unit_vector() 와 구체 교차 검사가 아래의 근사 함수와 미리 계산해 둔 역수를 사용하고,
+	0 이면 지금까지와 똑같이 sqrt() 와 나눗셈으로 정확하게 계산함.
+
+	근사 결과는 허용 오차(fast_rsqrt_max_rel_error) 안에 있지만 출력 이미지가 비트 단위로 같지는 않으므로,
+	따로 지정하지 않으면 꺼져 있음. 켜려면 전처리기 정의에 RT_FAST_MATH=1 을 추가하면 됨.
+*/
+#ifndef RT_FAST_MATH
+#define RT_FAST_MATH 0
+#endif
+
+// SSE2 를 사용할 수 있는 환경(x64 빌드 또는 -msse2)에서는 rsqrtss / rsqrtps 명령으로 초기 근사값을 구함. (postprocess.h 와 같은 조건)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define FAST_MATH_USE_SSE2 1
+#endif
+
+// rsqrt_fast() 의 최대 상대 오차 |rsqrt_fast(x) * sqrt(x) - 1|
+/*
+	SSE2 : rsqrtss 의 초기값 오차 1.5 * 2^-12 가 뉴턴 반복 1회로 약 1.5 * (1.5 * 2^-12)^2 ≈ 2.0e-7 로 줄어듦.
+	그 외 : 비트 연산 초기값의 오차 3.4e-2 가 뉴턴 반복 2회로 약 4.7e-6 으로 줄어듦.
+
+	x 는 float 로 표현할 수 있는 정규화된 양수 범위(약 1.2e-38 ~ 3.4e38) 안에 있어야 함.
+*/
+#ifdef FAST_MATH_USE_SSE2
+const double fast_rsqrt_max_rel_error = 2.5e-7;
+#else
+const double fast_rsqrt_max_rel_error = 5.0e-6;
+#endif
+
+// 1 / sqrt(x) 를 정확하게 계산 (비교 기준)
+inline double rsqrt_exact(double x)
+{
+	return 1.0 / std::sqrt(x);
+}
+
+// 근사값 y 를 뉴턴-랩슨 반복 1회로 보정함. (f(y) = 1/y^2 - x 의 근을 찾는 반복식)
+inline double rsqrt_newton_step(double x, double y)
+{
+	return y * (1.5 - 0.5 * x * y * y);
+}
+
+// 1 / sqrt(x) 의 근사값 (sqrt 와 나눗셈 없이 곱셈만으로 계산)
+inline double rsqrt_fast(double x)
+{
+#ifdef FAST_MATH_USE_SSE2
+	// rsqrtss 는 float 정밀도의 역제곱근 근사값(12비트)을 나눗셈 한 번보다 훨씬 짧은 지연시간으로 돌려줌.
+	double y = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(static_cast<float>(x))));
+	return rsqrt_newton_step(x, y);
+#else
+	// 지수부를 -1/2 배 하는 비트 연산으로 초기값을 구함. (double 용 매직 넘버)
+	std::uint64_t bits;
+	std::memcpy(&bits, &x, sizeof(bits));
+	bits = 0x5fe6eb50c7b537a9ULL - (bits >> 1);
+	double y;
+	std::memcpy(&y, &bits, sizeof(y));
+	return rsqrt_newton_step(x, rsqrt_newton_step(x, y));
+#endif
+}
+
+#ifdef FAST_MATH_USE_SSE2
+// double 2개의 역제곱근 근사값 (rsqrt_fast() 와 같은 계산)
+inline __m128d rsqrt_fast_pd(__m128d x)
+{
+	const __m128d half = _mm_set1_pd(0.5), three_halves = _mm_set1_pd(1.5);
+
+	// double -> float 로 변환해서 rsqrtps 로 초기값을 구한 뒤, 다시 double 로 되돌려서 뉴턴 반복을 수행함.
+	__m128d y = _mm_cvtps_pd(_mm_rsqrt_ps(_mm_cvtpd_ps(x)));
+	return _mm_mul_pd(y, _mm_sub_pd(three_halves, _mm_mul_pd(_mm_mul_pd(half, x), _mm_mul_pd(y, y))));
+}
+
+// float 4개의 역제곱근 근사값 (오차는 float 의 반올림 오차 수준인 약 2^-22 까지만 줄어듦.)
+inline __m128 rsqrt_fast_ps(__m128 x)
+{
+	const __m128 half = _mm_set1_ps(0.5f), three_halves = _mm_set1_ps(1.5f);
+
+	__m128 y = _mm_rsqrt_ps(x);
+	return _mm_mul_ps(y, _mm_sub_ps(three_halves, _mm_mul_ps(_mm_mul_ps(half, x), _mm_mul_ps(y, y))));
+}
+#endif
+
+// 구조체 배열(SoA) 형태로 저장된 벡터 n 개를 한 번에 정규화함. (fast 가 false 면 sqrt() 와 나눗셈으로 정확하게 계산)
+/*
+	SSE2 에서는 벡터 2개씩 길이의 제곱을 구하고, rsqrt_fast_pd() 로 구한 역수를 각 성분에 곱함.
+	길이가 0 인 벡터는 unit_vector() 와 마찬가지로 결과가 NaN 이 됨.
+*/
+inline void normalize_soa(double* x, double* y, double* z, std::size_t n, bool fast)
+{
+	std::size_t i = 0;
+	if (fast)
+	{
+#ifdef FAST_MATH_USE_SSE2
+		for (; i + 2 <= n; i += 2)
+		{
+			__m128d vx = _mm_loadu_pd(x + i), vy = _mm_loadu_pd(y + i), vz = _mm_loadu_pd(z + i);
+			__m128d len2 = _mm_add_pd(_mm_add_pd(_mm_mul_pd(vx, vx), _mm_mul_pd(vy, vy)), _mm_mul_pd(vz, vz));
+			__m128d inv = rsqrt_fast_pd(len2);
+			_mm_storeu_pd(x + i, _mm_mul_pd(vx, inv));
+			_mm_storeu_pd(y + i, _mm_mul_pd(vy, inv));
+			_mm_storeu_pd(z + i, _mm_mul_pd(vz, inv));
+		}
+#endif
+		for (; i < n; ++i)
+		{
+			double inv = rsqrt_fast(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+			x[i] *= inv; y[i] *= inv; z[i] *= inv;
+		}
+		return;
+	}
+
+	for (; i < n; ++i)
+	{
+		double inv = 1.0 / std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+		x[i] *= inv; y[i] *= inv; z[i] *= inv;
+	}
+}
+
+#endif // !FAST_MATH_H
+
+/*
+	근사 역제곱근 (fast reciprocal square root)
+
+
+	벡터를 정규화하려면 v / |v| = v * (1 / sqrt(v⋅v)) 를 계산해야 하는데,
+	sqrt 와 나눗셈은 곱셈, 덧셈보다 지연시간이 몇 배나 길고 파이프라인도 잘 채워지지 않음.
+
+	CPU 에는 1 / sqrt(x) 의 대략적인 값을 아주 빠르게 구해주는 명령(SSE 의 rsqrtss / rsqrtps)이 있는데,
+	정밀도가 12비트 정도밖에 안 되므로 그대로 쓰기에는 부족함.
+
+	그래서 이 값을 초기값 y0 로 삼아 뉴턴-랩슨 반복을 한 번 수행함.
+
+		y1 = y0 * (1.5 - 0.5 * x * y0^2)
+
+	뉴턴 반복은 오차를 제곱으로 줄이므로 (상대 오차 e -> 약 1.5 * e^2),
+	12비트 정밀도가 한 번의 반복으로 약 22비트까지 올라가고, 그 과정에는 곱셈과 뺄셈만 필요함.
+
+	SSE 를 사용할 수 없는 환경에서는 double 의 지수부를 비트 연산으로 -1/2 배 하는 방식
+	(Quake III 의 0x5f3759df 와 같은 원리)으로 초기값을 구하고, 초기값이 더 부정확하므로 뉴턴 반복을 두 번 수행함.
+
+	이 오차는 반직선 방향과 노멀벡터의 길이가 1 에서 약 1e-7 만큼 벗어나는 정도이므로,
+	8비트로 양자화된 출력에서는 거의 드러나지 않음. (--fastmath-bench 로 정확한 경로의 이미지와 비교해볼 수 있음.)
+*/
@@ -0,0 +1,221 @@
+#ifndef HEATMAP_H
+#define HEATMAP_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "camera.h"
+#include "color.h"
+#include "hittable.h"
+#include "renderer.h"
+#include "thread_pool.h"
+#include "trace_stats.h" // 스레드별 교차 검사 카운터
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 픽셀 하나를 렌더링하는 동안 측정한 작업량 (픽셀의 모든 샘플을 합한 값)
+struct pixel_stats
+{
+	std::uint32_t primitive_tests = 0;
+	std::uint32_t node_visits = 0;
+	std::uint32_t bounces = 0;
+	std::uint64_t cycles = 0; // 픽셀 하나를 렌더링하는 데 걸린 시간 (CPU 사이클, trace_stats.h 참고)
+};
+
+// 히트맵으로 출력할 수 있는 통계 항목
+enum class stats_metric
+{
+	primitive_tests,
+	node_visits,
+	bounces,
+	cycles
+};
+
+inline const char* metric_name(stats_metric metric)
+{
+	switch (metric)
+	{
+	case stats_metric::primitive_tests: return "tests";
+	case stats_metric::node_visits: return "nodes";
+	case stats_metric::bounces: return "bounces";
+	default: return "cycles";
+	}
+}
+
+inline double metric_value(const pixel_stats& s, stats_metric metric)
+{
+	switch (metric)
+	{
+	case stats_metric::primitive_tests: return s.primitive_tests;
+	case stats_metric::node_visits: return s.node_visits;
+	case stats_metric::bounces: return s.bounces;
+	default: return static_cast<double>(s.cycles);
+	}
+}
+
+// renderer.h 의 render() 와 같은 이미지를 렌더링하면서, 픽셀마다 작업량을 측정해서 stats 에 저장함.
+/*
+	카운터는 스레드마다 따로 존재하므로(thread_local), 픽셀을 렌더링하기 전후의 값 차이가
+	곧 그 픽셀을 렌더링한 스레드가 해당 픽셀에서 수행한 작업량이 됨.
+
+	행(row) 단위로 스레드 풀에 나눠서 렌더링함.
+	RT_TRACE_STATS 가 0 인 빌드에서는 사이클 수만 측정됨.
+*/
+inline void render_with_stats(const camera& cam, const hittable& world, const render_settings& settings,
+							  std::vector<color>& framebuffer, std::vector<pixel_stats>& stats, int thread_count)
+{
+	const size_t pixel_count = static_cast<size_t>(cam.image_width) * cam.image_height;
+	framebuffer.assign(pixel_count, color(0, 0, 0));
+	stats.assign(pixel_count, pixel_stats());
+
+	thread_pool pool(thread_count);
+	for (int j = 0; j < cam.image_height; ++j)
+	{
+		pool.submit([&, j]()
+		{
+			for (int i = 0; i < cam.image_width; ++i)
+			{
+				const size_t index = static_cast<size_t>(j) * cam.image_width + i;
+#if RT_TRACE_STATS
+				const trace_counters before = thread_trace_counters();
+#endif
+				const std::uint64_t start = read_cycle_counter();
+
+				// 보조 버퍼를 쓰지 않는 render_region() 과 같은 계산
+				render_region(cam, world, settings, framebuffer, nullptr, i, j, i + 1, j + 1);
+
+				pixel_stats& s = stats[index];
+				s.cycles = read_cycle_counter() - start;
+#if RT_TRACE_STATS
+				const trace_counters& after = thread_trace_counters();
+				s.primitive_tests = static_cast<std::uint32_t>(after.primitive_tests - before.primitive_tests);
+				s.node_visits = static_cast<std::uint32_t>(after.node_visits - before.node_visits);
+				s.bounces = static_cast<std::uint32_t>(after.bounces - before.bounces);
+#endif
+			}
+		});
+	}
+	pool.wait_idle();
+}
+
+// 0 ~ 1 사이의 값을 검정 -> 파랑 -> 초록 -> 노랑 -> 빨강 순서의 색상으로 바꿈. (false color)
+inline color heat_color(double v)
+{
+	static const color stops[] = { color(0.0, 0.0, 0.0), color(0.0, 0.2, 1.0), color(0.0, 0.9, 0.3), color(1.0, 0.9, 0.0), color(1.0, 0.0, 0.0) };
+	const int last = static_cast<int>(sizeof(stops) / sizeof(stops[0])) - 1;
+
+	v = std::min(std::max(v, 0.0), 1.0) * last;
+	int k = std::min(static_cast<int>(v), last - 1);
+	double f = v - k;
+	return (1.0 - f) * stops[k] + f * stops[k + 1];
+}
+
+// 통계 항목 하나를 히트맵 .ppm 으로 저장함.
+/*
+	몇 개의 아주 큰 값 때문에 나머지 픽셀이 모두 어둡게 보이지 않도록,
+	최댓값 대신 상위 1% 에 해당하는 값(99 백분위수)을 가장 뜨거운 색으로 맵핑함.
+*/
+inline bool write_heatmap(const std::string& path, int width, int height, const std::vector<pixel_stats>& stats, stats_metric metric)
+{
+	std::vector<double> values(stats.size());
+	for (size_t k = 0; k < stats.size(); ++k) values[k] = metric_value(stats[k], metric);
+
+	std::vector<double> sorted = values;
+	size_t p99 = sorted.empty() ? 0 : (sorted.size() - 1) * 99 / 100;
+	std::nth_element(sorted.begin(), sorted.begin() + p99, sorted.end());
+	double scale = (sorted.empty() || sorted[p99] <= 0.0) ? 0.0 : 1.0 / sorted[p99];
+
+	std::vector<std::uint16_t> pixels;
+	pixels.reserve(values.size() * 3);
+	for (double v : values)
+	{
+		color c = heat_color(v * scale);
+		for (int a = 0; a < 3; ++a) pixels.push_back(static_cast<std::uint16_t>(255.999 * c[a]));
+	}
+
+	std::ofstream out(path);
+	if (!out) return false;
+	write_ppm(out, width, height, pixels, 255);
+	return static_cast<bool>(out);
+}
+
+// 통계 항목 하나의 분포를 2 의 거듭제곱 단위 구간으로 나눈 히스토그램으로 출력함.
+/*
+	구간 0 은 값이 0 인 픽셀, 구간 k 는 값이 [2^(k-1), 2^k) 인 픽셀들임.
+	작업량은 보통 몇 배씩 차이가 나므로, 같은 간격의 구간보다 로그 구간이 분포를 보기 쉬움.
+*/
+inline void write_histogram(std::ostream& out, const std::vector<pixel_stats>& stats, stats_metric metric)
+{
+	if (stats.empty()) return;
+
+	std::vector<double> values(stats.size());
+	for (size_t k = 0; k < stats.size(); ++k) values[k] = metric_value(stats[k], metric);
+	std::sort(values.begin(), values.end());
+
+	double sum = 0;
+	for (double v : values) sum += v;
+
+	std::vector<size_t> buckets;
+	for (double v : values)
+	{
+		size_t bucket = 0;
+		while (v >= 1.0) { v *= 0.5; ++bucket; }
+		if (bucket >= buckets.size()) buckets.resize(bucket + 1, 0);
+		++buckets[bucket];
+	}
+
+	out << metric_name(metric) << ": min " << values.front() << ", mean " << sum / values.size() << ", p50 "
+		<< values[values.size() / 2] << ", p99 " << values[(values.size() - 1) * 99 / 100] << ", max " << values.back()
+		<< ", total " << sum << '\n';
+
+	const size_t largest = *std::max_element(buckets.begin(), buckets.end());
+	for (size_t b = 0; b < buckets.size(); ++b)
+	{
+		if (buckets[b] == 0) continue;
+		std::string range = (b == 0) ? std::string("0") : "[" + std::to_string(1ULL << (b - 1)) + ", " + std::to_string(1ULL << b) + ")";
+		out << "  " << std::setw(24) << std::left << range << std::right << std::setw(8) << buckets[b] << "  "
+			<< std::string(buckets[b] * 40 / largest, '#') << '\n';
+	}
+}
+
+// 모든 통계 항목의 히트맵을 "<prefix>_<항목>.ppm" 으로 저장하고, 히스토그램은 report 로 출력함.
+inline void write_stats_report(const std::string& prefix, int width, int height, const std::vector<pixel_stats>& stats, std::ostream& report)
+{
+	const stats_metric metrics[] = { stats_metric::primitive_tests, stats_metric::node_visits, stats_metric::bounces, stats_metric::cycles };
+	for (stats_metric metric : metrics)
+	{
+#if !RT_TRACE_STATS
+		if (metric != stats_metric::cycles) continue; // 카운터가 제거된 빌드에서는 사이클 수만 의미가 있음.
+#endif
+		std::string path = prefix + "_" + metric_name(metric) + ".ppm";
+		if (!write_heatmap(path, width, height, stats, metric)) std::cerr << "Cannot write heatmap: " << path << '\n';
+		write_histogram(report, stats, metric);
+	}
+}
+
+#endif // !HEATMAP_H
+
+/*
+	통계 렌더링 모드
+
+
+	프레임의 어느 부분이 느린지 알려면, 픽셀마다 실제로 얼마나 많은 작업을 했는지 세어봐야 함.
+
+	1. primitive tests : 구체, 삼각형과의 교차 검사 횟수 (sphere::hit(), triangle_mesh 의 리프, sphere_soa::hit())
+	2. node visits     : BVH 노드 방문 횟수 (bvh_node::hit(), triangle_mesh 내부 BVH)
+	3. bounces         : 물체에 부딪혀 튕겨나간 반직선의 개수 (shade_hit(), kernel_ray_color())
+	4. cycles          : 픽셀 하나를 렌더링하는 데 걸린 CPU 사이클
+
+	카운터는 thread_local 변수라서 여러 스레드가 동시에 증가시켜도 잠금이나 원자적 연산이 필요 없고,
+	캐시 라인을 공유하지 않으므로 스레드 간 간섭(false sharing)도 없음.
+	그래서 최적화된 빌드에서도 RT_TRACE_STATS=1 로 켜둔 채로 사용할 수 있을 만큼 비용이 작음.
+
+	RT_TRACE_STATS=0 (Release 기본값)이면 TRACE_COUNT() 매크로가 ((void)0) 으로 바뀌어
+	hit() 함수들에서 카운터 코드가 완전히 사라지므로, 통계 기능이 없는 것과 같은 코드가 컴파일됨.
+*/
@@ -0,0 +1,225 @@
+#ifndef HIT_CACHE_H
+#define HIT_CACHE_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "camera.h"
+#include "color.h"
+#include "denoiser.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include "renderer.h" // 충돌 정보로부터 셰이딩만 계산하는 shade_hit(), shade_miss() 를 사용하기 위해 포함
+
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+// 카메라에서 쏜 첫 번째 반직선(primary ray)의 충돌 정보를 픽셀(샘플)마다 저장해두는 G-buffer (하단 필기 '1차 충돌 캐시' 참고)
+/*
+	카메라와 씬이 그대로이고 셰이딩 설정(하늘 색상, 셰이딩 방식 등)만 바뀌었다면,
+	카메라에서 쏜 반직선들이 어떤 물체의 어느 지점과 충돌하는지는 이전 렌더링과 똑같음.
+
+	그래서 첫 렌더링에서 교차 검사 결과를 저장해두고,
+	다음 렌더링부터는 교차 검사를 건너뛰고 저장된 충돌 정보로 셰이딩만 다시 계산함.
+
+	카메라 설정값, 씬(hittable_list)의 주소와 revision(), 경계 상자, 픽셀 당 샘플 수 중
+	하나라도 달라지면 저장된 값을 버리고 다시 교차 검사를 수행함.
+
+	hittable_list 의 물체 목록은 add() / clear() 로만 바꿀 수 있으므로 목록의 변경은 항상 revision() 에 반영되지만,
+	이미 추가된 물체의 내부 데이터를 직접 수정한 경우는 알 수 없으므로 invalidate() 를 호출해야 함.
+*/
+class primary_hit_cache
+{
+public:
+	// 샘플 하나의 충돌 정보 (32 바이트)
+	/*
+		충돌 지점 p 는 같은 반직선 위의 r.at(t) 로 똑같이 다시 계산할 수 있으므로 저장하지 않고,
+		반직선은 픽셀 내 샘플 오프셋(px, py)과 시각으로 camera::get_ray() 에서 다시 만듦.
+
+		샘플 오프셋은 -0.5 ~ 0.5 픽셀 범위이므로 1/65536 픽셀 단위의 16비트 고정소수점으로 저장함.
+		build() 에서도 저장된 값으로 반직선을 만들기 때문에, 다시 만든 반직선은 처음 교차 검사한 반직선과 정확히 같음.
+	*/
+	struct entry
+	{
+		double t; // 충돌 지점의 비율값 t (충돌하지 않았으면 음수)
+		float normal[3];
+		std::int32_t object_id;
+		std::int16_t px, py; // 픽셀 중점으로부터의 샘플 오프셋 (1/65536 픽셀 단위)
+		float time; // 반직선이 쏘아진 시각 (모션 블러)
+
+		double offset_x() const { return px / 65536.0; }
+		double offset_y() const { return py / 65536.0; }
+	};
+	static_assert(sizeof(entry) == 32, "primary_hit_cache::entry must stay 32 bytes (two entries per cache line)");
+
+	// 현재 카메라, 씬, 샘플 수에 대해 저장된 충돌 정보를 그대로 사용할 수 있는지 확인
+	bool valid_for(const camera& cam, const hittable_list& world, const render_settings& settings) const
+	{
+		if (entries.empty() || world_key != &world || world_revision != world.revision()) return false;
+		if (samples != settings.samples_per_pixel) return false;
+
+		const aabb box = world.bounding_box();
+		if (!same_point(box.minimum, world_bounds.minimum) || !same_point(box.maximum, world_bounds.maximum)) return false;
+
+		return cam.image_width == cam_key.image_width && cam.image_height == cam_key.image_height
+			&& cam.aspect_ratio == cam_key.aspect_ratio && cam.focal_length == cam_key.focal_length
+			&& cam.viewport_height == cam_key.viewport_height && same_point(cam.center, cam_key.center)
+			&& cam.shutter_open == cam_key.shutter_open && cam.shutter_close == cam_key.shutter_close;
+	}
+
+	// 물체의 내부 데이터를 직접 수정하는 등, 자동으로 알아챌 수 없는 변경이 있을 때 호출함.
+	void invalidate() { entries.clear(); }
+
+	// 모든 픽셀, 모든 샘플에 대해 교차 검사를 수행해서 충돌 정보를 다시 저장함.
+	void build(const camera& cam, const hittable_list& world, const render_settings& settings)
+	{
+		const int spp = settings.samples_per_pixel;
+		entries.resize(static_cast<size_t>(cam.image_width) * cam.image_height * spp);
+
+		size_t k = 0;
+		for (int j = 0; j < cam.image_height; ++j)
+		{
+			for (int i = 0; i < cam.image_width; ++i)
+			{
+				for (int s = 0; s < spp; ++s, ++k)
+				{
+					// 샘플이 하나면 픽셀 중점, 여러 개면 픽셀 내 무작위 지점 (renderer.h 의 render_region() 과 같은 규칙)
+					entry& e = entries[k];
+					e.px = (spp == 1) ? 0 : to_fixed_offset(-0.5 + random_double());
+					e.py = (spp == 1) ? 0 : to_fixed_offset(-0.5 + random_double());
+					e.time = (spp == 1) ? static_cast<float>(cam.shutter_open) : static_cast<float>(cam.sample_time(s, spp));
+
+					hit_record rec;
+					if (world.hit(cam.get_ray(i, j, e.offset_x(), e.offset_y(), e.time), 0.001, infinity, rec))
+					{
+						e.t = rec.t;
+						e.normal[0] = static_cast<float>(rec.normal.x());
+						e.normal[1] = static_cast<float>(rec.normal.y());
+						e.normal[2] = static_cast<float>(rec.normal.z());
+						e.object_id = rec.object_id;
+					}
+					else
+					{
+						e.t = -1.0;
+						e.normal[0] = e.normal[1] = e.normal[2] = 0.0f;
+						e.object_id = -1;
+					}
+				}
+			}
+		}
+
+		cam_key = cam;
+		world_key = &world;
+		world_revision = world.revision();
+		world_bounds = world.bounding_box();
+		samples = spp;
+	}
+
+	const entry& at(size_t pixel, int sample) const { return entries[pixel * samples + sample]; }
+
+	size_t memory_bytes() const { return entries.capacity() * sizeof(entry); }
+
+private:
+	std::vector<entry> entries;
+	camera cam_key;
+	const hittable_list* world_key = nullptr;
+	unsigned long world_revision = 0;
+	aabb world_bounds;
+	int samples = 0;
+
+	// -0.5 ~ 0.5 픽셀 범위의 오프셋을 1/65536 픽셀 단위로 내림함.
+	static std::int16_t to_fixed_offset(double offset)
+	{
+		const double q = std::floor(offset * 65536.0);
+		return static_cast<std::int16_t>(q < -32768.0 ? -32768.0 : (q > 32767.0 ? 32767.0 : q));
+	}
+
+	static bool same_point(const point3& a, const point3& b) { return a.x() == b.x() && a.y() == b.y() && a.z() == b.z(); }
+};
+
+// renderer.h 의 render() 와 같은 결과를 렌더링하지만, 1차 충돌 정보는 cache 에서 가져옴.
+/*
+	cache 가 현재 카메라와 씬에 맞지 않으면 먼저 교차 검사를 수행해서 다시 채움.
+	저장된 값을 그대로 사용했으면 true, 다시 채웠으면 false 를 반환함.
+
+	셰이딩 방식이 diffuse 이면 튕겨나간 반직선(2차 이후)은 매번 새로 추적함.
+*/
+inline bool render_cached(const camera& cam, const hittable_list& world, const render_settings& settings, primary_hit_cache& cache,
+						  std::vector<color>& framebuffer, aux_buffers* aux, bool show_progress)
+{
+	const bool reused = cache.valid_for(cam, world, settings);
+	if (!reused)
+	{
+		if (show_progress) std::clog << "\rBuilding primary hit cache... " << std::flush;
+		cache.build(cam, world, settings);
+	}
+
+	framebuffer.assign(static_cast<size_t>(cam.image_width) * cam.image_height, color(0, 0, 0));
+	if (aux) aux->resize(cam.image_width, cam.image_height);
+
+	for (int j = 0; j < cam.image_height; ++j)
+	{
+		if (show_progress) std::clog << "\rScanlines remaining: " << (cam.image_height - j) << ' ' << std::flush;
+
+		for (int i = 0; i < cam.image_width; ++i)
+		{
+			const size_t index = static_cast<size_t>(j) * cam.image_width + i;
+			color pixel_color(0, 0, 0);
+			aux_sample aux_sum;
+
+			for (int s = 0; s < settings.samples_per_pixel; ++s)
+			{
+				const primary_hit_cache::entry& e = cache.at(index, s);
+				const ray r = cam.get_ray(i, j, e.offset_x(), e.offset_y(), e.time);
+
+				aux_sample sample;
+				if (e.t < 0.0)
+				{
+					pixel_color += shade_miss(r, aux ? &sample : nullptr, settings.sky);
+				}
+				else
+				{
+					hit_record rec;
+					rec.t = e.t;
+					rec.p = r.at(e.t);
+					rec.normal = vec3(e.normal[0], e.normal[1], e.normal[2]);
+					rec.object_id = e.object_id;
+					pixel_color += shade_hit(r, rec, settings.max_depth, world, settings.shading, aux ? &sample : nullptr, settings.sky);
+				}
+				aux_sum.albedo += sample.albedo;
+				aux_sum.normal += sample.normal;
+				aux_sum.depth += sample.depth;
+			}
+
+			framebuffer[index] = pixel_color / settings.samples_per_pixel;
+			if (aux) aux->store(index, aux_sum, settings.samples_per_pixel);
+		}
+	}
+
+	return reused;
+}
+
+#endif // !HIT_CACHE_H
+
+/*
+	1차 충돌 캐시 (primary hit cache)
+
+
+	룩뎁(look-dev) 작업에서는 카메라와 물체 배치는 그대로 두고,
+	하늘 색상이나 셰이딩 방식 같은 값만 바꿔가면서 여러 번 다시 렌더링하는 경우가 많음.
+
+	이때, 카메라에서 쏘는 1차 반직선들은 매번 똑같은 물체의 똑같은 지점과 충돌하므로,
+	그 교차 검사 결과를 G-buffer 처럼 픽셀마다 저장해두면
+	이후의 렌더링에서는 교차 검사 비용 없이 셰이딩만 계산하면 됨.
+
+	normal 셰이딩은 1차 충돌 정보만으로 색상이 결정되므로 교차 검사가 완전히 사라지고,
+	diffuse 셰이딩도 1차 반직선의 교차 검사만큼은 절약됨.
+
+	샘플이 여러 개일 때는 픽셀 내 무작위 오프셋도 함께 저장해두는데,
+	그래야 다시 렌더링할 때 같은 반직선을 재현해서 저장된 t 로 충돌 지점을 계산할 수 있기 때문임.
+
+	노멀은 float 로 저장하므로, 캐시 없이 렌더링한 결과와 아주 작은 차이가 생길 수 있음.
+	(8비트로 양자화된 출력에서는 거의 드러나지 않는 수준)
+*/
@@ -2,8 +2,11 @@
 #define HITTABLE_H
 // 헤더 가드를 위한 전처리기 선언
 
+#include "aabb.h" // 물체를 감싸는 경계 상자를 반환하기 위해 포함
 #include "ray.h" // hittable(피충돌 물체)와의 충돌을 검사할 반직선을 정의할 ray 클래스 포함
 
+#include <memory>
+
 // hit_record(충돌 정보) 클래스 정의
 class hit_record
 {
@@ -11,6 +14,7 @@ public:
 	point3 p; // 반직선과 충돌한 지점의 좌표값
 	vec3 normal; // 반직선과 충돌한 지점의 노멀벡터
 	double t; // 반직선 상에서 충돌한 지점이 위치한 비율값 t
+	int object_id = -1; // 충돌한 물체가 hittable_list 안에서 몇 번째 물체인지 (hittable_list::hit() 에서 기록함.)
 };
 
 // hittable (피충돌 물체) 추상 클래스 정의
@@ -20,6 +24,12 @@ public:
 	virtual ~hittable() = default; // 하단 필기 '가상 소멸자와 default' 내용 참고
 
 	virtual bool hit(const ray& r, double ray_tmin, double ray_tmax, hit_record& rec) const = 0; // 하단 필기 '순수 가상 함수와 추상 클래스' 내용 참고 
+
+	virtual aabb bounding_box() const = 0; // 물체 전체를 감싸는 축 정렬 경계 상자 (aabb.h 참고)
+
+	// 물체가 가진 데이터(하위 물체 포함)를 모두 새로 할당해서 복사한 객체를 반환함.
+	// 복사본의 메모리는 이 함수를 호출한 스레드가 실행 중인 NUMA 노드에 할당됨. (numa.h 참고)
+	virtual std::shared_ptr<hittable> clone() const = 0;
 };
 
 #endif // !HITTABLE_H
@@ -0,0 +1,87 @@
+#ifndef HITTABLE_LIST_H
+#define HITTABLE_LIST_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "hittable.h" // 여러 hittable 객체들을 하나의 hittable 처럼 다루기 위해 포함
+#include "rtweekend.h" // shared_ptr 사용을 위해 포함
+
+#include <vector>
+
+// 여러 개의 hittable(피충돌 물체)를 모아서 관리하는 hittable_list 클래스 정의
+/*
+	hittable_list 자신도 hittable 을 상속받기 때문에,
+	ray_color() 같은 함수에서는 물체가 하나이든 여러 개이든
+	똑같이 hittable 타입의 world 하나로 취급해서 hit() 를 호출할 수 있음.
+*/
+class hittable_list : public hittable
+{
+public:
+	hittable_list() {}
+	hittable_list(shared_ptr<hittable> object) { add(object); }
+
+	// 씬에 존재하는 hittable 객체들 (읽기 전용)
+	/*
+		목록을 바꿀 때는 반드시 add() / clear() 를 거쳐야 경계 상자와 revision() 이 함께 갱신됨.
+		그래서 목록 자체는 private 으로 두고, 밖에서는 const 참조로만 읽을 수 있도록 함. (hit_cache.h 참고)
+	*/
+	const std::vector<shared_ptr<hittable>>& objects() const { return items; }
+
+	void clear()
+	{
+		items.clear();
+		bbox = aabb();
+		++edit_count;
+	}
+
+	void add(shared_ptr<hittable> object)
+	{
+		items.push_back(object);
+		bbox = aabb(bbox, object->bounding_box()); // 추가된 물체까지 감싸도록 경계 상자를 넓힘.
+		++edit_count;
+	}
+
+	// 물체가 추가되거나 제거될 때마다 1씩 증가하는 값. 씬이 바뀌었는지 확인할 때 사용함. (hit_cache.h 참고)
+	unsigned long revision() const { return edit_count; }
+
+	// 모든 물체와 충돌 검사를 해서, 반직선 출발점에서 가장 가까운 충돌 정보만 rec 에 저장함.
+	bool hit(const ray& r, double ray_tmin, double ray_tmax, hit_record& rec) const override
+	{
+		hit_record temp_rec;
+		bool hit_anything = false;
+		auto closest_so_far = ray_tmax; // 지금까지 찾은 가장 가까운 충돌 지점의 비율값 t
+
+		for (size_t k = 0; k < items.size(); ++k)
+		{
+			// 반직선의 유효범위 최댓값을 closest_so_far 로 좁혀가면서 검사하면,
+			// 이미 찾은 충돌 지점보다 멀리 있는 충돌은 자연스럽게 무시됨.
+			if (items[k]->hit(r, ray_tmin, closest_so_far, temp_rec))
+			{
+				hit_anything = true;
+				closest_so_far = temp_rec.t;
+				rec = temp_rec;
+				rec.object_id = static_cast<int>(k);
+			}
+		}
+
+		return hit_anything;
+	}
+
+	aabb bounding_box() const override { return bbox; }
+
+	// 포인터만 복사하지 않고, 물체들도 모두 clone() 으로 복사함.
+	shared_ptr<hittable> clone() const override { return make_shared<hittable_list>(deep_copy()); }
+
+	hittable_list deep_copy() const
+	{
+		hittable_list copy;
+		for (const auto& object : items) copy.add(object->clone());
+		return copy;
+	}
+
+private:
+	std::vector<shared_ptr<hittable>> items; // 씬에 존재하는 hittable 객체들의 포인터를 저장하는 동적 배열
+	aabb bbox; // 모든 물체를 감싸는 경계 상자
+	unsigned long edit_count = 0;
+};
+
+#endif // !HITTABLE_LIST_H
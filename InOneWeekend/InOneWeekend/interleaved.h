@@ -0,0 +1,469 @@
+#ifndef INTERLEAVED_H
+#define INTERLEAVED_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "aabb.h"
+#include "bvh.h"
+#include "camera.h"
+#include "color.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include "renderer.h"
+#include "trace_stats.h"
+#include "triangle_mesh.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <utility>
+#include <vector>
+
+// 씬 전체(bvh_node / hittable_list / triangle_mesh / 그 밖의 물체)를 평평한 배열로 펼친 경계 상자 계층 구조
+/*
+	bvh_node::hit() 와 hittable_list::hit() 는 가상 함수 호출로 트리를 재귀적으로 내려가므로,
+	반직선 하나의 순회를 중간에 멈췄다가 다시 이어갈 수 없음.
+
+	scene_hierarchy 는 build() 에서 씬의 트리 구조를 triangle_mesh 의 BVH 와 같은 32 바이트 노드 배열로 펼쳐두고,
+	hit_interleaved() 에서 여러 반직선의 순회를 한 단계씩 번갈아 진행함. (triangle_mesh.h 하단 필기 '반직선 인터리빙' 참고)
+
+	1. bvh_node      : 두 자식을 가진 내부 노드 (물체가 하나뿐인 노드는 그 물체 자체로 펼침.)
+	2. hittable_list : bvh_node::build() 와 같은 방법(경계 상자 중점의 중앙값)으로 나눈 내부 노드들
+	3. triangle_mesh : 리프. 리프에 닿으면 메쉬 자신의 BVH 도 같은 방식으로 한 단계씩 순회함.
+	4. 그 밖의 물체  : 리프. 물체의 hit() 를 한 번 호출함.
+
+	물체들은 포인터로만 가리키므로, scene_hierarchy 를 사용하는 동안 원래 씬이 살아있어야 함.
+*/
+class scene_hierarchy
+{
+public:
+	scene_hierarchy() {}
+	explicit scene_hierarchy(const hittable& world) { build(world); }
+
+	void build(const hittable& world)
+	{
+		nodes.clear();
+		primitives.clear();
+		add_object(world);
+	}
+
+	// rays[0, count) 를 group_size 개씩 번갈아 순회하면서 가장 가까운 충돌을 찾음. (triangle_mesh::hit_interleaved() 와 같은 사용법)
+	/*
+		hits[k] 에 반직선 k 의 충돌 여부를 저장하고, 충돌했으면 recs[k] 를 채움.
+		충돌 지점은 world.hit() 와 같음. (여러 물체가 정확히 같은 t 에서 만나는 경우에만 어느 물체의 기록이 남는지가 다를 수 있음.)
+	*/
+	void hit_interleaved(const ray* rays, size_t count, double ray_tmin, double ray_tmax, hit_record* recs, bool* hits, int group_size) const
+	{
+		if (nodes.empty())
+		{
+			std::fill(hits, hits + count, false);
+			return;
+		}
+
+		std::vector<traversal_state> group(std::max<size_t>(1, std::min<size_t>(count, static_cast<size_t>(std::max(group_size, 1)))));
+		size_t active = 0, next_ray = 0;
+		for (; active < group.size() && next_ray < count; ++active, ++next_ray) start_traversal(group[active], rays[next_ray], next_ray, ray_tmax);
+
+		// 살아있는 반직선들을 차례대로 한 단계씩 진행시킴. (triangle_mesh::hit_interleaved() 와 같은 방식으로 자리를 채움.)
+		while (active > 0)
+		{
+			for (size_t k = 0; k < active;)
+			{
+				traversal_state& state = group[k];
+				if (!step_traversal(state, rays[state.ray_index], ray_tmin))
+				{
+					++k;
+					continue;
+				}
+
+				hits[state.ray_index] = state.hit_anything;
+				if (state.hit_anything) recs[state.ray_index] = state.rec;
+
+				if (next_ray < count)
+				{
+					start_traversal(state, rays[next_ray], next_ray, ray_tmax);
+					++next_ray;
+					++k;
+				}
+				else
+				{
+					state = group[--active];
+				}
+			}
+		}
+	}
+
+	size_t node_count() const { return nodes.size(); }
+
+	size_t memory_bytes() const { return nodes.capacity() * sizeof(node) + primitives.capacity() * sizeof(primitive); }
+
+private:
+	// 계층 구조의 노드 (32 바이트)
+	/*
+		triangle_mesh 의 노드와 같이 깊이 우선 순서로 저장하므로, 내부 노드의 왼쪽 자식은 항상 node + 1 에 있고
+		오른쪽 자식의 인덱스만 first 에 저장함. 리프 노드는 count == 1 이고, first 는 primitives 의 인덱스임.
+	*/
+	struct node
+	{
+		float bmin[3];
+		float bmax[3];
+		std::uint32_t first;
+		std::uint16_t count;
+		std::uint16_t axis;
+	};
+
+	static_assert(sizeof(node) == 32, "scene_hierarchy::node must stay 32 bytes");
+
+	// 리프가 가리키는 물체 (mesh 는 object 가 triangle_mesh 일 때만 nullptr 이 아님.)
+	struct primitive
+	{
+		const hittable* object;
+		const triangle_mesh* mesh;
+	};
+
+	std::vector<node> nodes;
+	std::vector<primitive> primitives;
+
+	// double 경계를 float 로 줄일 때, 상자가 작아지지 않도록 바깥쪽으로 반올림함.
+	static float round_down(double x)
+	{
+		float f = static_cast<float>(x);
+		return (f > x) ? std::nextafter(f, -std::numeric_limits<float>::infinity()) : f;
+	}
+
+	static float round_up(double x)
+	{
+		float f = static_cast<float>(x);
+		return (f < x) ? std::nextafter(f, std::numeric_limits<float>::infinity()) : f;
+	}
+
+	std::uint32_t push_node(const aabb& box, std::uint32_t first, std::uint16_t count, int axis)
+	{
+		node n;
+		for (int a = 0; a < 3; ++a)
+		{
+			n.bmin[a] = round_down(box.minimum[a]);
+			n.bmax[a] = round_up(box.maximum[a]);
+		}
+		n.first = first;
+		n.count = count;
+		n.axis = static_cast<std::uint16_t>(axis);
+
+		nodes.push_back(n);
+		return static_cast<std::uint32_t>(nodes.size() - 1);
+	}
+
+	// object 를 노드로 펼치고 그 노드의 인덱스를 반환함.
+	std::uint32_t add_object(const hittable& object)
+	{
+		if (auto b = dynamic_cast<const bvh_node*>(&object))
+		{
+			if (b->left_child() == b->right_child()) return add_object(*b->left_child());
+
+			const aabb box = b->bounding_box();
+			const std::uint32_t index = push_node(box, 0, 0, box.longest_axis());
+			// 자식을 추가하는 동안 nodes 가 재할당될 수 있으므로, 오른쪽 자식의 인덱스를 받은 뒤에 nodes[index] 에 씀.
+			add_object(*b->left_child());
+			const std::uint32_t right = add_object(*b->right_child());
+			nodes[index].first = right;
+			return index;
+		}
+
+		if (auto l = dynamic_cast<const hittable_list*>(&object))
+		{
+			// 빈 리스트는 빈 상자를 가진 리프가 되어, 어떤 반직선과도 만나지 않음.
+			if (l->objects().empty()) return add_leaf(object);
+
+			std::vector<const hittable*> items;
+			for (const auto& item : l->objects()) items.push_back(item.get());
+			return add_range(items, 0, items.size());
+		}
+
+		return add_leaf(object);
+	}
+
+	std::uint32_t add_leaf(const hittable& object)
+	{
+		primitive p;
+		p.object = &object;
+		p.mesh = dynamic_cast<const triangle_mesh*>(&object);
+		primitives.push_back(p);
+		return push_node(object.bounding_box(), static_cast<std::uint32_t>(primitives.size() - 1), 1, 0);
+	}
+
+	// items[start, end) 의 물체들을 bvh_node::build() 와 같은 방법으로 나눠서 펼침. (구간은 비어있지 않아야 함.)
+	std::uint32_t add_range(std::vector<const hittable*>& items, size_t start, size_t end)
+	{
+		const size_t span = end - start;
+		if (span == 1) return add_object(*items[start]);
+
+		aabb box;
+		for (size_t k = start; k < end; ++k) box = aabb(box, items[k]->bounding_box());
+		const int axis = box.longest_axis();
+
+		const size_t mid = start + span / 2;
+		std::nth_element(items.begin() + start, items.begin() + mid, items.begin() + end,
+						 [axis](const hittable* a, const hittable* b)
+						 { return a->bounding_box().centroid()[axis] < b->bounding_box().centroid()[axis]; });
+
+		const std::uint32_t index = push_node(box, 0, 0, axis);
+		add_range(items, start, mid);
+		const std::uint32_t right = add_range(items, mid, end);
+		nodes[index].first = right;
+		return index;
+	}
+
+	// p 가 가리키는 캐시 라인을 미리 읽어오도록 요청함. (triangle_mesh::prefetch() 와 같음.)
+	static void prefetch(const void* p)
+	{
+#ifdef TRIANGLE_MESH_USE_PREFETCH
+		_mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+		(void)p;
+#endif
+	}
+
+	// 반직선 하나의 순회 상태
+	struct traversal_state
+	{
+		enum step_kind
+		{
+			visit_node, // node 의 경계 상자를 검사 (노드는 프리페치해둔 상태)
+			test_leaf, // 리프 node 의 물체는 프리페치해둔 상태 -> 물체와 교차 검사 (메쉬면 메쉬 순회를 시작)
+			step_mesh // 리프 node 의 메쉬 BVH 를 한 단계 진행
+		};
+
+		size_t ray_index;
+		step_kind step;
+		vec3 inv_dir;
+		std::uint32_t stack[64];
+		int sp;
+		std::uint32_t node;
+		double closest;
+		hit_record rec;
+		bool hit_anything;
+		triangle_mesh::traversal_state mesh_state;
+	};
+
+	void start_traversal(traversal_state& state, const ray& r, size_t ray_index, double ray_tmax) const
+	{
+		state.ray_index = ray_index;
+		state.step = traversal_state::visit_node;
+		state.inv_dir = vec3(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+		state.sp = 0;
+		state.node = 0;
+		state.closest = ray_tmax;
+		state.hit_anything = false;
+		prefetch(&nodes[0]);
+	}
+
+	// 스택에서 다음 노드를 꺼내서 프리페치함. 스택이 비어있으면 순회가 끝난 것이므로 true 를 반환함.
+	bool pop_node(traversal_state& state) const
+	{
+		if (state.sp == 0) return true;
+		state.node = state.stack[--state.sp];
+		state.step = traversal_state::visit_node;
+		prefetch(&nodes[state.node]);
+		return false;
+	}
+
+	// 반직선 하나를 한 단계 진행시킴. 순회가 끝나면 true 를 반환함.
+	bool step_traversal(traversal_state& state, const ray& r, double ray_tmin) const
+	{
+		const node& n = nodes[state.node];
+		switch (state.step)
+		{
+		case traversal_state::visit_node:
+			TRACE_COUNT(node_visits, 1);
+			if (!node_hit(n, r, state.inv_dir, ray_tmin, state.closest)) return pop_node(state);
+
+			if (n.count > 0)
+			{
+				prefetch(primitives[n.first].object);
+				state.step = traversal_state::test_leaf;
+			}
+			else
+			{
+				std::uint32_t left = state.node + 1, right = n.first;
+				if (r.direction()[n.axis] < 0) std::swap(left, right);
+				state.stack[state.sp++] = right;
+				state.node = left;
+				prefetch(&nodes[left]);
+			}
+			return false;
+
+		case traversal_state::test_leaf:
+		{
+			const primitive& p = primitives[n.first];
+			if (p.mesh)
+			{
+				p.mesh->start_traversal(state.mesh_state, r, state.ray_index, state.closest);
+				state.step = traversal_state::step_mesh;
+				return false;
+			}
+
+			hit_record temp_rec;
+			if (p.object->hit(r, ray_tmin, state.closest, temp_rec))
+			{
+				state.hit_anything = true;
+				state.closest = temp_rec.t;
+				state.rec = temp_rec;
+			}
+			return pop_node(state);
+		}
+
+		default:
+		{
+			const triangle_mesh* mesh = primitives[n.first].mesh;
+			if (!mesh->step_traversal(state.mesh_state, r, ray_tmin)) return false;
+
+			if (state.mesh_state.hit_anything)
+			{
+				mesh->finish_traversal(state.mesh_state, r, state.rec);
+				state.hit_anything = true;
+				state.closest = state.mesh_state.closest;
+			}
+			return pop_node(state);
+		}
+		}
+	}
+
+	static bool node_hit(const node& n, const ray& r, const vec3& inv_dir, double ray_tmin, double ray_tmax)
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			double t0 = (n.bmin[a] - r.origin()[a]) * inv_dir[a];
+			double t1 = (n.bmax[a] - r.origin()[a]) * inv_dir[a];
+			if (inv_dir[a] < 0.0) std::swap(t0, t1);
+			ray_tmin = t0 > ray_tmin ? t0 : ray_tmin;
+			ray_tmax = t1 < ray_tmax ? t1 : ray_tmax;
+			if (ray_tmax < ray_tmin) return false;
+		}
+		return true;
+	}
+};
+
+// 인터리빙 렌더링 설정값
+struct interleave_options
+{
+	int group_size = 16; // 번갈아 순회할 반직선 수
+	size_t batch_size = 4096; // 한 번에 추적할 경로(샘플) 수
+};
+
+// render() 와 같은 이미지를, 반직선들을 묶음 단위로 scene_hierarchy::hit_interleaved() 로 추적해서 렌더링함. (하단 필기 '장면 단위 인터리빙 렌더링' 참고)
+/*
+	1차 반직선은 render_region() 과 같은 순서(픽셀, 샘플 순)로 만들고,
+	묶음 안의 반직선들을 한꺼번에 추적한 뒤 셰이딩하고, 난반사로 튕겨나간 반직선들을 모아 다시 한꺼번에 추적함.
+	노멀 셰이딩은 render() 와 같은 결과를 만들고, 난반사 셰이딩은 난수를 쓰는 순서만 달라짐.
+*/
+inline void render_interleaved(const camera& cam, const hittable& world, const render_settings& settings, const interleave_options& options,
+							   std::vector<color>& framebuffer, bool show_progress)
+{
+	const scene_hierarchy scene(world);
+
+	const int spp = settings.samples_per_pixel;
+	const size_t pixel_count = static_cast<size_t>(cam.image_width) * cam.image_height;
+	const size_t sample_count = pixel_count * spp;
+	const size_t batch_size = std::max<size_t>(1, options.batch_size);
+	framebuffer.assign(pixel_count, color(0, 0, 0));
+
+	// 추적 중인 경로 하나 (어느 픽셀에 더할지, 남은 반사 횟수, 지금까지 곱해진 알베도)
+	struct path
+	{
+		size_t pixel;
+		int depth;
+		color weight;
+	};
+
+	std::vector<ray> rays;
+	std::vector<path> paths;
+	std::vector<hit_record> recs(batch_size);
+	std::unique_ptr<bool[]> hits(new bool[batch_size]);
+
+	for (size_t next_sample = 0; next_sample < sample_count;)
+	{
+		if (show_progress) std::clog << "\rSamples remaining: " << (sample_count - next_sample) << ' ' << std::flush;
+
+		rays.clear();
+		paths.clear();
+		if (settings.max_depth > 0)
+		{
+			for (; rays.size() < batch_size && next_sample < sample_count; ++next_sample)
+			{
+				const size_t pixel = next_sample / spp;
+				const int i = static_cast<int>(pixel % cam.image_width), j = static_cast<int>(pixel / cam.image_width);
+				const int s = static_cast<int>(next_sample % spp);
+				rays.push_back((spp == 1) ? cam.get_ray(i, j) : cam.get_sample_ray(i, j, s, spp));
+				paths.push_back({ pixel, settings.max_depth, color(1, 1, 1) });
+			}
+		}
+		else
+		{
+			next_sample = sample_count; // 반사 횟수 제한이 0 이면 ray_color() 가 항상 검은색을 반환하므로 추적할 것이 없음.
+		}
+
+		// 묶음 안의 반직선들이 모두 하늘에 닿거나 반사 횟수 제한에 걸릴 때까지 반복함.
+		while (!rays.empty())
+		{
+			scene.hit_interleaved(rays.data(), rays.size(), 0.001, infinity, recs.data(), hits.get(), options.group_size);
+
+			size_t alive = 0;
+			for (size_t k = 0; k < rays.size(); ++k)
+			{
+				const path& p = paths[k];
+				if (!hits[k])
+				{
+					framebuffer[p.pixel] += p.weight * settings.sky.at(rays[k]);
+					continue;
+				}
+
+				const hit_record& rec = recs[k];
+				if (settings.shading == shading_mode::normal)
+				{
+					framebuffer[p.pixel] += p.weight * (0.5 * color(rec.normal.x() + 1, rec.normal.y() + 1, rec.normal.z() + 1));
+					continue;
+				}
+
+				// shade_hit() 의 난반사와 같음. 남은 반사 횟수가 0 이 되는 경로는 검은색이므로 더하지 않고 버림.
+				TRACE_COUNT(bounces, 1);
+				if (p.depth - 1 <= 0) continue;
+				vec3 direction = rec.normal + random_unit_vector();
+				rays[alive] = ray(rec.p, direction, rays[k].time());
+				paths[alive] = { p.pixel, p.depth - 1, color(0.5, 0.5, 0.5) * p.weight };
+				++alive;
+			}
+
+			rays.resize(alive);
+			paths.resize(alive);
+		}
+	}
+
+	for (auto& pixel : framebuffer) pixel = pixel / spp;
+}
+
+#endif // !INTERLEAVED_H
+
+/*
+	장면 단위 인터리빙 렌더링
+
+
+	triangle_mesh::hit_interleaved() 는 메쉬 하나의 BVH 안에서만 반직선들을 번갈아 순회하므로,
+	씬의 다른 물체들과 함께 render() 로 렌더링할 때는 사용되지 않음. (hittable::hit() 는 반직선 하나씩만 받음.)
+
+	render_interleaved() 는 씬 전체를 scene_hierarchy 로 펼쳐서, 장면 계층(bvh_node, hittable_list)과
+	그 안의 메쉬 BVH 를 하나의 상태 기계로 이어서 순회함.
+	반직선 하나를 끝까지 따라가는 재귀(ray_color()) 대신, 같은 깊이의 반직선들을 묶음으로 모아서 추적하고(wavefront),
+	셰이딩 결과로 나온 다음 반직선들을 다시 모아서 추적함.
+
+	인터리빙은 반직선들이 서로 다른 노드를 읽어서 캐시 미스가 잦을 때만 이득이 있음.
+	--interleave-bench 에서 무작위 반직선으로 큰 메쉬(약 460 MiB)를 순회하면 1.3 ~ 1.4배 빨라지지만,
+	400 x 225 프레임을 렌더링하면 이웃한 픽셀의 반직선들이 같은 노드를 읽어서 대부분 캐시에 맞기 때문에,
+	큰 메쉬가 들어있는 씬에서도 상태를 저장하고 바꾸는 비용과 묶음 처리 비용만큼 render() 보다 느림. (노멀 0.7배, 난반사 0.8 ~ 0.85배)
+	그래서 기본 렌더링은 그대로 render() 를 사용하고, 반직선이 흩어지는 씬에서 --interleave [N] 으로 골라서 사용함.
+
+	아직은 스레드 하나로 렌더링하고 보조 버퍼(디노이저)를 채우지 않음.
+*/
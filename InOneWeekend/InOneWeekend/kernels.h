@@ -0,0 +1,304 @@
+#ifndef KERNELS_H
+#define KERNELS_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "camera.h"
+#include "color.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include "renderer.h" // shading_mode, render_settings 를 사용하기 위해 포함
+#include "sphere.h"
+#include "trace_stats.h"
+
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// 특수화된 커널에서 구체 교차 검사에 사용할 부동소수점 정밀도
+enum class kernel_precision
+{
+	f64, // double (일반 렌더링 경로와 동일한 결과)
+	f32 // float (결과가 약간 달라질 수 있음)
+};
+
+// 씬의 구체들을 구조체 배열(SoA, Structure of Arrays) 형태로 펼쳐서 저장하는 클래스
+/*
+	hittable_list 는 shared_ptr<hittable> 들을 순회하면서
+	구체마다 가상 함수 hit() 를 호출해야 하므로,
+	포인터를 따라가는 메모리 접근과 가상 함수 호출 비용이 매번 발생함.
+
+	씬이 구체로만 이루어져 있다면, 중점 좌표와 반지름을 각각의 연속된 배열에 모아두고
+	하나의 반복문 안에서 모두 검사하는 것이 훨씬 빠름.
+
+	T 는 교차 검사에 사용할 부동소수점 타입(double 또는 float)임.
+*/
+template <typename T>
+class sphere_soa
+{
+public:
+	std::vector<T> cx, cy, cz, radius;
+	std::vector<T> vx, vy, vz; // 움직이는 구체의 시각 time0 ~ time1 동안의 이동 벡터 (정지한 구체는 0)
+	std::vector<T> time0, inv_duration; // 움직이기 시작하는 시각, 1 / (time1 - time0)
+
+	// hittable_list 안의 물체들이 모두 sphere 일 때만 펼쳐서 저장하고 true 를 반환함.
+	bool flatten(const hittable_list& list)
+	{
+		cx.clear(); cy.clear(); cz.clear(); radius.clear();
+		vx.clear(); vy.clear(); vz.clear();
+		time0.clear(); inv_duration.clear();
+		for (const auto& object : list.objects())
+		{
+			// dynamic_cast 는 실제 객체의 타입이 sphere 가 아니면 nullptr 을 반환함.
+			const sphere* s = dynamic_cast<const sphere*>(object.get());
+			if (!s) return false;
+
+			point3 c = s->get_center();
+			cx.push_back(static_cast<T>(c.x()));
+			cy.push_back(static_cast<T>(c.y()));
+			cz.push_back(static_cast<T>(c.z()));
+			radius.push_back(static_cast<T>(s->get_radius()));
+
+			vec3 v = s->get_velocity();
+			vx.push_back(static_cast<T>(v.x()));
+			vy.push_back(static_cast<T>(v.y()));
+			vz.push_back(static_cast<T>(v.z()));
+			time0.push_back(static_cast<T>(s->get_time0()));
+			inv_duration.push_back(static_cast<T>(s->get_inv_duration()));
+		}
+		return true;
+	}
+
+	// hittable_list::hit() + sphere::hit() 와 같은 계산을 가상 함수 호출 없이 수행함.
+	bool hit(const ray& r, double ray_tmin, double ray_tmax, hit_record& rec) const
+	{
+		const T ox = static_cast<T>(r.origin().x()), oy = static_cast<T>(r.origin().y()), oz = static_cast<T>(r.origin().z());
+		const T dx = static_cast<T>(r.direction().x()), dy = static_cast<T>(r.direction().y()), dz = static_cast<T>(r.direction().z());
+		const T a = dx * dx + dy * dy + dz * dz;
+#if RT_FAST_MATH
+		const T inv_a = static_cast<T>(1) / a; // 반직선마다 한 번만 나누고, 구체마다 두 번씩 하던 나눗셈은 곱셈으로 바꿈. (fast_math.h 참고)
+#endif
+		const T tmin = static_cast<T>(ray_tmin);
+		const T time = static_cast<T>(r.time());
+
+		T closest_so_far = static_cast<T>(ray_tmax);
+		TRACE_COUNT(primitive_tests, radius.size());
+		int closest = -1;
+
+		for (size_t k = 0; k < radius.size(); ++k)
+		{
+			// 반직선이 쏘아진 시각의 중점 (정지한 구체는 이동 벡터가 0 이므로 그대로 중점이 됨.)
+			const T f = sphere::motion_fraction(time, time0[k], inv_duration[k]);
+			const T ocx = ox - (cx[k] + f * vx[k]), ocy = oy - (cy[k] + f * vy[k]), ocz = oz - (cz[k] + f * vz[k]);
+			const T half_b = ocx * dx + ocy * dy + ocz * dz;
+			const T c = (ocx * ocx + ocy * ocy + ocz * ocz) - radius[k] * radius[k];
+			const T discriminant = half_b * half_b - a * c;
+			if (discriminant < 0) continue;
+
+			const T sqrtd = std::sqrt(discriminant);
+#if RT_FAST_MATH
+			T root = (-half_b - sqrtd) * inv_a;
+			if (root <= tmin || closest_so_far <= root)
+			{
+				root = (-half_b + sqrtd) * inv_a;
+#else
+			T root = (-half_b - sqrtd) / a;
+			if (root <= tmin || closest_so_far <= root)
+			{
+				root = (-half_b + sqrtd) / a;
+#endif
+				if (root <= tmin || closest_so_far <= root) continue;
+			}
+
+			closest_so_far = root;
+			closest = static_cast<int>(k);
+		}
+
+		if (closest < 0) return false;
+
+		// 노멀도 교차 검사와 같이 셔터 구간 안으로 맞춘 시각의 중점에서 계산해야 길이가 1 이 됨.
+		const T f = sphere::motion_fraction(time, time0[closest], inv_duration[closest]);
+		point3 center(cx[closest] + f * vx[closest], cy[closest] + f * vy[closest], cz[closest] + f * vz[closest]);
+		rec.t = closest_so_far;
+		rec.p = r.at(rec.t);
+		rec.normal = (rec.p - center) / static_cast<double>(radius[closest]);
+		rec.object_id = closest;
+		return true;
+	}
+};
+
+// 셰이딩 방식을 템플릿 매개변수로 고정한 ray_color() (renderer.h 의 ray_color() 와 같은 계산)
+/*
+	Shading 이 컴파일 타임 상수이기 때문에, 컴파일러는 사용하지 않는 셰이딩 분기를 통째로 제거할 수 있음.
+	World 역시 템플릿 매개변수이므로 sphere_soa 를 넘기면 hit() 호출이 인라인됨.
+*/
+template <shading_mode Shading, typename World>
+inline color kernel_ray_color(const ray& r, int depth, const World& world, const sky_gradient& sky)
+{
+	if (depth <= 0) return color(0, 0, 0);
+
+	hit_record rec;
+	if (world.hit(r, 0.001, infinity, rec))
+	{
+		if (Shading == shading_mode::normal)
+			return 0.5 * color(rec.normal.x() + 1, rec.normal.y() + 1, rec.normal.z() + 1);
+
+		TRACE_COUNT(bounces, 1);
+		vec3 direction = rec.normal + random_unit_vector();
+		return color(0.5, 0.5, 0.5) * kernel_ray_color<Shading>(ray(rec.p, direction, r.time()), depth - 1, world, sky);
+	}
+
+	return sky.at(r);
+}
+
+// 셰이딩 방식, 픽셀 당 샘플 수, 씬 타입을 템플릿 매개변수로 고정한 렌더링 커널
+/*
+	Spp 가 0 이 아니면 샘플 반복문의 횟수가 컴파일 타임 상수가 되어 언롤링이 가능하고,
+	Spp 가 1 이면 반복문 없이 픽셀 중점으로 반직선 하나만 쏘도록 컴파일됨.
+	Spp 가 0 이면 런타임 값 spp 를 사용하는 범용 버전임.
+*/
+template <shading_mode Shading, int Spp, typename World>
+inline void kernel_render_region(const camera& cam, const World& world, int spp, int max_depth, const sky_gradient& sky,
+								 std::vector<color>& framebuffer, int x0, int y0, int x1, int y1)
+{
+	const int samples = (Spp > 0) ? Spp : spp;
+	const double scale = 1.0 / samples;
+
+	for (int j = y0; j < y1; ++j)
+	{
+		for (int i = x0; i < x1; ++i)
+		{
+			color pixel_color(0, 0, 0);
+			if (Spp == 1)
+			{
+				pixel_color = kernel_ray_color<Shading>(cam.get_ray(i, j), max_depth, world, sky);
+			}
+			else
+			{
+				for (int s = 0; s < samples; ++s)
+					pixel_color += kernel_ray_color<Shading>(cam.get_sample_ray(i, j, s, samples), max_depth, world, sky);
+			}
+
+			framebuffer[static_cast<size_t>(j) * cam.image_width + i] = scale * pixel_color;
+		}
+	}
+}
+
+// 런타임 설정값에 맞는 특수화된 커널을 골라서 실행하는 디스패처 클래스 (하단 필기 '커널 특수화와 디스패치' 참고)
+class specialized_renderer
+{
+public:
+	specialized_renderer(const hittable_list& world, const render_settings& _settings, kernel_precision precision)
+		: generic_world(&world), settings(_settings)
+	{
+		// 씬이 구체로만 이루어져 있으면 SoA 배열로 펼친 씬을 사용하고, 아니면 hittable_list 를 그대로 사용함.
+		if (precision == kernel_precision::f32 && spheres32.flatten(world))
+		{
+			kernel = pick_shading<sphere_soa<float>>();
+			label = "spheres/f32";
+		}
+		else if (spheres64.flatten(world))
+		{
+			kernel = pick_shading<sphere_soa<double>>();
+			label = "spheres/f64";
+		}
+		else
+		{
+			kernel = pick_shading<hittable_list>();
+			label = "generic";
+		}
+
+		label += (settings.shading == shading_mode::normal) ? "/normal" : "/diffuse";
+		label += "/spp" + (is_spp_bucket(settings.samples_per_pixel) ? std::to_string(settings.samples_per_pixel) : std::string("N"));
+	}
+
+	// 어떤 특수화가 선택되었는지 나타내는 이름 (예: spheres/f64/normal/spp1)
+	const std::string& name() const { return label; }
+
+	void render_region(const camera& cam, std::vector<color>& framebuffer, int x0, int y0, int x1, int y1) const
+	{
+		kernel(*this, cam, framebuffer, x0, y0, x1, y1);
+	}
+
+private:
+	using kernel_fn = void (*)(const specialized_renderer&, const camera&, std::vector<color>&, int, int, int, int);
+
+	const hittable_list* generic_world;
+	sphere_soa<double> spheres64;
+	sphere_soa<float> spheres32;
+	render_settings settings;
+	kernel_fn kernel = nullptr;
+	std::string label;
+
+	// 미리 컴파일해 둘 픽셀 당 샘플 수 목록
+	static bool is_spp_bucket(int spp) { return spp == 1 || spp == 4 || spp == 16 || spp == 64; }
+
+	// 템플릿 매개변수 World 에 맞는 씬 객체를 반환하는 오버로딩 함수들
+	const hittable_list& world_of(const hittable_list*) const { return *generic_world; }
+	const sphere_soa<double>& world_of(const sphere_soa<double>*) const { return spheres64; }
+	const sphere_soa<float>& world_of(const sphere_soa<float>*) const { return spheres32; }
+
+	template <shading_mode Shading, int Spp, typename World>
+	static void invoke(const specialized_renderer& self, const camera& cam, std::vector<color>& framebuffer, int x0, int y0, int x1, int y1)
+	{
+		kernel_render_region<Shading, Spp>(cam, self.world_of(static_cast<const World*>(nullptr)),
+										   self.settings.samples_per_pixel, self.settings.max_depth, self.settings.sky, framebuffer, x0, y0, x1, y1);
+	}
+
+	template <shading_mode Shading, typename World>
+	kernel_fn pick_spp() const
+	{
+		switch (settings.samples_per_pixel)
+		{
+		case 1: return &invoke<Shading, 1, World>;
+		case 4: return &invoke<Shading, 4, World>;
+		case 16: return &invoke<Shading, 16, World>;
+		case 64: return &invoke<Shading, 64, World>;
+		default: return &invoke<Shading, 0, World>;
+		}
+	}
+
+	template <typename World>
+	kernel_fn pick_shading() const
+	{
+		return (settings.shading == shading_mode::normal) ? pick_spp<shading_mode::normal, World>() : pick_spp<shading_mode::diffuse, World>();
+	}
+};
+
+// renderer.h 의 render() 와 같은 역할이지만, 특수화된 커널로 렌더링함. (보조 버퍼는 지원하지 않음)
+inline void render_specialized(const camera& cam, const specialized_renderer& kernel, std::vector<color>& framebuffer, bool show_progress)
+{
+	framebuffer.assign(static_cast<size_t>(cam.image_width) * cam.image_height, color(0, 0, 0));
+
+	for (int j = 0; j < cam.image_height; ++j)
+	{
+		if (show_progress) std::clog << "\rScanlines remaining: " << (cam.image_height - j) << ' ' << std::flush;
+		kernel.render_region(cam, framebuffer, 0, j, cam.image_width, j + 1);
+	}
+}
+
+#endif // !KERNELS_H
+
+/*
+	커널 특수화와 디스패치
+
+
+	renderer.h 의 render_region() 은 샘플 수, 셰이딩 방식을 런타임 값으로 받고,
+	씬은 hittable 의 가상 함수를 통해 검사하기 때문에,
+	가장 안쪽 반복문에서도 매번 분기와 가상 함수 호출이 일어남.
+
+	kernel_render_region() 은 이 값들을 템플릿 매개변수로 받기 때문에,
+	템플릿 인자 조합마다 분기가 제거된 별도의 함수가 컴파일됨.
+
+	하지만 템플릿 인자는 컴파일 타임에 결정되어야 하므로,
+	실행 중에 정해지는 설정값으로 바로 호출할 수는 없음.
+
+	그래서 specialized_renderer 생성자에서 런타임 설정값을 switch 문으로 한 번만 검사해서
+	미리 컴파일해 둔 특수화 함수들 중 하나의 포인터를 골라두고,
+	렌더링할 때는 그 함수 포인터만 호출하는 것임.
+
+	샘플 수는 모든 값을 특수화할 수 없으므로 1, 4, 16, 64 만 미리 컴파일하고,
+	나머지 값은 Spp = 0 (런타임 샘플 수) 버전을 사용함.
+*/
@@ -1,8 +1,43 @@
+#include "rtweekend.h"
+
+#include "batch.h"
+#include "bvh.h"
+#include "camera.h"
 #include "color.h"
+#include "denoiser.h"
+#include "fast_math.h"
+#include "heatmap.h"
+#include "hit_cache.h"
+#include "hittable.h"
+#include "hittable_list.h"
+#include "interleaved.h"
+#include "kernels.h"
+#include "mesh_io.h"
+#include "numa.h"
+#include "out_of_core.h"
+#include "postprocess.h"
+#include "preview_server.h"
 #include "ray.h"
+#include "renderer.h"
+#include "sphere.h"
+#include "spectral.h"
+#include "sphere_cloud.h"
+#include "triangle_mesh.h"
 #include "vec3.h"
 
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
 
 // 주어진 구체에 대하여 주어진 반직선이 교차하는지 확인하는 함수
 /*
@@ -122,160 +157,1270 @@ double hit_sphere(const point3& center, double radius, const ray& r)
 	}
 }
 
-// 주어진 반직선(ray)에 대한 특정 색상을 반환하는 함수
-color ray_color(const ray& r)
+// 디노이저의 time-to-quality 측정
+/*
+	기준 이미지(reference)를 샘플 수의 4배로 렌더링해 둔 뒤,
+
+	1. 원래 샘플 수로 렌더링한 이미지
+	2. 1/8 샘플 수로 렌더링한 이미지
+	3. 1/8 샘플 수로 렌더링한 뒤 디노이저를 적용한 이미지
+
+	각각의 소요 시간과 기준 이미지와의 RMSE 를 std::clog 로 출력함.
+*/
+void denoise_benchmark(const camera& cam, const hittable& world, render_settings settings)
 {
-	// 중점이 (0, 0, -1) 이고, 반지름이 0.5 인 구체와 반직선이 맨 처음으로 교차하는 지점의 반직선 상의 비율값 t 를 반환
-	auto t = hit_sphere(point3(0, 0, -1), 0.5, r);
-	
-	// 비율값 t 가 0보다 큰 경우에만, 
-	// 즉, 구체와 반직선 상의 첫 번째 교차점에 대한 
-	// 반직선 상의 비율값 t 를 반환받은 경우에만 아래 로직을 처리
-	if (t > 0.0)
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
+
+	int full_spp = std::max(settings.samples_per_pixel, 8);
+	std::vector<color> reference, full, low;
+	aux_buffers aux;
+
+	settings.samples_per_pixel = full_spp * 4;
+	render(cam, world, settings, reference, nullptr, false);
+
+	settings.samples_per_pixel = full_spp;
+	auto start = clock::now();
+	render(cam, world, settings, full, nullptr, false);
+	double full_time = seconds(start);
+
+	settings.samples_per_pixel = full_spp / 8;
+	start = clock::now();
+	render(cam, world, settings, low, &aux, false);
+	double low_time = seconds(start);
+	double low_rmse = image_rmse(low, reference);
+
+	start = clock::now();
+	denoise(low, aux, denoise_options());
+	double denoise_time = seconds(start);
+
+	std::clog << "full    (spp " << full_spp << "): " << full_time << " s, rmse " << image_rmse(full, reference) << '\n'
+			  << "low     (spp " << full_spp / 8 << "): " << low_time << " s, rmse " << low_rmse << '\n'
+			  << "denoise (spp " << full_spp / 8 << "): " << low_time + denoise_time << " s (filter " << denoise_time
+			  << " s), rmse " << image_rmse(low, reference) << '\n';
+}
+
+// 특수화된 커널과 범용 렌더링 경로의 속도 비교
+/*
+	셰이딩 방식, 샘플 수, 정밀도 조합마다 같은 이미지를
+	renderer.h 의 render() 와 kernels.h 의 render_specialized() 로 각각 렌더링해서
+	소요 시간과 속도 향상 비율을 std::clog 로 출력함.
+*/
+void kernel_benchmark(const camera& cam, const hittable_list& world, int max_depth)
+{
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
+
+	std::vector<color> framebuffer;
+	for (shading_mode shading : { shading_mode::normal, shading_mode::diffuse })
 	{
-		/*
-			구체의 표면 상의 교차점의 노멀벡터 계산하기
+		for (int spp : { 1, 4, 16, 10 })
+		{
+			render_settings settings;
+			settings.shading = shading;
+			settings.samples_per_pixel = spp;
+			settings.max_depth = max_depth;
+
+			auto start = clock::now();
+			render(cam, world, settings, framebuffer, nullptr, false);
+			double generic_time = seconds(start);
+
+			for (kernel_precision precision : { kernel_precision::f64, kernel_precision::f32 })
+			{
+				specialized_renderer kernel(world, settings, precision);
+				start = clock::now();
+				render_specialized(cam, kernel, framebuffer, false);
+				double kernel_time = seconds(start);
+
+				std::clog << kernel.name() << " (spp " << spp << "): generic " << generic_time * 1e3 << " ms, specialized "
+						  << kernel_time * 1e3 << " ms, speedup " << generic_time / kernel_time << "x\n";
+			}
+		}
+	}
+}
 
-			(구체의 표면에 존재하는 구체와 반직선 교차점 - 구체의 중점) 
-			으로 계산한 벡터를 단위벡터로 정규화하면, 
+// 삼각형 메쉬의 로딩 시간, 메모리 사용량, 교차 검사 속도 측정
+/*
+	path 가 비어있으면 파일 대신 약 200만 개의 삼각형으로 이루어진 구체 메쉬를 생성해서 측정함.
 
-			이는 결국 해당 표면 지점의 노멀벡터(= 표면 방향벡터)와 같음.
+	교차 검사 속도는 메쉬의 경계 상자 바깥에서 경계 상자 안쪽의 임의의 점을 향해 쏜 반직선들로 측정하고,
+	한 스레드 기준의 초당 반직선 수(rays/s)를 std::clog 로 출력함.
+*/
+void mesh_benchmark(const std::string& path)
+{
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
 
-			이처럼 구체의 기하학적 성질을 활용해서
-			square root(제곱근 계산)을 사용하지 않고서도
-			구체 표면의 정규화된 노멀벡터를 쉽게 계산할 수 있음! 
-		*/
-		vec3 N = unit_vector(r.at(t) - vec3(0, 0, -1));
+	triangle_mesh mesh;
+	auto start = clock::now();
+	if (path.empty()) make_uv_sphere_mesh(mesh, point3(0, 0, 0), 1.0, 1000, 1000);
+	else if (!load_mesh(path, mesh)) return;
+	double load_time = seconds(start); // build() 까지 포함된 시간
 
-		/*
-			구체 표면의 노멀벡터 N 의 컴포넌트들은 
-			-1 ~ 1 범위 사이에 존재하므로,
-			
-			이 값을 0 ~ 1 범위 사이로 맵핑시키고,
-			맵핑된 각각의 x, y, z 값을 r, g, b 색상값으로 사용함
+	aabb box = mesh.bounding_box();
+	if (box.empty())
+	{
+		std::clog << "Mesh has no triangles.\n";
+		return;
+	}
 
-			-> 구체 표면의 노멀벡터를 색상으로 시각화한 것!
-		*/
-		return 0.5 * color(N.x() + 1, N.y() + 1, N.z() + 1);
+	const point3 center = box.centroid();
+	const double extent = (box.maximum - box.minimum).length();
+	const int ray_count = 1000000;
+	int hits = 0;
+
+	start = clock::now();
+	for (int k = 0; k < ray_count; ++k)
+	{
+		point3 origin = center + extent * random_unit_vector();
+		point3 target(random_double(box.minimum.x(), box.maximum.x()), random_double(box.minimum.y(), box.maximum.y()),
+					  random_double(box.minimum.z(), box.maximum.z()));
+		hit_record rec;
+		if (mesh.hit(ray(origin, target - origin), 0.001, infinity, rec)) ++hits;
 	}
+	double trace_time = seconds(start);
 
+	std::clog << "triangles: " << mesh.triangle_count() << ", vertices: " << mesh.vertex_count() << '\n'
+			  << "load + build: " << load_time << " s\n"
+			  << "memory: " << mesh.memory_bytes() / (1024.0 * 1024.0) << " MiB (" << double(mesh.memory_bytes()) / mesh.triangle_count() << " bytes/triangle)\n"
+			  << "rays: " << ray_count << ", hits: " << hits << ", " << ray_count / trace_time << " rays/s (1 thread)\n";
+}
 
-	// 반직선을 길이가 1인 단위벡터로 정규화한 뒤,
-	// 정규화된 단위벡터의 y값에 따라 색상을 혼합하여 수직방향 그라디언트를 적용해 봄.
-	vec3 unit_direction = unit_vector(r.direction()); // vec3.h 에 정의된 벡터 정규화 유틸 함수 사용
-	auto a = 0.5 * (unit_direction.y() + 1.0); // -1 ~ 1 사이의 정규화된 단위벡터 y 값 범위를 0 ~ 1 사이로 맵핑함.
-	
-	// linear interpolation(선형보간)으로 흰색과 파란색을 0 ~ 1 사이로 맵핑된 a값에 따라 혼합하여 최종 색상 반환
-	return (1.0 - a) * color(1.0, 1.0, 1.0) + a * color(0.5, 0.7, 1.0);
+// 반직선 인터리빙의 속도 측정 (triangle_mesh.h 하단 필기 '반직선 인터리빙' 참고)
+/*
+	캐시 안에 들어가는 작은 구체 메쉬와, 약 800만 개의 삼각형(약 460 MiB)으로 이루어진 캐시보다 큰 구체 메쉬에 대해
+	mesh_benchmark() 와 같은 방식의 무작위 반직선들을 hit() 로 하나씩 추적한 경우와
+	hit_interleaved() 로 group_size 개씩 번갈아 추적한 경우의 초당 반직선 수를 std::clog 로 출력함.
+
+	이어서 같은 메쉬를 다른 물체들과 함께 bvh_node 로 묶은 씬을 render() 와 render_interleaved() 로 렌더링해서 (interleaved.h 참고)
+	노멀 셰이딩 이미지가 같은지 확인하고, 노멀 / 난반사 셰이딩의 소요 시간을 비교함.
+
+	모든 결과가 hit() / render() 와 같으면 true 를 반환함.
+*/
+bool interleave_benchmark()
+{
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
+
+	struct mesh_config { const char* name; int rings; int ray_count; };
+	const mesh_config meshes[] = { { "small mesh", 40, 1000000 }, { "large mesh", 2000, 1000000 } };
+	const int group_sizes[] = { 1, 4, 8, 16, 32, 64 };
+
+	bool identical = true;
+	for (const mesh_config& m : meshes)
+	{
+		auto mesh_object = make_shared<triangle_mesh>();
+		triangle_mesh& mesh = *mesh_object;
+		make_uv_sphere_mesh(mesh, point3(0, 0, 0), 1.0, m.rings, m.rings);
+
+		// 렌더링에 쓰는 난수 생성기의 상태를 바꾸지 않도록 별도의 생성기로 반직선을 만듦.
+		std::mt19937 generator(1234);
+		std::uniform_real_distribution<double> uniform(0.0, 1.0);
+		const aabb box = mesh.bounding_box();
+		const point3 center = box.centroid();
+		const double extent = (box.maximum - box.minimum).length();
+
+		std::vector<ray> rays;
+		rays.reserve(m.ray_count);
+		for (int k = 0; k < m.ray_count; ++k)
+		{
+			const vec3 d(uniform(generator) - 0.5, uniform(generator) - 0.5, uniform(generator) - 0.5);
+			const point3 origin = center + extent * unit_vector(d);
+			const point3 target(box.minimum.x() + uniform(generator) * (box.maximum.x() - box.minimum.x()),
+								box.minimum.y() + uniform(generator) * (box.maximum.y() - box.minimum.y()),
+								box.minimum.z() + uniform(generator) * (box.maximum.z() - box.minimum.z()));
+			rays.push_back(ray(origin, target - origin));
+		}
+
+		std::clog << m.name << ": " << mesh.triangle_count() << " triangles, " << mesh.memory_bytes() / (1024.0 * 1024.0) << " MiB\n";
+
+		std::vector<hit_record> reference(rays.size()), recs(rays.size());
+		std::unique_ptr<bool[]> reference_hits(new bool[rays.size()]), hits(new bool[rays.size()]);
+
+		auto start = clock::now();
+		for (size_t k = 0; k < rays.size(); ++k) reference_hits[k] = mesh.hit(rays[k], 0.001, infinity, reference[k]);
+		const double single_time = seconds(start);
+		std::clog << "  hit()             : " << rays.size() / single_time / 1e6 << " Mrays/s\n";
+
+		for (int group_size : group_sizes)
+		{
+			start = clock::now();
+			mesh.hit_interleaved(rays.data(), rays.size(), 0.001, infinity, recs.data(), hits.get(), group_size);
+			const double time = seconds(start);
+
+			size_t mismatches = 0;
+			for (size_t k = 0; k < rays.size(); ++k)
+			{
+				if (hits[k] != reference_hits[k] || (hits[k] && (recs[k].t != reference[k].t || recs[k].normal.x() != reference[k].normal.x()
+																	|| recs[k].normal.y() != reference[k].normal.y() || recs[k].normal.z() != reference[k].normal.z())))
+					++mismatches;
+			}
+			identical = identical && mismatches == 0;
+
+			std::clog << "  interleaved x " << std::setw(2) << group_size << " : " << rays.size() / time / 1e6 << " Mrays/s ("
+					  << single_time / time << "x), mismatches " << mismatches << '\n';
+		}
+
+		// 씬 단위: 메쉬 + 구체들을 bvh_node 로 묶은 씬
+		hittable_list objects;
+		objects.add(mesh_object);
+		objects.add(make_shared<sphere>(point3(-2.2, 0, -0.5), 0.8));
+		objects.add(make_shared<sphere>(point3(2.2, 0, -0.5), 0.8));
+		objects.add(make_shared<sphere>(point3(0, -101, 0), 100));
+		const bvh_node world(objects);
+
+		camera cam;
+		cam.aspect_ratio = 16.0 / 9.0;
+		cam.image_width = 400;
+		cam.center = point3(0, 0, 3.5);
+		cam.initialize();
+
+		const shading_mode shadings[] = { shading_mode::normal, shading_mode::diffuse };
+		for (shading_mode shading : shadings)
+		{
+			render_settings settings;
+			settings.shading = shading;
+			settings.max_depth = 4;
+
+			std::vector<color> reference_frame, frame;
+			start = clock::now();
+			render(cam, world, settings, reference_frame, nullptr, false);
+			const double render_time = seconds(start);
+			std::clog << "  frame (" << (shading == shading_mode::normal ? "normal" : "diffuse") << "), render()          : " << render_time << " s\n";
+
+			for (int group_size : group_sizes)
+			{
+				interleave_options options;
+				options.group_size = group_size;
+				start = clock::now();
+				render_interleaved(cam, world, settings, options, frame, false);
+				const double time = seconds(start);
+
+				std::clog << "  frame (" << (shading == shading_mode::normal ? "normal" : "diffuse") << "), interleaved x " << std::setw(2) << group_size
+						  << " : " << time << " s (" << render_time / time << "x)";
+				if (shading == shading_mode::normal)
+				{
+					// 노멀 셰이딩은 난수를 쓰지 않으므로 픽셀 값이 render() 와 비트 단위로 같아야 함.
+					size_t differing = 0;
+					for (size_t k = 0; k < frame.size(); ++k)
+						if (frame[k].x() != reference_frame[k].x() || frame[k].y() != reference_frame[k].y() || frame[k].z() != reference_frame[k].z()) ++differing;
+					identical = identical && differing == 0;
+					std::clog << ", " << differing << " pixels differ";
+				}
+				std::clog << '\n';
+			}
+		}
+	}
+	return identical;
 }
 
-int main()
+// 스펙트럴 렌더링의 비용과 오차 측정 (spectral.h 참고)
+/*
+	난반사 셰이딩으로 같은 샘플 수에서
+
+	1. RGB 렌더링 (render())
+	2. hero wavelength 스펙트럴 렌더링 (반직선 하나에 파장 4개)
+	3. 파장마다 반직선을 따로 쏘는 스펙트럴 렌더링 (같은 파장 4개를 얻는 데 반직선 4개)
+
+	의 소요 시간을 비교하고, 샘플 수를 16배로 늘린 hero wavelength 렌더링을 기준으로 한 RMSE 를 std::clog 로 출력함.
+	(RGB 의 RMSE 에는 잡음과 함께 RGB -> 스펙트럼 -> RGB 변환에서 생기는 색 차이도 포함됨.)
+*/
+void spectral_benchmark(const camera& cam, const hittable& world, render_settings settings)
 {
-	// Image
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
+
+	settings.shading = shading_mode::diffuse;
+	const int spp = std::max(settings.samples_per_pixel, 4);
+
+	std::vector<color> reference, framebuffer;
+	settings.samples_per_pixel = spp * 16;
+	auto start = clock::now();
+	render_spectral(cam, world, settings, spectral_sampling::hero, reference, false);
+	std::clog << "reference (hero, " << settings.samples_per_pixel << " spp): " << seconds(start) * 1e3 << " ms\n";
+
+	settings.samples_per_pixel = spp;
+	start = clock::now();
+	render(cam, world, settings, framebuffer, nullptr, false);
+	const double rgb_time = seconds(start);
+	std::clog << "rgb            (" << spp << " spp): " << rgb_time * 1e3 << " ms, rmse " << image_rmse(framebuffer, reference) << '\n';
+
+	const spectral_sampling modes[] = { spectral_sampling::hero, spectral_sampling::per_wavelength };
+	for (spectral_sampling mode : modes)
+	{
+		start = clock::now();
+		render_spectral(cam, world, settings, mode, framebuffer, false);
+		const double time = seconds(start);
+		std::clog << (mode == spectral_sampling::hero ? "hero x 4       (" : "4 rays x 1     (") << spp << " spp): " << time * 1e3 << " ms ("
+				  << time / rgb_time << "x rgb), rmse " << image_rmse(framebuffer, reference) << '\n';
+	}
+}
 
-	// 이미지(.ppm 파일)의 rows 와 column(너비와 높이 해상도) 정의
-	/*
-		우선 이미지 사이즈는 rows 와 columns 개수를 정의하다보니
-		반드시 정수형으로 떨어져야 한다는 전제조건이 있음.
+// 1차 충돌 캐시를 사용한 룩뎁(look-dev) 반복 렌더링의 속도 측정
+/*
+	하늘 색상만 바꿔가며 같은 씬을 여러 번 렌더링하면서,
+	매번 교차 검사를 하는 render() 와 1차 충돌 캐시를 사용하는 render_cached() 의 소요 시간을 비교함.
+	마지막에는 씬에 물체를 추가해서 캐시가 자동으로 무효화되는지도 확인함.
+*/
+void lookdev_benchmark(const camera& cam, hittable_list& world, render_settings settings)
+{
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
 
-		또한, 이미지의 aspect_ratio 를 16:9 로 설정했더라도,
-		두 가지 이유에 의해 정확히 16:9 로 비율이 딱 떨어지진 않음.
+	primary_hit_cache cache;
+	std::vector<color> uncached, cached;
 
-		1. 우선 이미지 너비를 aspect_ratio 와 곱한 결과를 
-		int 타입으로 형변환하므로(이미지 사이즈가 정수형이어야 한다고 했었지?), 
-		가장 가까운 정수형으로 소수점이 버림되어서 
-		정확한 aspect_ratio 에 딱 맞는 height 을 계산할 수 없음.
+	auto start = clock::now();
+	render_cached(cam, world, settings, cache, cached, nullptr, false);
+	std::clog << "cache build: " << seconds(start) * 1e3 << " ms, " << cache.memory_bytes() / (1024.0 * 1024.0) << " MiB\n";
 
-		2. 심지어 1번 처럼 계산한 image_height 이 1보다 작아지면
-		무조건 1로 덮어쓰기 때문에, 16:9 비율로 딱 떨어지게 계산될 수 없음.
+	const int iterations = 8;
+	double uncached_time = 0, cached_time = 0, max_rmse = 0;
+	for (int k = 0; k < iterations; ++k)
+	{
+		// 셰이딩 값(하늘 색상)만 바꿈.
+		double s = static_cast<double>(k) / iterations;
+		settings.sky.top = color(0.5 - 0.3 * s, 0.7, 1.0 - 0.5 * s);
+		settings.sky.bottom = color(1.0, 1.0 - 0.4 * s, 1.0 - 0.6 * s);
 
-		aspect_ratio 로 설정한 이미지의 종횡비는
-		어디까지나 이상적인 값이며, 실제 이미지 크기는
-		여기에 근사된 수치로 정해진다.
-	*/
-	auto aspect_ratio = 16.0 / 9.0; // 이미지의 종횡비를 16:9 로 설정 
-	int image_width = 400; // 이미지 너비는 상수이며, 이미지 너비 값에 따라 이미지 높이 값이 종횡비와 곱해져서 계산됨.
-	int image_height = static_cast<int>(image_width / aspect_ratio); // 이미지 높이는 정수형이므로, 너비와 종횡비를 곱한 실수값을 정수형으로 형변환함.
-	image_height = (image_height < 1) ? 1 : image_height; // 이미지 너비는 항상 1보다는 크도록 함.
+		start = clock::now();
+		render(cam, world, settings, uncached, nullptr, false);
+		uncached_time += seconds(start);
 
+		start = clock::now();
+		bool reused = render_cached(cam, world, settings, cache, cached, nullptr, false);
+		cached_time += seconds(start);
 
-	// Camera
+		if (!reused) std::clog << "unexpected cache rebuild at iteration " << k << '\n';
+		max_rmse = std::max(max_rmse, image_rmse(cached, uncached));
+	}
 
-	auto focal_length = 1.0; // 카메라 중점(eye point)과 viewport 사이의 거리 (현재는 단위 거리 1로 지정함.)
-	// 실제로 계산된 색상을 저장하는 이미지 외에도, 3D Scene 에 존재하는 가상의 viewport 사이즈도 정의해야 함.
-	/*
-		viewport
+	std::clog << "shading-only re-render x" << iterations << ": uncached " << uncached_time / iterations * 1e3 << " ms, cached "
+			  << cached_time / iterations * 1e3 << " ms, speedup " << uncached_time / cached_time << "x";
+	if (settings.shading == shading_mode::normal) std::clog << ", max rmse " << max_rmse; // diffuse 는 무작위 샘플이라 비교하지 않음.
+	std::clog << '\n';
 
-		카메라 지점(눈 지점)으로부터 ray 를 쏘면,
-		이 ray 가 가상의 viewport 에 일정 간격으로 정렬된 픽셀들을 통과시킴.
+	world.add(make_shared<sphere>(point3(1, 0, -1.5), 0.3));
+	std::clog << "after scene edit, cache reused: " << (render_cached(cam, world, settings, cache, cached, nullptr, false) ? "yes" : "no") << '\n';
+}
 
-		이러한 픽셀들이 grid 형태로 정렬되어 있는
-		3D Scene 안에 존재하는 가상의 직사각형을
-		'viewport' 라고 함.
+// 모션 블러와 여러 장의 서브프레임을 평균내는 방식의 비교
+/*
+	바닥 구체 위에 작은 구체들을 격자로 배치하고, 그 중 절반은 셔터가 열려있는 동안 위쪽으로 움직이게 한 씬에서
 
-		이때, viewport 의 가로 / 세로 종횡비는
-		이미지의 가로 / 세로 종횡비와 일치시켜야 함.
+	1. 셔터를 닫은 채로(시각 0) 렌더링한 정지 이미지
+	2. 반직선마다 무작위 시각을 부여한 모션 블러 이미지 (BVH 는 한 번만 생성)
+	3. 셔터 구간을 subframes 개의 시각으로 나눠서, 시각마다 구체들을 그 위치에 고정한 씬과 BVH 를 새로 만들어 렌더링한 뒤 평균낸 이미지
+	   (서브프레임마다 같은 샘플 수를 쓰는 경우와, 모션 블러와 전체 샘플 수가 같도록 나눠 쓰는 경우)
 
-		단, viewport 사이즈는 이미지처럼 rows, column 으로
-		사용되는 개념이 아니기 때문에, 반드시 정수형일 필요가 없어
-		실수형으로 계산할 것임.
-	*/
-	auto viewport_height = 2.0; // 이번엔 뷰포트 높이 먼저 정의
-	auto viewport_width = viewport_height * (static_cast<double>(image_width) / image_height); // aspect_ratio 는 실제 이미지 사이즈의 종횡비와 달라, 실제 이미지 크기로부터 종횡비를 다시 계산해서 적용함.
-	auto camera_center = point3(0, 0, 0); // 3D Scene 상에서 카메라 중점(eye point) > viewport 로 casting 되는 모든 ray 의 출발점이기도 함.
+	의 소요 시간과, 샘플 수를 8배로 늘린 모션 블러 기준 이미지와의 RMSE 를 std::clog 로 출력함.
 
+	그 전에 움직이는 구체들을 sphere::hit() (hittable_list) 와 특수화된 커널의 sphere_soa 로 각각 교차 검사해서,
+	이동 구간이 [0, 1] 이 아닌 구체와 이동 구간 밖의 시각을 가진 반직선에서도 충돌 지점과 노멀이 같은지 확인함.
+	모든 결과가 같으면 true 를 반환함.
+*/
+bool motion_blur_benchmark(camera cam, render_settings settings)
+{
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
+
+	// sphere::hit() 와 sphere_soa::hit() 의 결과 비교
+	hittable_list parity_scene;
+	parity_scene.add(make_shared<sphere>(point3(-1.5, 0, -2), point3(-1.5, 1, -2), 0.5, 0.0, 2.0));
+	parity_scene.add(make_shared<sphere>(point3(0, 0, -2), point3(0, 1, -2), 0.5));
+	parity_scene.add(make_shared<sphere>(point3(1.5, 0, -2), point3(1.5, -1, -2), 0.5, -1.0, 0.5));
+	sphere_soa<double> parity_soa;
+	parity_soa.flatten(parity_scene);
+
+	size_t parity_rays = 0, parity_mismatches = 0;
+	for (double time = -1.0; time <= 3.0; time += 0.25)
+	{
+		for (int k = 0; k < 64; ++k)
+		{
+			const ray r(point3(0, 0.5, 0), vec3(-2.0 + 4.0 * k / 63, -1.0 + 2.0 * ((k * 37) % 64) / 63, -2), time);
+			hit_record expected, actual;
+			const bool expected_hit = parity_scene.hit(r, 0.001, infinity, expected);
+			const bool actual_hit = parity_soa.hit(r, 0.001, infinity, actual);
+			++parity_rays;
+			if (expected_hit != actual_hit
+				|| (expected_hit && (std::fabs(expected.t - actual.t) > 1e-9 || (expected.normal - actual.normal).length() > 1e-9
+									 || std::fabs(actual.normal.length() - 1.0) > 1e-9)))
+				++parity_mismatches;
+		}
+	}
+	std::clog << (parity_mismatches == 0 ? "PASS" : "FAIL") << ": sphere_soa matches sphere::hit() on " << parity_rays - parity_mismatches
+			  << " / " << parity_rays << " rays (time -1 ~ 3)\n";
+
+	struct moving_sphere_desc
+	{
+		point3 center0, center1;
+		double radius;
+	};
+	std::vector<moving_sphere_desc> spheres;
+	for (int a = -10; a < 10; ++a)
+	{
+		for (int b = 0; b < 10; ++b)
+		{
+			point3 c(0.12 * a + 0.06, -0.4, -0.8 - 0.12 * b);
+			vec3 motion = ((a + b) % 2 == 0) ? vec3(0, random_double(0, 0.15), 0) : vec3(0, 0, 0);
+			spheres.push_back({ c, c + motion, 0.05 });
+		}
+	}
+
+	// 시각 time 에 구체들이 있는 위치에 고정된 정지 씬 (서브프레임 방식에서 사용)
+	auto snapshot = [&](double time)
+	{
+		hittable_list list;
+		list.add(make_shared<sphere>(point3(0, -100.5, -1), 100));
+		for (const auto& s : spheres) list.add(make_shared<sphere>(s.center0 + time * (s.center1 - s.center0), s.radius));
+		return list;
+	};
+
+	hittable_list moving;
+	moving.add(make_shared<sphere>(point3(0, -100.5, -1), 100));
+	for (const auto& s : spheres) moving.add(make_shared<sphere>(s.center0, s.center1, s.radius));
+
+	settings.samples_per_pixel = std::max(settings.samples_per_pixel, 16);
+	const int spp = settings.samples_per_pixel;
+	const int subframes = 8;
+	std::vector<color> reference, still, blurred, averaged, subframe;
+
+	// 기준 이미지
+	camera blur_cam = cam;
+	blur_cam.shutter_open = 0.0;
+	blur_cam.shutter_close = 1.0;
+	blur_cam.initialize();
+	bvh_node moving_bvh(moving);
+	render_settings reference_settings = settings;
+	reference_settings.samples_per_pixel = spp * 8;
+	render(blur_cam, moving_bvh, reference_settings, reference, nullptr, false);
+
+	// 1. 정지 이미지
+	auto start = clock::now();
+	bvh_node still_bvh(snapshot(0.0));
+	render(cam, still_bvh, settings, still, nullptr, false);
+	double still_time = seconds(start);
+
+	// 2. 모션 블러
+	start = clock::now();
+	bvh_node blur_bvh(moving);
+	render(blur_cam, blur_bvh, settings, blurred, nullptr, false);
+	double blur_time = seconds(start);
+
+	std::clog << "still          (spp " << spp << "): " << still_time * 1e3 << " ms\n"
+			  << "motion blur    (spp " << spp << "): " << blur_time * 1e3 << " ms (" << blur_time / still_time << "x still), rmse "
+			  << image_rmse(blurred, reference) << '\n';
+
+	// 3. 서브프레임 평균 (서브프레임마다 같은 샘플 수로 렌더링한 경우와, 전체 샘플 수를 모션 블러와 같게 나눈 경우)
+	for (int frame_spp : { spp, std::max(1, spp / subframes) })
+	{
+		render_settings frame_settings = settings;
+		frame_settings.samples_per_pixel = frame_spp;
+
+		start = clock::now();
+		averaged.assign(static_cast<size_t>(cam.image_width) * cam.image_height, color(0, 0, 0));
+		for (int k = 0; k < subframes; ++k)
+		{
+			bvh_node frame_bvh(snapshot((k + 0.5) / subframes));
+			render(cam, frame_bvh, frame_settings, subframe, nullptr, false);
+			for (size_t p = 0; p < averaged.size(); ++p) averaged[p] += subframe[p] / subframes;
+		}
+		double subframe_time = seconds(start);
+
+		std::clog << "subframes x" << subframes << " (spp " << frame_spp << " each): " << subframe_time * 1e3 << " ms ("
+				  << subframe_time / still_time << "x still), rmse " << image_rmse(averaged, reference) << '\n';
+	}
+	return parity_mismatches == 0;
+}
+
+// NUMA 렌더링 모드의 스레드 수에 따른 확장성 측정
+/*
+	스레드 수를 1 개부터 2 배씩 늘려가며 (마지막은 모든 CPU) 씬 복사를 끈 경우와 켠 경우 각각 렌더링해서
+	소요 시간, 1 스레드 대비 속도 향상 비율, 확장 효율(속도 향상 / 스레드 수)을 std::clog 로 출력함.
+*/
+void numa_benchmark(const camera& cam, const hittable_list& world, const render_settings& settings, kernel_precision precision)
+{
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
+
+	numa_topology topology = numa_topology::detect();
+	std::clog << "NUMA nodes: " << topology.nodes.size() << ", CPUs: " << topology.cpu_count() << '\n';
+	for (size_t node = 0; node < topology.nodes.size(); ++node)
+		std::clog << "  node " << node << ": " << topology.nodes[node].size() << " CPUs\n";
+
+	std::vector<int> thread_counts;
+	for (int n = 1; n < topology.cpu_count(); n *= 2) thread_counts.push_back(n);
+	thread_counts.push_back(topology.cpu_count());
+
+	std::vector<color> framebuffer;
+	for (bool replicate : { false, true })
+	{
+		double single_thread_time = 0;
+		for (int n : thread_counts)
+		{
+			numa_options options;
+			options.thread_count = n;
+			options.replicate_scene = replicate;
+
+			auto start = clock::now();
+			render_numa(cam, world, settings, precision, topology, options, framebuffer);
+			double time = seconds(start);
+			if (n == 1) single_thread_time = time;
+
+			double speedup = single_thread_time / time;
+			std::clog << "replicate " << (replicate ? "on " : "off") << ", threads " << n << ": " << time * 1e3 << " ms, speedup "
+					  << speedup << "x, efficiency " << speedup / n * 100 << "%\n";
+		}
+	}
+}
+
+// 후처리 SIMD 커널과 스칼라 레퍼런스 구현의 결과 비교 (postprocess.h 참고)
+/*
+	0 ~ 2 사이의 램프에 음수, NaN, +Inf, -Inf, 아주 큰 값을 섞은 테스트 버퍼를
+	모든 톤매핑 x 감마 보정 x 비트 수 x 디더링 조합에 대해 use_simd 를 켜고 끈 두 경로로 후처리함.
+
+	후처리한 채널 값의 최대 차이가 max_value_error 를 넘거나, 양자화된 채널 값이 1 보다 크게 차이나거나,
+	어느 한 쪽에 NaN 이 남아있으면 false 를 반환함.
+	(양자화 경계에 걸친 값은 덧셈 순서에 따른 반올림 오차만으로도 1 차이가 날 수 있음.)
+*/
+bool postprocess_check()
+{
+	const double inf = std::numeric_limits<double>::infinity(), nan = std::numeric_limits<double>::quiet_NaN();
+	const double specials[] = { nan, -nan, inf, -inf, -1.0, -1e-3, -0.0, 0.0, 0.0031308, 1.0, 1e30, 1e300 };
+
+	// 너비가 홀수인 이미지로 만들어서 SIMD 루프가 처리하지 못하고 남는 채널도 검사함.
+	const int width = 37, height = 5;
+	std::vector<color> input(static_cast<size_t>(width) * height);
+	double* channels = &input[0].e[0];
+	const size_t channel_count = input.size() * 3;
+	for (size_t k = 0; k < channel_count; ++k)
+		channels[k] = (k % 7 == 3) ? specials[(k / 7) % (sizeof(specials) / sizeof(specials[0]))] : 2.0 * k / channel_count;
+
+	const double max_value_error = 1e-12;
+	const tonemap_op tonemaps[] = { tonemap_op::none, tonemap_op::reinhard, tonemap_op::aces };
+	const gamma_mode gammas[] = { gamma_mode::linear, gamma_mode::srgb_exact, gamma_mode::srgb_fast, gamma_mode::srgb_lut };
+	const char* tonemap_names[] = { "none", "reinhard", "aces" };
+	const char* gamma_names[] = { "linear", "srgb", "fast", "lut" };
+	bool passed = true;
+
+	for (tonemap_op tonemap : tonemaps)
+	{
+		for (gamma_mode gamma : gammas)
+		{
+			for (int bits : { 8, 16 })
+			{
+				for (bool dither : { false, true })
+				{
+					postprocess_options opt;
+					opt.exposure = 1.5;
+					opt.tonemap = tonemap;
+					opt.gamma = gamma;
+					opt.bit_depth = bits;
+					opt.dither = dither;
+
+					std::vector<color> simd = input, scalar = input;
+					opt.use_simd = true;
+					postprocess(simd, opt);
+					auto simd_pixels = quantize(simd, width, height, opt);
+					opt.use_simd = false;
+					postprocess(scalar, opt);
+					auto scalar_pixels = quantize(scalar, width, height, opt);
+
+					double value_error = 0.0;
+					int pixel_error = 0;
+					bool has_nan = false;
+					for (size_t k = 0; k < channel_count; ++k)
+					{
+						double a = (&simd[0].e[0])[k], b = (&scalar[0].e[0])[k];
+						has_nan = has_nan || std::isnan(a) || std::isnan(b);
+						value_error = std::max(value_error, std::fabs(a - b));
+						pixel_error = std::max(pixel_error, std::abs(static_cast<int>(simd_pixels[k]) - static_cast<int>(scalar_pixels[k])));
+					}
+
+					const bool ok = !has_nan && value_error <= max_value_error && pixel_error <= 1;
+					passed = passed && ok;
+					std::clog << "tonemap " << std::setw(8) << std::left << tonemap_names[static_cast<int>(tonemap)] << " gamma " << std::setw(6)
+							  << gamma_names[static_cast<int>(gamma)] << std::right << " bits " << std::setw(2) << bits << (dither ? " dither" : "       ") << ": max value diff " << value_error << ", max channel diff "
+							  << pixel_error << (has_nan ? ", NaN in output" : "") << (ok ? "" : "  FAILED") << '\n';
+				}
+			}
+		}
+	}
+
+#ifndef POSTPROCESS_USE_SSE2
+	std::clog << "Built without SSE2: both paths use the scalar kernels.\n";
+#endif
+	return passed;
+}
+
+// 근사 역제곱근과 정규화의 오차, 속도 측정 및 정확한 경로로 렌더링한 이미지와의 비교 (fast_math.h 참고)
+/*
+	1. 로그 균등 분포의 무작위 값들에 대해 rsqrt_fast() (와 SSE2 버전)의 최대 상대 오차를 측정해서 허용 오차와 비교함.
+	2. 같은 무작위 벡터 배열을 정확한 정규화, 근사 정규화, SoA 근사 정규화로 각각 정규화하는 시간을 측정함.
+	3. reference_path 가 주어지면, 현재 설정값으로 렌더링한 이미지를 그 이미지(RT_FAST_MATH=0 빌드의 출력)와
+	   8비트 채널 값 단위로 비교함.
+
+	오차가 허용 오차를 넘거나, 이미지의 채널 값이 max_channel_diff 보다 크게 차이나면 false 를 반환함.
+*/
+bool fast_math_benchmark(const camera& cam, const hittable_list& world, const render_settings& settings, kernel_precision precision,
+						 const postprocess_options& post_options, const std::string& reference_path)
+{
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
+	bool passed = true;
+
+	std::clog << "RT_FAST_MATH=" << RT_FAST_MATH << ", rsqrt path: "
+#ifdef FAST_MATH_USE_SSE2
+			  << "SSE2 rsqrtss + 1 Newton step\n";
+#else
+			  << "bit trick + 2 Newton steps\n";
+#endif
+
+	// 측정용 데이터는 따로 만든 생성기로 뽑음. (random_double() 을 사용하면 이후 렌더링의 난수열이 달라져서 이미지 비교가 불가능함.)
+	std::mt19937 generator(1234);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+
+	// 1. 1e-12 ~ 1e12 범위의 값들에 대한 최대 상대 오차
+	const size_t count = 1 << 20;
+	std::vector<double> values(count);
+	for (auto& x : values) x = std::pow(10.0, -12.0 + 24.0 * uniform(generator));
+
+	double max_error = 0.0;
+	for (double x : values) max_error = std::max(max_error, std::fabs(rsqrt_fast(x) * std::sqrt(x) - 1.0));
+	std::clog << "rsqrt_fast      max rel error " << max_error << " (bound " << fast_rsqrt_max_rel_error << ")\n";
+	passed = passed && max_error <= fast_rsqrt_max_rel_error;
+
+#ifdef FAST_MATH_USE_SSE2
+	double max_error_pd = 0.0;
+	for (size_t k = 0; k + 2 <= count; k += 2)
+	{
+		double y[2];
+		_mm_storeu_pd(y, rsqrt_fast_pd(_mm_loadu_pd(&values[k])));
+		for (int l = 0; l < 2; ++l) max_error_pd = std::max(max_error_pd, std::fabs(y[l] * std::sqrt(values[k + l]) - 1.0));
+	}
+	std::clog << "rsqrt_fast_pd   max rel error " << max_error_pd << " (bound " << fast_rsqrt_max_rel_error << ")\n";
+	passed = passed && max_error_pd <= fast_rsqrt_max_rel_error;
+#endif
+
+	// 2. 정규화 속도 (반직선 방향처럼 길이가 제각각인 벡터들)
 	/*
-		여기서부터 계산되는 변수들은
-		https://raytracing.github.io/books/RayTracingInOneWeekend.html > Figure 4 에 정리된
-		viewport 구조에 존재하는 벡터와 정점들을 선언 및 초기화한 것임.
+		메모리 대역폭이 아닌 연산 비용을 재기 위해 L1/L2 캐시에 들어가는 크기의 배열을 여러 번 반복해서 정규화하고,
+		결과는 출력 배열에 저장함. (합계 하나에 누적하면 덧셈의 지연시간이 병목이 됨.)
 	*/
-	// 뷰포트 왼쪽 끝에서 오른쪽 끝으로 향하는 수평 방향 벡터(viewport_u) 와
-	// 뷰포트 위쪽 끝에서 아래쪽 끝으로 향하는 수직 방향 벡터(viewport_v) 정의
-	auto viewport_u = vec3(viewport_width, 0, 0);
-	auto viewport_v = vec3(0, -viewport_height, 0);
+	const size_t batch = 4096, repeats = 256;
+	std::vector<vec3> vectors(batch), normalized(batch);
+	for (auto& v : vectors) v = vec3(uniform(generator) - 0.5, uniform(generator) - 0.5, uniform(generator) - 0.5) * (0.1 + 10.0 * uniform(generator));
+
+	auto start = clock::now();
+	for (size_t rep = 0; rep < repeats; ++rep)
+		for (size_t k = 0; k < batch; ++k) normalized[k] = unit_vector_exact(vectors[k]);
+	double exact_time = seconds(start);
+	vec3 checksum = normalized[batch / 2]; // 계산 결과를 사용하지 않으면 컴파일러가 반복문을 통째로 제거할 수 있으므로 출력함.
+
+	start = clock::now();
+	for (size_t rep = 0; rep < repeats; ++rep)
+		for (size_t k = 0; k < batch; ++k) normalized[k] = unit_vector_fast(vectors[k]);
+	double fast_time = seconds(start);
+	checksum += normalized[batch / 2];
+
+	double max_length_error = 0.0;
+	for (const auto& v : normalized) max_length_error = std::max(max_length_error, std::fabs(v.length() - 1.0));
+
+	std::vector<double> xs(batch), ys(batch), zs(batch);
+	double soa_time = 0.0;
+	for (size_t rep = 0; rep < repeats; ++rep)
+	{
+		for (size_t k = 0; k < batch; ++k) { xs[k] = vectors[k].x(); ys[k] = vectors[k].y(); zs[k] = vectors[k].z(); }
+		start = clock::now();
+		normalize_soa(xs.data(), ys.data(), zs.data(), batch, true);
+		soa_time += seconds(start);
+	}
+	checksum += vec3(xs[batch / 2], ys[batch / 2], zs[batch / 2]);
+
+	const double normalizations = static_cast<double>(batch * repeats);
+	std::clog << "normalize exact " << exact_time * 1e9 / normalizations << " ns/vec\n"
+			  << "normalize fast  " << fast_time * 1e9 / normalizations << " ns/vec (" << exact_time / fast_time
+			  << "x), max |length - 1| " << max_length_error << '\n'
+			  << "normalize soa   " << soa_time * 1e9 / normalizations << " ns/vec (" << exact_time / soa_time << "x)  [checksum "
+			  << checksum.x() + checksum.y() + checksum.z() << "]\n";
+
+	// 3. 정확한 경로의 이미지와 비교
+	if (reference_path.empty()) return passed;
+
+	std::ifstream reference_file(reference_path);
+	int width = 0, height = 0, maxval = 0;
+	std::vector<std::uint16_t> reference;
+	if (!reference_file || !read_ppm(reference_file, width, height, reference, maxval))
+	{
+		std::cerr << "Cannot read reference image: " << reference_path << '\n';
+		return false;
+	}
+	if (width != cam.image_width || height != cam.image_height || maxval != output_maxval(post_options))
+	{
+		std::cerr << "Reference image must be a " << post_options.bit_depth << "-bit " << cam.image_width << "x" << cam.image_height << " render\n";
+		return false;
+	}
 
-	// pixel grid 의 각 픽셀 사이의 수평 방향 간격을 나타내는 벡터(pixel_delta_u)와
-	// pixel grid 의 각 픽셀 사이의 수직 방향 간격을 나타내는 벡터(pixel_delta_v) 정의
-	auto pixel_delta_u = viewport_u / image_width;
-	auto pixel_delta_v = viewport_v / image_height;
+	// 기본 렌더링 경로(특수화 커널 + 명령줄에서 지정한 후처리)와 같은 방식으로 렌더링함.
+	std::vector<color> framebuffer;
+	specialized_renderer kernel(world, settings, precision);
+	start = clock::now();
+	render_specialized(cam, kernel, framebuffer, false);
+	double render_time = seconds(start);
 
-	// 뷰포트의 좌상단 꼭지점의 '3D 공간 상의' 좌표 계산 (이미지 좌표 아님 주의!!) (Figure 4 에서 Q 로 표시)
-	// 카메라 원점에서 focal_length 만큼 음의 z축으로 이동 후, 뷰포트 수평 길이의 절반만큼 왼쪽으로,
-	// 뷰포트 수직 길이의 절반만큼 위쪽으로 이동
-	auto viewport_upper_left = camera_center
-							- vec3(0, 0, focal_length) - viewport_u / 2 - viewport_v / 2;
+	postprocess(framebuffer, post_options);
+	auto pixels = quantize(framebuffer, width, height, post_options);
 
-	// 'pixel grid'의 좌상단 픽셀(이미지 좌표 상으로 (0,0)에 해당하는 픽셀)의 '3D 공간 상의' 좌표 계산 (Figure 4 에서 P0,0 으로 표시)
-	// '뷰포트 좌상단 꼭지점'에서 픽셀 간격의 절반씩만큼 오른쪽, 아래쪽으로 이동
-	auto pixel00_loc = viewport_upper_left + 0.5 * (pixel_delta_u + pixel_delta_v);
+	const int max_channel_diff = (maxval + 1) / 256; // 허용하는 채널 값의 최대 차이 (8비트 기준 1)
+	int largest_diff = 0;
+	size_t differing = 0;
+	for (size_t k = 0; k < pixels.size(); ++k)
+	{
+		int diff = std::abs(static_cast<int>(pixels[k]) - static_cast<int>(reference[k]));
+		largest_diff = std::max(largest_diff, diff);
+		if (diff > 0) ++differing;
+	}
 
+	std::clog << "image diff (" << kernel.name() << ", " << render_time * 1e3 << " ms): max channel diff " << largest_diff
+			  << " (allowed " << max_channel_diff << "), differing channels " << differing << " / " << pixels.size() << '\n';
+	return passed && largest_diff <= max_channel_diff;
+}
 
-	// Render
+// 구체 클라우드의 LOD 와 메모리 예산에 따른 렌더링 시간, 디스크 읽기 횟수, 메모리 사용량, 오차 측정 (sphere_cloud.h 참고)
+/*
+	sphere_count 개의 구체로 이루어진 클라우드 파일을 임시로 만든 뒤,
+
+	1. 모든 클러스터를 원래 구체로, 메모리 예산 없이 렌더링 (기준 이미지)
+	2. 모든 클러스터를 원래 구체로, budget_bytes 예산 안에서 렌더링
+	3. max_proxy_pixels 이하로 투영되는 클러스터를 대체 구체로 바꾸고, budget_bytes 예산 안에서 렌더링
+
+	각각의 소요 시간, 클러스터 읽기/내보내기 횟수, 최대 메모리 사용량, 기준 이미지와의 RMSE 를 std::clog 로 출력함.
+*/
+void cloud_benchmark(const camera& cam, const render_settings& settings, std::uint64_t sphere_count, size_t budget_bytes, double max_proxy_pixels)
+{
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
+
+	const std::string path = "sphere_cloud_bench.bin";
+	sphere_cloud_params params;
+	params.sphere_count = sphere_count;
 
-	std::cout << "P3\n" << image_width << ' ' << image_height << "\n255\n"; // PPM Example 의 1번째에서 3번째 줄까지의 메타 정보를 출력
+	auto start = clock::now();
+	if (!write_sphere_cloud(path, params)) return;
+	std::clog << "generated " << sphere_count << " spheres (" << sphere_count * sphere_cloud_floats_per_sphere * sizeof(float) / (1 << 20)
+			  << " MiB of sphere data) in " << seconds(start) << " s\n";
 
-	// 각 픽셀의 색상값(r, g, b)을 0 ~ 256 사이의 scale 된 정수값 범위로 출력
-	for (int j = 0; j < image_height; ++j)
+	auto cloud = make_shared<sphere_cloud>();
+	if (!cloud->open(path, budget_bytes))
 	{
-		// ppm 에 출력할 색상값을 한 줄(row)씩 처리할 때마다 남아있는 줄을 std::clog 로 출력함 > 에러 출력 스트림
-		// 참고로, std::flush 는 스트림에 대기중인 버퍼의 내용을 비운 후, 강제로 출력시킴.
-		// std::cout 은 색상값 출력 시 사용되므로, 이에 대한 대체제로써 std::clog 를 사용한 것!
-		std::clog << "\rScanlines remaining: " << (image_height - j) << ' ' << std::flush;
-		for (int i = 0; i < image_width; ++i)
+		std::remove(path.c_str());
+		return;
+	}
+
+	// 기본 씬의 바닥 구체는 지형의 아래쪽을, 가운데 구체는 멀리 있는 지형을 가리므로, 구체 클라우드만으로 씬을 구성함.
+	hittable_list world;
+	world.add(cloud);
+
+	std::clog << cloud->cluster_count() << " clusters, resident index " << cloud->fixed_bytes() / (1 << 10) << " KiB, budget "
+			  << budget_bytes / (1 << 20) << " MiB\n";
+
+	struct config { const char* name; double lod_pixels; size_t budget; };
+	const config configs[] = { { "full detail, no budget", 0.0, 0 }, { "full detail, budget  ", 0.0, budget_bytes }, { "lod,         budget  ", max_proxy_pixels, budget_bytes } };
+
+	std::vector<color> reference, framebuffer;
+	for (const config& c : configs)
+	{
+		cloud->open(path, c.budget); // 예산을 바꾸고 캐시를 비운 상태에서 시작함.
+		size_t proxies = cloud->select_lod(cam, c.lod_pixels);
+
+		start = clock::now();
+		render(cam, world, settings, framebuffer, nullptr, false);
+		double time = seconds(start);
+		if (reference.empty()) reference = framebuffer;
+
+		const sphere_cloud_store& cache = cloud->cache();
+		std::clog << c.name << ": " << time * 1e3 << " ms, proxies " << proxies << ", loads " << cache.load_count() << ", evictions "
+				  << cache.eviction_count() << ", peak memory " << (cloud->fixed_bytes() + cache.peak_resident_bytes()) / (1 << 10)
+				  << " KiB, rmse " << image_rmse(framebuffer, reference) << '\n';
+	}
+
+	std::remove(path.c_str());
+}
+
+// 메모리 예산의 4배 크기 씬을 아웃 오브 코어로 렌더링해서, 예산을 지키면서도 메모리 안에서 렌더링한 이미지와 같은지 확인함. (out_of_core.h 참고)
+/*
+	구체 데이터만으로 budget_bytes 의 4배가 되는 구체 클라우드 파일을 임시로 만든 뒤,
+
+	1. 메모리 예산 없이 렌더링 (기준 이미지, 씬 전체를 메모리에 올린 것과 같음.)
+	2. budget_bytes 예산 안에서 hittable 로 렌더링 (반직선이 청크에 닿는 즉시 읽어옴.)
+	3. budget_bytes 예산 안에서 render_out_of_core() 로 렌더링 (청크별 대기열에 모아서 한 번에 처리)
+
+	각각의 소요 시간, 청크 읽기 횟수, 최대 메모리 사용량을 std::clog 로 출력하고,
+	3번의 최대 메모리 사용량이 예산 이하이고 노멀 셰이딩 이미지가 기준 이미지와 같으면 true 를 반환함.
+	(난반사 셰이딩에서는 난수를 쓰는 순서가 달라지므로 RMSE 만 출력함.)
+*/
+bool out_of_core_benchmark(const camera& cam, const render_settings& settings, size_t budget_bytes, size_t rays_in_flight)
+{
+	using clock = std::chrono::steady_clock;
+	auto seconds = [](clock::time_point from) { return std::chrono::duration<double>(clock::now() - from).count(); };
+
+	const std::string path = "out_of_core_bench.bin";
+	sphere_cloud_params params;
+	params.sphere_count = 4 * budget_bytes / (sphere_cloud_floats_per_sphere * sizeof(float));
+	params.spheres_per_cluster = 4096; // 청크 하나 64 KiB (디스크에서 한 번에 읽는 단위)
+
+	auto start = clock::now();
+	if (!write_sphere_cloud(path, params)) return false;
+	std::clog << "generated " << params.sphere_count << " spheres (" << params.sphere_count * sphere_cloud_floats_per_sphere * sizeof(float) / (1 << 20)
+			  << " MiB of sphere data, budget " << budget_bytes / (1 << 20) << " MiB) in " << seconds(start) << " s\n";
+
+	auto cloud = make_shared<sphere_cloud>();
+	if (!cloud->open(path, 0))
+	{
+		std::remove(path.c_str());
+		return false;
+	}
+
+	// 구체 클라우드만으로 씬을 구성함. (cloud_benchmark() 참고)
+	hittable_list in_core, with_cloud;
+	with_cloud.add(cloud);
+	std::clog << cloud->cluster_count() << " chunks\n";
+
+	std::vector<color> reference, framebuffer;
+	auto report = [&](const char* name, double time, size_t peak_bytes)
+	{
+		const sphere_cloud_store& cache = cloud->cache();
+		std::clog << name << ": " << time * 1e3 << " ms, loads " << cache.load_count() << ", evictions " << cache.eviction_count()
+				  << ", peak memory " << peak_bytes / (1 << 10) << " KiB";
+		if (!reference.empty()) std::clog << ", rmse " << image_rmse(framebuffer, reference);
+		std::clog << '\n';
+	};
+
+	start = clock::now();
+	render(cam, with_cloud, settings, framebuffer, nullptr, false);
+	report("in-core        ", seconds(start), cloud->fixed_bytes() + cloud->cache().peak_resident_bytes());
+	reference = framebuffer;
+
+	cloud->open(path, budget_bytes);
+	start = clock::now();
+	render(cam, with_cloud, settings, framebuffer, nullptr, false);
+	report("lazy, budget   ", seconds(start), cloud->fixed_bytes() + cloud->cache().peak_resident_bytes());
+
+	cloud->open(path, budget_bytes);
+	out_of_core_options options;
+	options.memory_budget = budget_bytes;
+	options.rays_in_flight = rays_in_flight;
+	out_of_core_stats stats;
+	start = clock::now();
+	render_out_of_core(cam, in_core, *cloud, settings, options, framebuffer, &stats);
+	const size_t peak_bytes = cloud->fixed_bytes() + stats.ray_bytes + stats.hierarchy_bytes + cloud->cache().peak_resident_bytes();
+	report("deferred, budget", seconds(start), peak_bytes);
+	std::clog << "  " << stats.deferred_rays << " deferred rays in " << stats.chunk_batches << " chunk batches (largest " << stats.largest_batch
+			  << "), ray queues " << stats.ray_bytes / (1 << 10) << " KiB, chunk hierarchy " << stats.hierarchy_bytes / (1 << 10) << " KiB\n";
+
+	std::remove(path.c_str());
+
+	size_t differing = 0;
+	for (size_t k = 0; k < framebuffer.size(); ++k)
+		if (framebuffer[k][0] != reference[k][0] || framebuffer[k][1] != reference[k][1] || framebuffer[k][2] != reference[k][2]) ++differing;
+
+	const bool within_budget = peak_bytes <= budget_bytes;
+	const bool identical = settings.shading != shading_mode::normal || differing == 0;
+	std::clog << (within_budget ? "PASS" : "FAIL") << ": peak memory " << peak_bytes / (1 << 10) << " KiB <= budget " << budget_bytes / (1 << 10) << " KiB\n";
+	if (settings.shading == shading_mode::normal)
+		std::clog << (identical ? "PASS" : "FAIL") << ": " << differing << " / " << framebuffer.size() << " pixels differ from the in-core image\n";
+	return within_budget && identical;
+}
+
+int main(int argc, char* argv[])
+{
+	// Command line
+
+	// --preview [port] : .ppm 을 출력하지 않고, 렌더링 중인 프레임을 localhost 로 스트리밍함. (preview_server.h 참고)
+	// --spp N / --depth N / --diffuse : 픽셀 당 샘플 수, 최대 반사 횟수, 램버시안 셰이딩 사용
+	// --ground : 바닥 역할을 하는 큰 구체를 씬에 추가 (--diffuse, --denoise, --denoise-bench 에서는 자동으로 추가됨)
+	// --denoise : 렌더링 후 보조 버퍼를 사용해서 디노이저 적용 (denoiser.h 참고)
+	// --denoise-bench : 디노이저 time-to-quality 측정 결과만 출력
+	// --batch manifest [--threads N] : 매니페스트의 작업들을 하나의 스레드 풀에서 렌더링 (batch.h 참고)
+	// --float : 특수화된 커널에서 float 정밀도로 교차 검사 (kernels.h 참고)
+	// --kernel-bench : 특수화된 커널과 범용 렌더링 경로의 속도 비교 결과만 출력
+	// --lookdev-bench : 셰이딩 값만 바꿔가며 다시 렌더링할 때 1차 충돌 캐시를 사용한 경우와의 속도 비교 결과만 출력 (hit_cache.h 참고)
+	// --motion-bench : 움직이는 구체의 커널 교차 검사 비교, 모션 블러와 서브프레임 평균 방식의 속도, 품질 비교 결과만 출력 (bvh.h 참고)
+	// --numa [--threads N] [--no-replicate] : 스레드를 NUMA 노드별 CPU 에 고정하고 노드마다 씬을 복사해서 렌더링 (numa.h 참고)
+	// --numa-bench : NUMA 렌더링 모드의 스레드 수에 따른 확장성 측정 결과만 출력
+	// --spectral : hero wavelength 방식의 스펙트럴 렌더링 (반직선 하나에 파장 4개, spectral.h 참고)
+	// --spectral-bench : RGB 렌더링과 스펙트럴 렌더링(hero wavelength, 파장별 반직선)의 시간, 오차 비교 결과만 출력
+	// --exposure X / --tonemap none|reinhard|aces / --gamma linear|srgb|fast|lut / --bits 8|16 / --dither : 후처리, 양자화 설정 (postprocess.h 참고)
+	// --postprocess-check : 후처리 SIMD 커널과 스칼라 구현의 결과를 NaN, Inf, 음수가 섞인 테스트 버퍼로 비교한 결과만 출력
+	// --fastmath-bench [reference.ppm] : 근사 역제곱근의 오차와 정규화 속도를 측정하고, 정확한 경로로 렌더링한 이미지와 비교 (fast_math.h 참고)
+	// --stats prefix [--bvh] [--threads N] : 픽셀별 교차 검사 횟수, 노드 방문 횟수, 반사 횟수, 사이클 수를 히트맵(prefix_*.ppm)과 히스토그램으로 출력 (heatmap.h 참고)
+	// --mesh path : .obj / .ply 메쉬를 씬에 추가 (mesh_io.h 참고)
+	// --cloud path [--cloud-budget MiB] [--lod-pixels N] : 구체 클라우드를 씬에 추가, N 픽셀 이하로 보이는 클러스터는 대체 구체로 렌더링 (sphere_cloud.h 참고)
+	// --cloud-generate path [count] : 무작위 구체 클라우드 파일을 만들고 종료
+	// --cloud-bench [count] : 구체 클라우드의 LOD, 메모리 예산에 따른 시간, 메모리, 오차 측정 결과만 출력
+	// --ooc [--rays N] : --cloud 의 청크를 예산 안에서 읽어가며, 메모리에 없는 청크가 필요한 반직선은 청크별 대기열에 모아서 렌더링 (out_of_core.h 참고)
+	// --ooc-bench [MiB] [--rays N] : 예산(기본 16 MiB)의 4배 크기 씬을 아웃 오브 코어로 렌더링해서 메모리 사용량과 이미지를 검증
+	// --mesh-bench [path] : 메쉬 로딩 시간, 메모리, 초당 반직선 수 측정 결과만 출력 (path 가 없으면 생성된 메쉬 사용)
+	// --interleave [N] : 씬 전체를 평평한 계층 구조로 펼치고, 반직선 N 개(기본 16)씩 번갈아 순회하며 묶음 단위로 렌더링 (interleaved.h 참고)
+	// --interleave-bench : 여러 반직선을 번갈아 진행시키며 프리페치하는 메쉬 순회, 씬 렌더링의 속도 측정 결과만 출력 (triangle_mesh.h, interleaved.h 참고)
+	render_settings settings;
+	postprocess_options post_options; // 기본 설정(톤매핑, 감마 보정 없음 / 8비트 / 디더링 없음)은 기존 write_color() 와 동일한 결과를 출력함.
+	bool postprocess_check_only = false;
+	kernel_precision precision = kernel_precision::f64;
+	bool preview = false, use_denoiser = false, denoise_bench = false, kernel_bench = false;
+	bool mesh_bench = false, lookdev_bench = false, motion_bench = false, interleave_bench = false;
+	bool use_spectral = false, spectral_bench = false, use_ground = false;
+	bool use_numa = false, numa_bench = false, replicate_scene = true, stats_use_bvh = false, fast_math_bench = false;
+	int preview_port = 8080, thread_count = 0, interleave_group = 0;
+	std::string batch_manifest_path, mesh_path, stats_prefix, fast_math_reference, cloud_path, cloud_generate_path;
+	bool cloud_bench = false, out_of_core = false, out_of_core_bench = false;
+	size_t rays_in_flight = out_of_core_options().rays_in_flight;
+	double out_of_core_bench_mib = 16.0;
+	std::uint64_t cloud_sphere_count = sphere_cloud_params().sphere_count;
+	double cloud_budget_mib = 0.0, lod_pixels = 4.0;
+
+	for (int k = 1; k < argc; ++k)
+	{
+		std::string arg = argv[k];
+		bool has_value = k + 1 < argc && argv[k + 1][0] != '-';
+
+		if (arg == "--preview")
 		{
-			// 뷰포트 각 픽셀 중점의 '3D 공간 상의' 좌표 계산
-			auto pixel_center = pixel00_loc + (i * pixel_delta_u) + (j * pixel_delta_v);
-			
-			// 카메라 중점 ~ 뷰포트 각 픽셀 중점까지 향하는 방향벡터 계산
-			auto ray_direction = pixel_center - camera_center;
+			preview = true;
+			if (has_value) preview_port = std::atoi(argv[++k]);
+		}
+		else if (arg == "--spp" && has_value) settings.samples_per_pixel = std::max(1, std::atoi(argv[++k]));
+		else if (arg == "--depth" && has_value) settings.max_depth = std::max(1, std::atoi(argv[++k]));
+		else if (arg == "--diffuse") settings.shading = shading_mode::diffuse;
+		else if (arg == "--ground") use_ground = true;
+		else if (arg == "--denoise") use_denoiser = true;
+		else if (arg == "--denoise-bench") denoise_bench = true;
+		else if (arg == "--float") precision = kernel_precision::f32;
+		else if (arg == "--kernel-bench") kernel_bench = true;
+		else if (arg == "--lookdev-bench") lookdev_bench = true;
+		else if (arg == "--motion-bench") motion_bench = true;
+		else if (arg == "--numa") use_numa = true;
+		else if (arg == "--numa-bench") numa_bench = true;
+		else if (arg == "--no-replicate") replicate_scene = false;
+		else if (arg == "--exposure" && has_value) post_options.exposure = std::atof(argv[++k]);
+		else if (arg == "--bits" && has_value) post_options.bit_depth = std::atoi(argv[++k]) > 8 ? 16 : 8;
+		else if (arg == "--dither") post_options.dither = true;
+		else if ((arg == "--tonemap" || arg == "--gamma") && has_value)
+		{
+			std::string name = argv[++k];
+			bool known = (arg == "--tonemap") ? parse_tonemap(name, post_options.tonemap) : parse_gamma(name, post_options.gamma);
+			if (!known)
+			{
+				std::cerr << "Unknown " << arg.substr(2) << ": " << name << '\n';
+				return 1;
+			}
+		}
+		else if (arg == "--postprocess-check") postprocess_check_only = true;
+		else if (arg == "--fastmath-bench")
+		{
+			fast_math_bench = true;
+			if (has_value) fast_math_reference = argv[++k];
+		}
+		else if (arg == "--stats" && has_value) stats_prefix = argv[++k];
+		else if (arg == "--bvh") stats_use_bvh = true;
+		else if (arg == "--batch" && has_value) batch_manifest_path = argv[++k];
+		else if (arg == "--threads" && has_value) thread_count = std::atoi(argv[++k]);
+		else if (arg == "--mesh" && has_value) mesh_path = argv[++k];
+		else if (arg == "--cloud" && has_value) cloud_path = argv[++k];
+		else if (arg == "--cloud-budget" && has_value) cloud_budget_mib = std::atof(argv[++k]);
+		else if (arg == "--lod-pixels" && has_value) lod_pixels = std::atof(argv[++k]);
+		else if (arg == "--cloud-generate" && has_value)
+		{
+			cloud_generate_path = argv[++k];
+			if (k + 1 < argc && argv[k + 1][0] != '-') cloud_sphere_count = std::strtoull(argv[++k], nullptr, 10);
+		}
+		else if (arg == "--ooc") out_of_core = true;
+		else if (arg == "--rays" && has_value) rays_in_flight = std::strtoull(argv[++k], nullptr, 10);
+		else if (arg == "--ooc-bench")
+		{
+			out_of_core_bench = true;
+			if (has_value) out_of_core_bench_mib = std::atof(argv[++k]);
+		}
+		else if (arg == "--cloud-bench")
+		{
+			cloud_bench = true;
+			if (has_value) cloud_sphere_count = std::strtoull(argv[++k], nullptr, 10);
+		}
+		else if (arg == "--interleave-bench") interleave_bench = true;
+		else if (arg == "--interleave") interleave_group = has_value ? std::max(1, std::atoi(argv[++k])) : interleave_options().group_size;
+		else if (arg == "--spectral") use_spectral = true;
+		else if (arg == "--spectral-bench") spectral_bench = true;
+		else if (arg == "--mesh-bench")
+		{
+			mesh_bench = true;
+			if (has_value) mesh_path = argv[++k];
+		}
+	}
+
+
+	// World
+
+	// 씬에 존재하는 물체들을 hittable_list 에 추가함.
+	hittable_list world;
+	world.add(make_shared<sphere>(point3(0, 0, -1), 0.5)); // 중점이 (0, 0, -1) 이고, 반지름이 0.5 인 구체
+
+	// 바닥 역할을 하는 아주 큰 구체
+	/*
+		램버시안 셰이딩에서는 반직선이 바닥에서 튕겨나가며 그림자와 간접광이 생기므로,
+		디노이저가 제거할 노이즈와 보존해야 할 경계가 함께 있는 장면을 만들기 위해 추가함.
+
+		노멀 시각화만 하는 기본 렌더링은 구체 하나만 있던 원래 씬과 같은 이미지를 출력하도록,
+		--ground 를 지정하거나 램버시안 셰이딩 / 디노이저를 사용할 때만 추가함.
+	*/
+	if (use_ground || use_denoiser || denoise_bench || settings.shading == shading_mode::diffuse)
+		world.add(make_shared<sphere>(point3(0, -100.5, -1), 100));
+
+	if (postprocess_check_only)
+	{
+		return postprocess_check() ? 0 : 1;
+	}
+
+	if (mesh_bench)
+	{
+		mesh_benchmark(mesh_path);
+		return 0;
+	}
+
+	if (interleave_bench)
+	{
+		return interleave_benchmark() ? 0 : 1;
+	}
+
+	if (!cloud_generate_path.empty())
+	{
+		sphere_cloud_params params;
+		params.sphere_count = cloud_sphere_count;
+		return write_sphere_cloud(cloud_generate_path, params) ? 0 : 1;
+	}
+
+	// 메쉬가 추가되면 씬이 구체로만 이루어져 있지 않으므로, 특수화 커널은 범용(generic) 씬 경로로 렌더링함.
+	if (!mesh_path.empty())
+	{
+		auto mesh = make_shared<triangle_mesh>();
+		if (!load_mesh(mesh_path, *mesh)) return 1;
+		world.add(mesh);
+	}
+
+
+	// Camera
+
+	// 이미지 크기와 viewport 관련 계산은 camera 클래스로 옮겨짐. (camera.h 참고)
+	camera cam;
+	cam.aspect_ratio = 16.0 / 9.0; // 이미지의 종횡비를 16:9 로 설정
+	cam.image_width = 400; // 이미지 너비는 상수이며, 이미지 너비 값에 따라 이미지 높이 값이 종횡비와 곱해져서 계산됨.
+	cam.focal_length = 1.0; // 카메라 중점(eye point)과 viewport 사이의 거리 (현재는 단위 거리 1로 지정함.)
+	cam.viewport_height = 2.0; // viewport 높이
+	cam.center = point3(0, 0, 0); // 3D Scene 상에서 카메라 중점(eye point)
+	cam.initialize();
+
+	int image_width = cam.image_width;
+	int image_height = cam.image_height;
+
+	// 구체 클라우드는 카메라에서 본 클러스터의 크기로 LOD 를 고르므로, 카메라를 설정한 뒤에 추가함.
+	const size_t cloud_budget_bytes = static_cast<size_t>(cloud_budget_mib * (1 << 20));
+	shared_ptr<sphere_cloud> cloud;
+	if (!cloud_path.empty())
+	{
+		cloud = make_shared<sphere_cloud>();
+		if (!cloud->open(cloud_path, cloud_budget_bytes)) return 1;
+		cloud->select_lod(cam, lod_pixels);
+		if (!out_of_core) world.add(cloud); // 아웃 오브 코어 렌더링에서는 청크들을 world 와 따로 순회함.
+	}
 
-			// 카메라 ~ 뷰포트 각 픽셀 중점까지 향하는 반직선(ray) 타입 변수 r 선언 및 초기화
-			ray r(camera_center, ray_direction);
 
-			auto pixel_color = ray_color(r); // 주어진 반직선(ray) r 을 입력받아 특정 색상을 반환받아 픽셀 색상 계산
-			write_color(std::cout, pixel_color); // color 객체에 정의된 색상값을 스트림 출력하는 유틸 함수 호출
+	// Preview
+
+	if (preview)
+	{
+		// 뷰어에서 보낸 씬 파라미터를 렌더링 설정값에 반영함. (지정하지 않은 값은 명령줄의 설정값을 그대로 사용)
+		/*
+			spp, depth : 픽셀 당 샘플 수, 최대 반사 횟수
+			diffuse    : 0 이면 노멀 시각화, 0 이 아니면 램버시안 셰이딩
+			sky_top_r, sky_top_g, sky_top_b, sky_bottom_r, sky_bottom_g, sky_bottom_b : 하늘 그라디언트 색상
+		*/
+		render_settings preview_settings = settings;
+		auto apply_params = [&](const preview_params& p)
+		{
+			preview_settings.samples_per_pixel = std::max(1, static_cast<int>(p.get("spp", settings.samples_per_pixel)));
+			preview_settings.max_depth = std::max(1, static_cast<int>(p.get("depth", settings.max_depth)));
+			bool diffuse = p.get("diffuse", settings.shading == shading_mode::diffuse ? 1.0 : 0.0) != 0.0;
+			preview_settings.shading = diffuse ? shading_mode::diffuse : shading_mode::normal;
+			const char* channel[] = { "r", "g", "b" };
+			for (int k = 0; k < 3; ++k)
+			{
+				preview_settings.sky.top[k] = p.get(std::string("sky_top_") + channel[k], settings.sky.top[k]);
+				preview_settings.sky.bottom[k] = p.get(std::string("sky_bottom_") + channel[k], settings.sky.bottom[k]);
+			}
+		};
+
+		// render_region() 과 같은 방식으로 픽셀 하나의 샘플들을 평균냄.
+		preview_server server(cam, [&](const camera& c, int i, int j, const preview_params&)
+		{
+			const int spp = preview_settings.samples_per_pixel;
+			color pixel_color(0, 0, 0);
+			for (int s = 0; s < spp; ++s)
+			{
+				ray r = (spp == 1) ? c.get_ray(i, j) : c.get_sample_ray(i, j, s, spp);
+				pixel_color += ray_color(r, preview_settings.max_depth, world, preview_settings.shading, nullptr, preview_settings.sky);
+			}
+			return pixel_color / spp;
+		});
+		server.prepare = apply_params;
+		server.port = preview_port;
+		server.run();
+		return 0;
+	}
+
+	if (!batch_manifest_path.empty())
+	{
+		std::ifstream manifest_file(batch_manifest_path);
+		if (!manifest_file)
+		{
+			std::cerr << "Cannot open batch manifest: " << batch_manifest_path << '\n';
+			return 1;
 		}
+
+		// 작업들에서 지정하지 않은 값은 위에서 설정한 카메라, 렌더링 설정값, 후처리 설정값을 기본값으로 사용함.
+		batch_manifest manifest = load_batch_manifest(manifest_file, cam, settings, post_options);
+		run_batch(manifest, thread_count, 32, std::clog);
+		return 0;
+	}
+
+	if (denoise_bench)
+	{
+		denoise_benchmark(cam, world, settings);
+		return 0;
+	}
+
+	if (kernel_bench)
+	{
+		kernel_benchmark(cam, world, settings.max_depth);
+		return 0;
+	}
+
+	if (!stats_prefix.empty())
+	{
+		// 가속 구조의 노드 방문 횟수도 보려면 --bvh 로 씬 전체를 BVH 로 묶어서 렌더링함.
+		std::vector<color> framebuffer;
+		std::vector<pixel_stats> stats;
+		if (stats_use_bvh) render_with_stats(cam, bvh_node(world), settings, framebuffer, stats, thread_count);
+		else render_with_stats(cam, world, settings, framebuffer, stats, thread_count);
+
+#if !RT_TRACE_STATS
+		std::clog << "Built with RT_TRACE_STATS=0: only cycles are recorded.\n";
+#endif
+		write_stats_report(stats_prefix, image_width, image_height, stats, std::clog);
+		return 0;
+	}
+
+	if (numa_bench)
+	{
+		numa_benchmark(cam, world, settings, precision);
+		return 0;
+	}
+
+	if (cloud_bench)
+	{
+		cloud_benchmark(cam, settings, cloud_sphere_count, cloud_budget_bytes > 0 ? cloud_budget_bytes : 4 << 20, lod_pixels);
+		return 0;
+	}
+
+	if (spectral_bench)
+	{
+		spectral_benchmark(cam, world, settings);
+		return 0;
+	}
+
+	if (out_of_core_bench)
+	{
+		return out_of_core_benchmark(cam, settings, static_cast<size_t>(out_of_core_bench_mib * (1 << 20)), rays_in_flight) ? 0 : 1;
+	}
+
+	if (fast_math_bench)
+	{
+		return fast_math_benchmark(cam, world, settings, precision, post_options, fast_math_reference) ? 0 : 1;
+	}
+
+	if (motion_bench)
+	{
+		return motion_blur_benchmark(cam, settings) ? 0 : 1;
+	}
+
+	if (lookdev_bench)
+	{
+		lookdev_benchmark(cam, world, settings);
+		return 0;
+	}
+
+
+	// Render
+
+	// 각 픽셀의 선형 색상값을 곧바로 출력하지 않고 프레임버퍼에 모아둔 뒤, 렌더링이 끝나면 버퍼 전체를 한 번에 후처리함.
+	std::vector<color> framebuffer;
+	aux_buffers aux;
+	out_of_core_stats ooc_stats; // 아웃 오브 코어 렌더링에서 반직선 대기열과 청크 BVH 가 차지한 메모리
+	if (use_denoiser)
+	{
+		// 보조 버퍼가 필요한 경우에는 범용 렌더링 경로를 사용함.
+		render(cam, world, settings, framebuffer, &aux, true);
+	}
+	else if (use_spectral)
+	{
+		// 셰이딩을 파장 단위로 계산하므로 RGB 로 특수화된 커널 대신 범용 렌더링 경로를 사용함.
+		render_spectral(cam, world, settings, spectral_sampling::hero, framebuffer, true);
+	}
+	else if (cloud && out_of_core)
+	{
+		out_of_core_options options;
+		options.memory_budget = cloud_budget_bytes;
+		options.rays_in_flight = rays_in_flight;
+		render_out_of_core(cam, world, *cloud, settings, options, framebuffer, &ooc_stats);
+	}
+	else if (interleave_group > 0)
+	{
+		// 씬 전체를 평평한 계층 구조로 펼쳐서, 묶음 안의 반직선들을 번갈아 순회하며 렌더링함.
+		interleave_options options;
+		options.group_size = interleave_group;
+		render_interleaved(cam, world, settings, options, framebuffer, true);
 	}
+	else if (use_numa)
+	{
+		// 스레드들을 NUMA 노드별로 고정하고, 노드마다 자기 메모리의 씬 복사본으로 렌더링함.
+		numa_options options;
+		options.thread_count = thread_count;
+		options.replicate_scene = replicate_scene;
+		render_numa(cam, world, settings, precision, numa_topology::detect(), options, framebuffer);
+	}
+	else
+	{
+		// 현재 설정값에 맞게 미리 컴파일된 특수화 커널을 골라서 렌더링함.
+		specialized_renderer kernel(world, settings, precision);
+		render_specialized(cam, kernel, framebuffer, true);
+	}
+
+	if (cloud)
+	{
+		const sphere_cloud_store& cache = cloud->cache();
+		std::clog << "\rSphere cloud: " << cache.load_count() << " cluster loads, " << cache.eviction_count() << " evictions, peak memory "
+				  << (cloud->fixed_bytes() + ooc_stats.ray_bytes + ooc_stats.hierarchy_bytes + cache.peak_resident_bytes()) / (1 << 10) << " KiB\n";
+	}
+
+	// Denoise
+
+	// 샘플 수가 적어서 생긴 노이즈를 알베도, 노멀, 깊이 보조 버퍼를 참고해서 제거함.
+	if (use_denoiser) denoise(framebuffer, aux, denoise_options());
+
+	// Post-process
+
+	// 명령줄에서 지정한 노출, 톤매핑, 감마 보정, 비트 수, 디더링 설정으로 후처리함.
+	postprocess(framebuffer, post_options); // 노출, 톤매핑, 클램핑, 감마 보정을 버퍼 전체에 적용
+	auto pixels = quantize(framebuffer, image_width, image_height, post_options); // 0 ~ 1 범위의 색상값을 정수형 채널 값으로 양자화
+	write_ppm(std::cout, image_width, image_height, pixels, output_maxval(post_options)); // 양자화된 버퍼 전체를 .ppm 형식으로 출력
 
 	std::clog << "\rDone.					\n"; // 반복문이 종료되면 .ppm 에 출력할 색상 계산이 완료되었음을 std::clog 로 콘솔 출력함.
 }
@@ -0,0 +1,351 @@
+#ifndef MESH_IO_H
+#define MESH_IO_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "triangle_mesh.h" // 파일에서 읽어들인 정점과 인덱스를 채워넣을 메쉬 클래스 포함
+
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+	OBJ / PLY 메쉬 파일 로더
+
+	파일 전체를 메모리에 올린 뒤 파싱하면 파일 크기만큼의 메모리가 추가로 필요하므로,
+	한 줄(OBJ, ASCII PLY) 또는 한 요소(binary PLY)씩 스트림에서 읽으면서 곧바로 메쉬 버퍼에 채워넣음.
+
+	에러가 발생하면 std::cerr 로 이유를 출력하고 false 를 반환함.
+	성공하면 메쉬의 build() 까지 호출된 상태로 반환됨.
+*/
+
+// OBJ 의 면 정의에서 "v", "v/vt", "v//vn", "v/vt/vn" 형태의 토큰 하나를 읽어서 정점 / 노멀 인덱스를 꺼냄.
+// OBJ 인덱스는 1 부터 시작하고, 음수이면 지금까지 읽은 개수에서부터 거꾸로 센 상대 인덱스임.
+inline bool parse_obj_corner(const char*& cursor, size_t vertex_count, size_t normal_count, std::uint32_t& v, std::int64_t& vn)
+{
+	char* end;
+	long long index = std::strtoll(cursor, &end, 10);
+	if (end == cursor) return false;
+	cursor = end;
+
+	long long resolved = index < 0 ? static_cast<long long>(vertex_count) + index : index - 1;
+	if (resolved < 0 || resolved >= static_cast<long long>(vertex_count)) return false;
+	v = static_cast<std::uint32_t>(resolved);
+
+	vn = -1;
+	if (*cursor == '/')
+	{
+		++cursor;
+		if (*cursor != '/')
+		{
+			std::strtoll(cursor, &end, 10); // 텍스처 좌표 인덱스는 사용하지 않으므로 건너뜀
+			cursor = end;
+		}
+		if (*cursor == '/')
+		{
+			++cursor;
+			long long n = std::strtoll(cursor, &end, 10);
+			if (end != cursor)
+			{
+				long long resolved_n = n < 0 ? static_cast<long long>(normal_count) + n : n - 1;
+				if (resolved_n >= 0 && resolved_n < static_cast<long long>(normal_count)) vn = resolved_n;
+			}
+			cursor = end;
+		}
+	}
+	return true;
+}
+
+inline bool load_obj(const std::string& path, triangle_mesh& mesh)
+{
+	std::ifstream in(path);
+	if (!in)
+	{
+		std::cerr << "Cannot open mesh: " << path << '\n';
+		return false;
+	}
+
+	bool all_corners_have_normals = true;
+	std::string line;
+	std::vector<std::uint32_t> face_v;
+	std::vector<std::int64_t> face_n;
+
+	while (std::getline(in, line))
+	{
+		const char* cursor = line.c_str();
+		while (*cursor == ' ' || *cursor == '\t') ++cursor;
+
+		if (cursor[0] == 'v' && (cursor[1] == ' ' || cursor[1] == '\t'))
+		{
+			char* end;
+			cursor += 2;
+			for (int a = 0; a < 3; ++a)
+			{
+				mesh.positions.push_back(std::strtof(cursor, &end));
+				cursor = end;
+			}
+		}
+		else if (cursor[0] == 'v' && cursor[1] == 'n')
+		{
+			char* end;
+			cursor += 2;
+			for (int a = 0; a < 3; ++a)
+			{
+				mesh.normals.push_back(std::strtof(cursor, &end));
+				cursor = end;
+			}
+		}
+		else if (cursor[0] == 'f' && (cursor[1] == ' ' || cursor[1] == '\t'))
+		{
+			++cursor;
+			face_v.clear();
+			face_n.clear();
+
+			while (true)
+			{
+				while (*cursor == ' ' || *cursor == '\t' || *cursor == '\r') ++cursor;
+				if (*cursor == '\0') break;
+
+				std::uint32_t v;
+				std::int64_t vn;
+				if (!parse_obj_corner(cursor, mesh.vertex_count(), mesh.normals.size() / 3, v, vn))
+				{
+					std::cerr << "Invalid face in mesh: " << path << '\n';
+					return false;
+				}
+				face_v.push_back(v);
+				face_n.push_back(vn);
+				if (vn < 0) all_corners_have_normals = false;
+			}
+
+			// 사각형 이상의 다각형은 첫 번째 정점을 중심으로 하는 부채꼴(fan) 형태의 삼각형들로 나눔.
+			for (size_t k = 2; k < face_v.size(); ++k)
+			{
+				mesh.indices.insert(mesh.indices.end(), { face_v[0], face_v[k - 1], face_v[k] });
+				mesh.normal_indices.insert(mesh.normal_indices.end(),
+										   { static_cast<std::uint32_t>(face_n[0] < 0 ? 0 : face_n[0]),
+											 static_cast<std::uint32_t>(face_n[k - 1] < 0 ? 0 : face_n[k - 1]),
+											 static_cast<std::uint32_t>(face_n[k] < 0 ? 0 : face_n[k]) });
+			}
+		}
+		// 그 외의 줄(vt, g, o, s, usemtl, 주석 등)은 무시함.
+	}
+
+	// 노멀이 지정되지 않은 면이 하나라도 있으면, 정점 노멀을 사용하지 않고 면 노멀을 사용함.
+	if (!all_corners_have_normals || mesh.normals.empty())
+	{
+		std::vector<float>().swap(mesh.normals);
+		std::vector<std::uint32_t>().swap(mesh.normal_indices);
+	}
+
+	mesh.build();
+	return true;
+}
+
+// PLY 헤더에 정의된 속성(property) 하나
+struct ply_property
+{
+	std::string name;
+	std::string type; // 값의 타입 (list 이면 각 원소의 타입)
+	std::string count_type; // list 속성의 원소 개수 타입 (list 가 아니면 비어있음)
+};
+
+// PLY 헤더에 정의된 요소(element) 하나
+struct ply_element
+{
+	std::string name;
+	size_t count = 0;
+	std::vector<ply_property> properties;
+};
+
+// PLY 타입 이름에 해당하는 바이트 수 (알 수 없는 타입이면 0)
+inline int ply_type_size(const std::string& type)
+{
+	if (type == "char" || type == "uchar" || type == "int8" || type == "uint8") return 1;
+	if (type == "short" || type == "ushort" || type == "int16" || type == "uint16") return 2;
+	if (type == "int" || type == "uint" || type == "int32" || type == "uint32" || type == "float" || type == "float32") return 4;
+	if (type == "double" || type == "float64") return 8;
+	return 0;
+}
+
+// 값 하나를 읽어서 double 로 반환 (binary 는 little-endian 만 지원하며, 실행 환경도 little-endian 이라고 가정함.)
+inline bool read_ply_value(std::istream& in, const std::string& type, bool ascii, double& value)
+{
+	if (ascii) return static_cast<bool>(in >> value);
+
+	unsigned char bytes[8];
+	int size = ply_type_size(type);
+	if (size == 0 || !in.read(reinterpret_cast<char*>(bytes), size)) return false;
+
+	if (type == "char" || type == "int8") value = static_cast<std::int8_t>(bytes[0]);
+	else if (type == "uchar" || type == "uint8") value = bytes[0];
+	else if (type == "short" || type == "int16") { std::int16_t v; std::memcpy(&v, bytes, 2); value = v; }
+	else if (type == "ushort" || type == "uint16") { std::uint16_t v; std::memcpy(&v, bytes, 2); value = v; }
+	else if (type == "int" || type == "int32") { std::int32_t v; std::memcpy(&v, bytes, 4); value = v; }
+	else if (type == "uint" || type == "uint32") { std::uint32_t v; std::memcpy(&v, bytes, 4); value = v; }
+	else if (type == "float" || type == "float32") { float v; std::memcpy(&v, bytes, 4); value = v; }
+	else { double v; std::memcpy(&v, bytes, 8); value = v; }
+	return true;
+}
+
+// 헤더 이후의 본문에서 요소들을 순서대로 읽어서 메쉬 버퍼에 채움. 파일이 중간에 끊기거나 정점 좌표가 없으면 false 반환.
+inline bool read_ply_elements(std::istream& in, const std::vector<ply_element>& elements, bool ascii, triangle_mesh& mesh)
+{
+	std::vector<double> values;
+	std::vector<std::uint32_t> polygon;
+	for (const ply_element& e : elements)
+	{
+		const bool is_vertex = (e.name == "vertex");
+		const bool is_face = (e.name == "face");
+		int x = -1, y = -1, z = -1, nx = -1, ny = -1, nz = -1;
+		for (size_t k = 0; k < e.properties.size(); ++k)
+		{
+			const std::string& name = e.properties[k].name;
+			if (name == "x") x = static_cast<int>(k);
+			else if (name == "y") y = static_cast<int>(k);
+			else if (name == "z") z = static_cast<int>(k);
+			else if (name == "nx") nx = static_cast<int>(k);
+			else if (name == "ny") ny = static_cast<int>(k);
+			else if (name == "nz") nz = static_cast<int>(k);
+		}
+		const bool has_normals = is_vertex && nx >= 0 && ny >= 0 && nz >= 0;
+
+		values.resize(e.properties.size());
+		for (size_t item = 0; item < e.count; ++item)
+		{
+			for (size_t k = 0; k < e.properties.size(); ++k)
+			{
+				const ply_property& p = e.properties[k];
+				if (p.count_type.empty())
+				{
+					if (!read_ply_value(in, p.type, ascii, values[k])) return false;
+					continue;
+				}
+
+				// list 속성: 원소 개수를 먼저 읽고, 그 개수만큼 값을 읽음.
+				double count;
+				if (!read_ply_value(in, p.count_type, ascii, count)) return false;
+				polygon.clear();
+				for (int c = 0; c < static_cast<int>(count); ++c)
+				{
+					double index;
+					if (!read_ply_value(in, p.type, ascii, index)) return false;
+					polygon.push_back(static_cast<std::uint32_t>(index));
+				}
+
+				if (is_face && (p.name == "vertex_indices" || p.name == "vertex_index"))
+				{
+					for (size_t c = 2; c < polygon.size(); ++c)
+						mesh.indices.insert(mesh.indices.end(), { polygon[0], polygon[c - 1], polygon[c] });
+				}
+			}
+
+			if (is_vertex)
+			{
+				if (x < 0 || y < 0 || z < 0) return false;
+				mesh.positions.insert(mesh.positions.end(), { static_cast<float>(values[x]), static_cast<float>(values[y]), static_cast<float>(values[z]) });
+				if (has_normals)
+					mesh.normals.insert(mesh.normals.end(), { static_cast<float>(values[nx]), static_cast<float>(values[ny]), static_cast<float>(values[nz]) });
+			}
+		}
+	}
+	return true;
+}
+
+inline bool load_ply(const std::string& path, triangle_mesh& mesh)
+{
+	std::ifstream in(path, std::ios::binary);
+	std::string line;
+	if (!in || !std::getline(in, line) || line.compare(0, 3, "ply") != 0)
+	{
+		std::cerr << "Cannot open PLY mesh: " << path << '\n';
+		return false;
+	}
+
+	// 헤더 파싱
+	bool ascii = false;
+	std::vector<ply_element> elements;
+	while (std::getline(in, line))
+	{
+		if (!line.empty() && line.back() == '\r') line.pop_back();
+		std::istringstream tokens(line);
+		std::string keyword;
+		tokens >> keyword;
+
+		if (keyword == "format")
+		{
+			std::string format;
+			tokens >> format;
+			ascii = (format == "ascii");
+			if (!ascii && format != "binary_little_endian")
+			{
+				std::cerr << "Unsupported PLY format '" << format << "': " << path << '\n';
+				return false;
+			}
+		}
+		else if (keyword == "element")
+		{
+			ply_element e;
+			tokens >> e.name >> e.count;
+			elements.push_back(e);
+		}
+		else if (keyword == "property" && !elements.empty())
+		{
+			ply_property p;
+			std::string type;
+			tokens >> type;
+			if (type == "list") tokens >> p.count_type >> p.type >> p.name;
+			else
+			{
+				p.type = type;
+				tokens >> p.name;
+			}
+			elements.back().properties.push_back(p);
+		}
+		else if (keyword == "end_header")
+		{
+			break;
+		}
+	}
+
+	// 본문 파싱 (헤더에 정의된 순서대로 요소들이 저장되어 있음)
+	if (!read_ply_elements(in, elements, ascii, mesh))
+	{
+		std::cerr << "Unexpected end of PLY mesh or missing x/y/z: " << path << '\n';
+		return false;
+	}
+
+	// 범위를 벗어난 정점 인덱스가 있으면 잘못된 파일로 판단
+	for (std::uint32_t v : mesh.indices)
+	{
+		if (v >= mesh.vertex_count())
+		{
+			std::cerr << "PLY face index out of range: " << path << '\n';
+			return false;
+		}
+	}
+
+	// PLY 의 정점 노멀은 정점과 같은 인덱스를 사용하므로 normal_indices 는 비워둠.
+	mesh.build();
+	return true;
+}
+
+// 확장자에 따라 OBJ 또는 PLY 로더를 호출함.
+inline bool load_mesh(const std::string& path, triangle_mesh& mesh)
+{
+	std::string extension = path.size() >= 4 ? path.substr(path.size() - 4) : std::string();
+	for (auto& c : extension) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+
+	if (extension == ".ply") return load_ply(path, mesh);
+	if (extension == ".obj") return load_obj(path, mesh);
+
+	std::cerr << "Unknown mesh format (expected .obj or .ply): " << path << '\n';
+	return false;
+}
+
+#endif // !MESH_IO_H
@@ -0,0 +1,276 @@
+#ifndef NUMA_H
+#define NUMA_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "camera.h"
+#include "color.h"
+#include "hittable_list.h"
+#include "kernels.h" // 노드마다 특수화된 커널(구체 SoA 배열 포함)을 따로 만들기 위해 포함
+#include "renderer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <fstream>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 운영체제별 스레드 고정(pinning) API 와 NUMA 토폴로지 조회 API (하단 필기 'NUMA 와 first-touch' 참고)
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX // windows.h 의 min / max 매크로가 std::min / std::max 와 충돌하지 않도록 함.
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN // windows.h 가 winsock.h 를 포함해서 preview_server.h 의 winsock2.h 와 충돌하지 않도록 함.
+#endif
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// "0-3,8-11" 같은 리눅스 sysfs 의 CPU 목록 문자열을 번호 배열로 바꿈.
+inline std::vector<int> parse_cpu_list(const std::string& text)
+{
+	std::vector<int> cpus;
+	std::stringstream ranges(text);
+	std::string range;
+	while (std::getline(ranges, range, ','))
+	{
+		if (range.empty() || range[0] < '0' || range[0] > '9') continue;
+		size_t dash = range.find('-');
+		int first = std::atoi(range.c_str());
+		int last = (dash == std::string::npos) ? first : std::atoi(range.c_str() + dash + 1);
+		for (int cpu = first; cpu <= last; ++cpu) cpus.push_back(cpu);
+	}
+	return cpus;
+}
+
+// NUMA 노드별 논리 CPU 번호 목록
+struct numa_topology
+{
+	std::vector<std::vector<int>> nodes;
+
+	int cpu_count() const
+	{
+		int count = 0;
+		for (const auto& cpus : nodes) count += static_cast<int>(cpus.size());
+		return count;
+	}
+
+	// 현재 시스템의 토폴로지를 조회함. 조회할 수 없으면 모든 CPU 를 하나의 노드로 취급함.
+	static numa_topology detect()
+	{
+		numa_topology topology;
+
+#ifdef _WIN32
+		// 프로세서 그룹 0 (최대 64개의 논리 CPU) 만 다룸.
+		ULONG highest = 0;
+		if (GetNumaHighestNodeNumber(&highest))
+		{
+			for (ULONG node = 0; node <= highest; ++node)
+			{
+				ULONGLONG mask = 0;
+				if (!GetNumaNodeProcessorMask(static_cast<UCHAR>(node), &mask) || mask == 0) continue;
+				std::vector<int> cpus;
+				for (int cpu = 0; cpu < 64; ++cpu)
+					if (mask & (1ULL << cpu)) cpus.push_back(cpu);
+				topology.nodes.push_back(cpus);
+			}
+		}
+#else
+		// 프로세스가 실행될 수 있는 CPU 들만 사용함. (taskset, cgroup 등으로 제한된 경우)
+		cpu_set_t allowed;
+		CPU_ZERO(&allowed);
+		const bool has_mask = sched_getaffinity(0, sizeof(allowed), &allowed) == 0;
+
+		std::ifstream online("/sys/devices/system/node/online");
+		std::string line;
+		if (online && std::getline(online, line))
+		{
+			for (int node : parse_cpu_list(line))
+			{
+				std::ifstream cpulist("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+				if (!cpulist || !std::getline(cpulist, line)) continue;
+
+				std::vector<int> cpus;
+				for (int cpu : parse_cpu_list(line))
+					if (!has_mask || (cpu < CPU_SETSIZE && CPU_ISSET(cpu, &allowed))) cpus.push_back(cpu);
+				if (!cpus.empty()) topology.nodes.push_back(cpus);
+			}
+		}
+#endif
+
+		if (topology.nodes.empty())
+		{
+			int n = std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+			topology.nodes.emplace_back();
+			for (int cpu = 0; cpu < n; ++cpu) topology.nodes[0].push_back(cpu);
+		}
+		return topology;
+	}
+};
+
+// 현재 스레드가 cpu 번 논리 CPU 에서만 실행되도록 고정함. 실패하면 false 반환.
+inline bool pin_current_thread(int cpu)
+{
+#ifdef _WIN32
+	if (cpu < 0 || cpu >= 64) return false;
+	return SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1) << cpu) != 0;
+#else
+	if (cpu < 0 || cpu >= CPU_SETSIZE) return false;
+	cpu_set_t set;
+	CPU_ZERO(&set);
+	CPU_SET(cpu, &set);
+	return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#endif
+}
+
+// NUMA 렌더링 설정값
+struct numa_options
+{
+	int thread_count = 0; // 0 이면 토폴로지의 모든 CPU 를 사용
+	bool pin_threads = true; // 스레드를 CPU 에 고정할지 여부
+	bool replicate_scene = true; // 노드마다 씬과 커널 데이터를 복사해둘지 여부
+	int tile_size = 32;
+};
+
+// 스레드들을 NUMA 노드별 CPU 에 고정하고, 노드마다 자기 메모리에 있는 씬 복사본으로 렌더링함. (하단 필기 'NUMA 렌더링 모드' 참고)
+/*
+	스레드는 0번 노드의 CPU 부터 차례대로 채워나가므로,
+	thread_count 가 한 노드의 CPU 수 이하이면 하나의 노드만 사용함.
+*/
+inline void render_numa(const camera& cam, const hittable_list& world, const render_settings& settings, kernel_precision precision,
+						const numa_topology& topology, const numa_options& options, std::vector<color>& framebuffer)
+{
+	// 스레드마다 고정할 CPU 와 소속 노드를 정함.
+	std::vector<int> thread_cpu, thread_node;
+	const int total = options.thread_count > 0 ? options.thread_count : topology.cpu_count();
+	for (int k = 0; k < total; ++k)
+	{
+		// CPU 수보다 스레드가 많으면 처음부터 다시 배정함.
+		int index = k % topology.cpu_count();
+		int node = 0;
+		while (index >= static_cast<int>(topology.nodes[node].size())) index -= static_cast<int>(topology.nodes[node++].size());
+		thread_cpu.push_back(topology.nodes[node][index]);
+		thread_node.push_back(node);
+	}
+
+	// 사용되는 노드들과 노드별 스레드 수, 노드별로 복사본을 만들 첫 번째 스레드
+	const int node_count = *std::max_element(thread_node.begin(), thread_node.end()) + 1;
+	std::vector<int> node_threads(node_count, 0), node_first(node_count, -1);
+	for (int k = 0; k < total; ++k)
+	{
+		++node_threads[thread_node[k]];
+		if (node_first[thread_node[k]] < 0) node_first[thread_node[k]] = k;
+	}
+
+	// 타일들을 노드별 스레드 수에 비례하는 연속된 구간으로 나눔. (노드마다 이미지의 서로 다른 띠(band)를 맡음.)
+	const int tiles_x = (cam.image_width + options.tile_size - 1) / options.tile_size;
+	const int tiles_y = (cam.image_height + options.tile_size - 1) / options.tile_size;
+	const int tile_count = tiles_x * tiles_y;
+
+	struct node_state
+	{
+		int end = 0;
+		std::atomic<int> next{ 0 };
+		std::promise<void> ready;
+		std::shared_future<void> ready_future;
+		shared_ptr<hittable_list> replica;
+		std::unique_ptr<specialized_renderer> kernel;
+	};
+	std::vector<std::unique_ptr<node_state>> nodes;
+	int assigned = 0;
+	for (int node = 0; node < node_count; ++node)
+	{
+		auto state = std::unique_ptr<node_state>(new node_state());
+		state->next = assigned;
+		assigned += static_cast<int>(static_cast<long long>(tile_count) * node_threads[node] / total);
+		state->end = (node == node_count - 1) ? tile_count : assigned;
+		state->ready_future = state->ready.get_future().share();
+		nodes.push_back(std::move(state));
+	}
+
+	// 복사하지 않는 경우에는 씬과 커널을 호출한 스레드의 메모리에 하나만 만들어서 모든 노드가 공유함.
+	std::shared_ptr<specialized_renderer> shared_kernel;
+	if (!options.replicate_scene) shared_kernel = std::make_shared<specialized_renderer>(world, settings, precision);
+
+	framebuffer.assign(static_cast<size_t>(cam.image_width) * cam.image_height, color(0, 0, 0));
+
+	auto render_tile = [&](const specialized_renderer& kernel, int tile)
+	{
+		int x0 = (tile % tiles_x) * options.tile_size, y0 = (tile / tiles_x) * options.tile_size;
+		kernel.render_region(cam, framebuffer, x0, y0, std::min(x0 + options.tile_size, cam.image_width),
+							 std::min(y0 + options.tile_size, cam.image_height));
+	};
+
+	auto worker = [&](int k)
+	{
+		const int home = thread_node[k];
+		if (options.pin_threads) pin_current_thread(thread_cpu[k]);
+
+		node_state& local = *nodes[home];
+		const specialized_renderer* kernel = shared_kernel.get();
+		if (options.replicate_scene)
+		{
+			// 노드의 첫 번째 스레드가 (이미 이 노드의 CPU 에 고정된 상태에서) 복사본을 만들면, 복사본은 이 노드의 메모리에 할당됨.
+			if (node_first[home] == k)
+			{
+				local.replica = std::make_shared<hittable_list>(world.deep_copy());
+				local.kernel.reset(new specialized_renderer(*local.replica, settings, precision));
+				local.ready.set_value();
+			}
+			local.ready_future.wait();
+			kernel = local.kernel.get();
+		}
+
+		// 자기 노드의 타일부터 처리하고, 다 끝나면 다른 노드의 남은 타일을 가져와서 처리함.
+		for (int offset = 0; offset < node_count; ++offset)
+		{
+			node_state& source = *nodes[(home + offset) % node_count];
+			for (int tile = source.next++; tile < source.end; tile = source.next++) render_tile(*kernel, tile);
+		}
+	};
+
+	std::vector<std::thread> threads;
+	for (int k = 0; k < total; ++k) threads.emplace_back(worker, k);
+	for (auto& th : threads) th.join();
+}
+
+#endif // !NUMA_H
+
+/*
+	NUMA 와 first-touch
+
+
+	소켓(CPU 패키지)이 여러 개인 서버에서는 소켓마다 자기에게 직접 연결된 메모리가 따로 있고,
+	다른 소켓에 연결된 메모리에 접근하면 소켓 간 연결을 거쳐야 하므로 지연 시간이 더 길고 대역폭도 좁음.
+	이런 구조를 NUMA(Non-Uniform Memory Access)라고 하고, 소켓과 그 메모리를 묶어서 NUMA 노드라고 부름.
+
+	리눅스와 윈도우는 기본적으로 메모리 페이지를 '처음 쓰기(touch)를 한 스레드가 실행 중인 노드'에 할당함. (first-touch 정책)
+	그래서 별도의 NUMA 라이브러리 없이도, 스레드를 노드의 CPU 에 고정(pinning)한 다음
+	그 스레드에서 데이터를 할당하고 채우면 데이터가 그 노드의 메모리에 놓이게 됨.
+
+
+	NUMA 렌더링 모드
+
+
+	1. 렌더링 스레드들을 노드별 CPU 에 하나씩 고정함.
+	   (고정하지 않으면 운영체제가 스레드를 다른 소켓으로 옮길 수 있어서 메모리 지역성이 깨짐.)
+
+	2. replicate_scene 이 true 이면, 노드의 첫 번째 스레드가 씬 전체를 clone() 으로 복사하고
+	   특수화된 커널(구체 SoA 배열)도 복사본으로부터 만듦.
+	   이 데이터는 렌더링 중에는 읽기만 하므로, 노드마다 복사본을 두어도 동기화가 필요 없음.
+
+	3. 이미지의 타일들을 노드별 스레드 수에 비례하는 연속된 구간으로 나눠서 노드마다 자기 구간부터 처리하고,
+	   자기 구간이 다 끝난 스레드만 다른 노드의 남은 타일을 가져가서 처리함.
+	   가져간 타일도 자기 노드의 씬 복사본으로 렌더링하므로, 교차 검사는 항상 지역 메모리에서 이루어짐.
+
+	소켓이 하나뿐인 시스템에서는 노드도 하나뿐이므로, 복사본을 하나 더 만드는 비용만 추가됨.
+*/
@@ -0,0 +1,453 @@
+#ifndef OUT_OF_CORE_H
+#define OUT_OF_CORE_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "camera.h"
+#include "color.h"
+#include "hittable.h"
+#include "renderer.h" // render_settings, shading_mode 를 그대로 사용하기 위해 포함
+#include "sphere_cloud.h" // 디스크에 청크 단위로 저장된 씬과 청크 캐시
+#include "trace_stats.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <vector>
+
+// 메모리보다 큰 씬을 청크 단위로 읽어가며 렌더링하는 렌더러 (하단 필기 '아웃 오브 코어 렌더링' 참고)
+/*
+	sphere_cloud 를 hittable 로 렌더링하면, 반직선이 메모리에 없는 청크에 닿을 때마다 그 자리에서 청크를 읽어옴.
+	메모리 예산이 작으면 서로 다른 청크를 오가는 반직선들 때문에 같은 청크를 여러 번 읽고 내보내게 됨.
+
+	render_out_of_core() 는 메모리에 없는 청크가 필요한 반직선을 그 청크의 대기열에 넣어두고 다른 반직선을 계속 추적하다가,
+	대기열이 가장 긴 청크를 한 번 읽어서 기다리던 반직선들을 한꺼번에 처리함.
+	그래서 청크를 한 번 읽는 비용을 많은 반직선이 나눠서 부담하게 됨.
+*/
+
+// 청크들의 경계 상자로 만든 BVH (청크 순회용 상위 계층 구조)
+/*
+	반직선이 지나가는 청크들을 반직선에 들어가는 t 가 작은 순서대로 하나씩 찾아줌. (next() 참고)
+	반직선이 어떤 청크까지 검사했는지는 그 청크의 (진입 t, 청크 번호) 하나로 기억할 수 있으므로,
+	반직선을 대기열에 넣었다가 나중에 이어서 순회할 때 따로 스택을 저장해둘 필요가 없음.
+
+	노드 배치는 triangle_mesh 의 BVH 와 같음. (32 바이트 노드, 깊이 우선 순서)
+*/
+class chunk_hierarchy
+{
+public:
+	static const std::uint32_t no_chunk = 0xffffffffu;
+
+	void build(const sphere_cloud_store& store)
+	{
+		nodes.clear();
+		boxes.assign(store.cluster_count(), chunk_box());
+		order.resize(store.cluster_count());
+		for (size_t k = 0; k < store.cluster_count(); ++k)
+		{
+			const sphere_cloud_cluster_header& h = store.header(k);
+			std::copy_n(h.box_min, 3, boxes[k].bmin);
+			std::copy_n(h.box_max, 3, boxes[k].bmax);
+			order[k] = static_cast<std::uint32_t>(k);
+		}
+		if (order.empty()) return;
+
+		nodes.reserve(2 * order.size() / leaf_size + 1);
+		build_node(0, static_cast<std::uint32_t>(order.size()));
+		nodes.shrink_to_fit();
+	}
+
+	// 반직선이 (after_t, after_chunk) 다음으로 들어가는 청크를 찾음.
+	/*
+		청크들은 (진입 t, 청크 번호) 순서로 정렬된 것처럼 취급하고, 진입 t 가 ray_tmax 보다 작은 청크만 찾음.
+		ray_tmax 에 지금까지 찾은 가장 가까운 충돌 지점을 넘기면, 그보다 뒤에 있는 청크들은 검사하지 않고 끝남.
+		처음 순회할 때는 after_t = -infinity, after_chunk = no_chunk 를 넘기면 됨.
+	*/
+	bool next(const ray& r, const vec3& inv_dir, double ray_tmin, double ray_tmax, double after_t, std::uint32_t after_chunk,
+			  double& entry_t, std::uint32_t& chunk) const
+	{
+		if (nodes.empty()) return false;
+
+		std::uint32_t stack[64];
+		int sp = 0;
+		std::uint32_t node = 0;
+
+		double best_t = infinity;
+		std::uint32_t best_chunk = no_chunk;
+
+		while (true)
+		{
+			const chunk_node& n = nodes[node];
+			TRACE_COUNT(node_visits, 1);
+
+			// 노드를 빠져나가는 t 가 after_t 보다 작으면, 그 안의 청크들은 모두 이미 지나온 청크들임.
+			// 진입 t 가 같은 청크끼리는 번호로 순서를 정하므로, best_t 와 진입 t 가 같은 노드도 건너뛰지 않음.
+			double t0, t1;
+			if (!slab(n.box, r, inv_dir, ray_tmin, ray_tmax, t0, t1) || t1 < after_t || t0 > best_t)
+			{
+				if (sp == 0) break;
+				node = stack[--sp];
+				continue;
+			}
+
+			if (n.count > 0)
+			{
+				for (std::uint32_t k = n.first; k < n.first + n.count; ++k)
+				{
+					const std::uint32_t c = order[k];
+					if (!slab(boxes[c], r, inv_dir, ray_tmin, ray_tmax, t0, t1)) continue;
+					if (t0 < after_t || (t0 == after_t && c <= after_chunk)) continue; // 이미 검사한 청크
+					if (t0 > best_t || (t0 == best_t && c >= best_chunk)) continue; // 지금까지 찾은 청크보다 뒤에 있음.
+					best_t = t0;
+					best_chunk = c;
+				}
+				if (sp == 0) break;
+				node = stack[--sp];
+			}
+			else
+			{
+				std::uint32_t left = node + 1, right = n.first;
+				if (r.direction()[n.axis] < 0) std::swap(left, right);
+				stack[sp++] = right;
+				node = left;
+			}
+		}
+
+		if (best_chunk == no_chunk) return false;
+		entry_t = best_t;
+		chunk = best_chunk;
+		return true;
+	}
+
+	size_t memory_bytes() const
+	{
+		return nodes.capacity() * sizeof(chunk_node) + boxes.capacity() * sizeof(chunk_box) + order.capacity() * sizeof(std::uint32_t);
+	}
+
+private:
+	struct chunk_box
+	{
+		float bmin[3];
+		float bmax[3];
+	};
+
+	struct chunk_node
+	{
+		chunk_box box;
+		std::uint32_t first;
+		std::uint16_t count;
+		std::uint16_t axis;
+	};
+
+	static const std::uint32_t leaf_size = 4;
+
+	std::vector<chunk_node> nodes;
+	std::vector<chunk_box> boxes; // 청크 번호 순서의 경계 상자
+	std::vector<std::uint32_t> order; // 리프 노드가 가리키는 청크 번호들
+	static float infinity_f() { return std::numeric_limits<float>::infinity(); }
+
+	// 반직선이 [ray_tmin, ray_tmax] 범위 안에서 상자에 들어가는 t 와 나오는 t (aabb::hit() 과 같은 계산)
+	static bool slab(const chunk_box& b, const ray& r, const vec3& inv_dir, double ray_tmin, double ray_tmax, double& t_enter, double& t_exit)
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			double t0 = (b.bmin[a] - r.origin()[a]) * inv_dir[a];
+			double t1 = (b.bmax[a] - r.origin()[a]) * inv_dir[a];
+			if (inv_dir[a] < 0.0) std::swap(t0, t1);
+			ray_tmin = t0 > ray_tmin ? t0 : ray_tmin;
+			ray_tmax = t1 < ray_tmax ? t1 : ray_tmax;
+			if (ray_tmax <= ray_tmin) return false;
+		}
+		t_enter = ray_tmin;
+		t_exit = ray_tmax;
+		return true;
+	}
+
+	void build_node(std::uint32_t begin, std::uint32_t end)
+	{
+		const std::uint32_t index = static_cast<std::uint32_t>(nodes.size());
+		nodes.push_back(chunk_node());
+
+		chunk_node n;
+		float cmin[3], cmax[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			n.box.bmin[a] = cmin[a] = infinity_f();
+			n.box.bmax[a] = cmax[a] = -infinity_f();
+		}
+		for (std::uint32_t k = begin; k < end; ++k)
+		{
+			const chunk_box& b = boxes[order[k]];
+			for (int a = 0; a < 3; ++a)
+			{
+				n.box.bmin[a] = std::min(n.box.bmin[a], b.bmin[a]);
+				n.box.bmax[a] = std::max(n.box.bmax[a], b.bmax[a]);
+				cmin[a] = std::min(cmin[a], 0.5f * (b.bmin[a] + b.bmax[a]));
+				cmax[a] = std::max(cmax[a], 0.5f * (b.bmin[a] + b.bmax[a]));
+			}
+		}
+
+		int axis = 0;
+		for (int a = 1; a < 3; ++a)
+			if (cmax[a] - cmin[a] > cmax[axis] - cmin[axis]) axis = a;
+
+		if (end - begin <= leaf_size)
+		{
+			n.first = begin;
+			n.count = static_cast<std::uint16_t>(end - begin);
+			n.axis = 0;
+			nodes[index] = n;
+			return;
+		}
+
+		const std::uint32_t mid = begin + (end - begin) / 2;
+		std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end, [&](std::uint32_t a, std::uint32_t b)
+						 { return boxes[a].bmin[axis] + boxes[a].bmax[axis] < boxes[b].bmin[axis] + boxes[b].bmax[axis]; });
+
+		build_node(begin, mid);
+		n.first = static_cast<std::uint32_t>(nodes.size());
+		n.count = 0;
+		n.axis = static_cast<std::uint16_t>(axis);
+		build_node(mid, end);
+		nodes[index] = n;
+	}
+};
+
+// 아웃 오브 코어 렌더링 설정값
+struct out_of_core_options
+{
+	size_t memory_budget = 0; // 청크 캐시, 청크 정보, 반직선 대기열을 모두 합한 메모리 예산 (0 이면 제한하지 않음.)
+	size_t rays_in_flight = 1 << 12; // 동시에 추적하는 반직선의 최대 개수 (대기열에 들어있는 반직선 포함, 반직선 하나에 약 200 바이트)
+};
+
+// 아웃 오브 코어 렌더링 결과 통계
+struct out_of_core_stats
+{
+	size_t deferred_rays = 0; // 메모리에 없는 청크 때문에 대기열에 들어간 횟수
+	size_t chunk_batches = 0; // 청크 하나를 골라서 대기열의 반직선들을 처리한 횟수
+	size_t largest_batch = 0;
+	size_t ray_bytes = 0; // 반직선 상태와 대기열이 차지하는 메모리
+	size_t hierarchy_bytes = 0; // 청크 BVH 가 차지하는 메모리
+};
+
+// world(메모리에 있는 물체들)와 cloud(디스크의 청크들)로 이루어진 씬을 메모리 예산 안에서 렌더링함.
+/*
+	renderer.h 의 render() 와 같은 이미지를 만듦. (난반사 셰이딩에서는 난수를 쓰는 순서가 달라서 잡음만 다름.)
+	cloud 는 world 에 추가하지 않은 채로 넘겨야 하고, 대체 구체로 렌더링할 청크는 미리 select_lod() 로 정해둬야 함.
+
+	반직선 상태는 rays_in_flight 개의 슬롯에 고정 크기로 저장하고, 청크마다의 대기열은 슬롯끼리 잇는 연결 리스트로 만듦.
+	그래서 반직선 쪽 메모리는 렌더링 내내 일정하고, 그 크기를 뺀 나머지를 청크 캐시의 예산으로 사용함.
+*/
+inline void render_out_of_core(const camera& cam, const hittable& world, sphere_cloud& cloud, const render_settings& settings,
+							   const out_of_core_options& options, std::vector<color>& framebuffer, out_of_core_stats* stats = nullptr)
+{
+	// 추적 중인 반직선 하나의 상태
+	struct deferred_ray
+	{
+		ray r;
+		vec3 inv_dir;
+		color weight; // 반직선이 가져올 색상에 곱해질 값 (튕겨나갈 때마다 알베도를 곱함.)
+		hit_record rec; // 지금까지 찾은 가장 가까운 충돌 (rec.t 가 infinity 면 아직 충돌하지 않음.)
+		double cursor_t; // 마지막으로 검사한 청크의 진입 t
+		std::uint32_t cursor_chunk; // 마지막으로 검사한 청크
+		std::uint32_t pixel;
+		int depth; // 앞으로 더 튕겨나갈 수 있는 횟수
+	};
+
+	const std::uint32_t none = chunk_hierarchy::no_chunk;
+	const int spp = settings.samples_per_pixel;
+	const size_t pixel_count = static_cast<size_t>(cam.image_width) * cam.image_height;
+	const size_t sample_count = pixel_count * spp;
+	const size_t chunk_count = cloud.cluster_count();
+	const std::uint32_t slot_count = static_cast<std::uint32_t>(std::max<size_t>(1, std::min(options.rays_in_flight, sample_count)));
+
+	chunk_hierarchy hierarchy;
+	hierarchy.build(cloud.cache());
+
+	std::vector<deferred_ray> rays(slot_count);
+	std::vector<std::uint32_t> next_in_queue(slot_count); // 대기열(연결 리스트)에서 다음 반직선, 빈 슬롯 목록에서도 같은 배열을 사용함.
+	std::vector<std::uint32_t> queue_head(chunk_count, none);
+	std::vector<std::uint32_t> queue_size(chunk_count, 0);
+
+	const size_t ray_bytes = rays.capacity() * sizeof(deferred_ray) + next_in_queue.capacity() * sizeof(std::uint32_t)
+		+ (queue_head.capacity() + queue_size.capacity()) * sizeof(std::uint32_t);
+	cloud.set_memory_budget(options.memory_budget, ray_bytes + hierarchy.memory_bytes());
+
+	sphere_cloud_store& cache = cloud.cache();
+	out_of_core_stats local_stats;
+	local_stats.ray_bytes = ray_bytes;
+	local_stats.hierarchy_bytes = hierarchy.memory_bytes();
+
+	std::uint32_t free_head = none;
+	for (std::uint32_t s = slot_count; s-- > 0;)
+	{
+		next_in_queue[s] = free_head;
+		free_head = s;
+	}
+
+	framebuffer.assign(pixel_count, color(0, 0, 0));
+
+	auto release = [&](std::uint32_t id)
+	{
+		next_in_queue[id] = free_head;
+		free_head = id;
+	};
+
+	auto test_chunk = [&](deferred_ray& q, const sphere_cloud_chunk* chunk, std::uint32_t c)
+	{
+		hit_record rec;
+		bool hit = chunk ? chunk->hit(q.r, 0.001, q.rec.t, rec)
+						 : sphere_cloud_chunk::hit_spheres(cache.header(c).proxy, 1, q.r, 0.001, q.rec.t, rec);
+		if (hit) q.rec = rec;
+	};
+
+	// 반직선 id 를 더 이상 진행할 수 없을 때까지(끝나거나 대기열에 들어갈 때까지) 추적함.
+	// resume 이 true 면 대기열에서 꺼낸 반직선이므로, 메모리 안의 물체들과의 검사를 건너뛰고 청크 순회를 이어서 함.
+	auto trace = [&](std::uint32_t id, bool resume)
+	{
+		deferred_ray& q = rays[id];
+		while (true)
+		{
+			if (!resume)
+			{
+				if (q.depth <= 0) { release(id); return; } // ray_color() 와 마찬가지로 반사 횟수 제한을 넘으면 빛을 모으지 않음.
+
+				q.inv_dir = vec3(1.0 / q.r.direction().x(), 1.0 / q.r.direction().y(), 1.0 / q.r.direction().z());
+				if (!world.hit(q.r, 0.001, infinity, q.rec)) q.rec.t = infinity;
+				q.cursor_t = -infinity;
+				q.cursor_chunk = none;
+			}
+			resume = false;
+
+			// 충돌 지점보다 앞에 있는 청크들을 가까운 순서대로 검사함.
+			double t;
+			std::uint32_t c;
+			while (hierarchy.next(q.r, q.inv_dir, 0.001, q.rec.t, q.cursor_t, q.cursor_chunk, t, c))
+			{
+				q.cursor_t = t;
+				q.cursor_chunk = c;
+				if (cloud.uses_proxy(c)) { test_chunk(q, nullptr, c); continue; }
+
+				std::shared_ptr<const sphere_cloud_chunk> chunk = cache.try_acquire(c);
+				if (!chunk)
+				{
+					// 이 청크를 읽어올 때까지 기다림. (커서는 이미 이 청크를 가리키므로, 청크를 검사한 뒤에는 그 다음 청크부터 이어서 순회함.)
+					next_in_queue[id] = queue_head[c];
+					queue_head[c] = id;
+					++queue_size[c];
+					++local_stats.deferred_rays;
+					return;
+				}
+				test_chunk(q, chunk.get(), c);
+			}
+
+			// 모든 물체와의 검사가 끝났으므로 shade_hit() / shade_miss() 와 같은 방식으로 색상을 계산함.
+			color& pixel = framebuffer[q.pixel];
+			if (q.rec.t == infinity)
+			{
+				pixel += q.weight * settings.sky.at(q.r);
+				release(id);
+				return;
+			}
+			if (settings.shading == shading_mode::normal)
+			{
+				pixel += q.weight * (0.5 * color(q.rec.normal.x() + 1, q.rec.normal.y() + 1, q.rec.normal.z() + 1));
+				release(id);
+				return;
+			}
+
+			TRACE_COUNT(bounces, 1);
+			q.weight = q.weight * color(0.5, 0.5, 0.5);
+			q.r = ray(q.rec.p, q.rec.normal + random_unit_vector(), q.r.time());
+			--q.depth;
+		}
+	};
+
+	// 빈 슬롯이 있는 동안 아직 쏘지 않은 샘플의 반직선을 만들어서 추적함.
+	size_t next_sample = 0;
+	auto fill = [&]()
+	{
+		while (free_head != none && next_sample < sample_count)
+		{
+			const std::uint32_t id = free_head;
+			free_head = next_in_queue[id];
+
+			const size_t pixel = next_sample / spp;
+			const int s = static_cast<int>(next_sample % spp);
+			const int i = static_cast<int>(pixel % cam.image_width), j = static_cast<int>(pixel / cam.image_width);
+			++next_sample;
+
+			deferred_ray& q = rays[id];
+			q.r = (spp == 1) ? cam.get_ray(i, j) : cam.get_sample_ray(i, j, s, spp);
+			q.weight = color(1, 1, 1);
+			q.pixel = static_cast<std::uint32_t>(pixel);
+			q.depth = settings.max_depth;
+			trace(id, false);
+		}
+	};
+
+	while (true)
+	{
+		fill();
+
+		// 대기열이 가장 긴 청크를 골라서, 한 번 읽어온 청크로 기다리던 반직선들을 모두 처리함.
+		size_t largest = 0;
+		for (size_t c = 1; c < chunk_count; ++c)
+			if (queue_size[c] > queue_size[largest]) largest = c;
+		if (chunk_count == 0 || queue_size[largest] == 0) break; // 대기 중인 반직선이 없고 남은 샘플도 없음.
+
+		std::shared_ptr<const sphere_cloud_chunk> chunk = cache.acquire(largest);
+		std::uint32_t id = queue_head[largest];
+		++local_stats.chunk_batches;
+		local_stats.largest_batch = std::max<size_t>(local_stats.largest_batch, queue_size[largest]);
+		queue_head[largest] = none;
+		queue_size[largest] = 0;
+
+		while (id != none)
+		{
+			const std::uint32_t next = next_in_queue[id]; // trace() 가 next_in_queue[id] 를 덮어쓸 수 있으므로 먼저 읽어둠.
+			test_chunk(rays[id], chunk.get(), static_cast<std::uint32_t>(largest));
+			trace(id, true);
+			id = next;
+		}
+	}
+
+	for (color& c : framebuffer) c = c / spp;
+	if (stats) *stats = local_stats;
+}
+
+#endif // !OUT_OF_CORE_H
+
+/*
+	아웃 오브 코어 렌더링 (out-of-core rendering)
+
+
+	씬이 메모리보다 크면 씬 전체를 미리 올려둘 수 없으므로, 씬을 공간적으로 나눈 청크 단위로 디스크에 저장해두고
+	렌더링하는 동안 필요한 청크만 메모리에 올려야 함.
+
+	1. 청크와 두 단계의 계층 구조
+
+		청크마다 경계 상자만 항상 메모리에 두고, 이 상자들로 만든 BVH(chunk_hierarchy)로 반직선이 지나가는 청크들을 찾음.
+		청크 안의 구체들은 청크를 읽어올 때 그 청크만의 BVH(sphere_cloud_chunk)로 묶어서 교차 검사함.
+
+	2. LRU 캐시
+
+		읽어온 청크들의 크기(구체 데이터 + 청크 BVH)가 예산을 넘으면, 가장 오래 전에 사용한 청크부터 내보냄. (sphere_cloud_store)
+
+	3. 반직선 대기열
+
+		반직선이 닿는 순간 청크를 읽어오면, 예산이 작을 때 반직선마다 서로 다른 청크를 요구해서
+		같은 청크를 읽고 내보내기를 반복하게 됨. (난반사처럼 반직선 방향이 제각각일 때 특히 심함.)
+
+		그래서 메모리에 없는 청크에 닿은 반직선은 그 청크의 대기열에 넣고 다른 반직선을 먼저 추적한 뒤,
+		대기열이 가장 긴 청크부터 읽어서 기다리던 반직선들을 한꺼번에 처리함.
+		청크를 한 번 읽을 때 처리하는 반직선이 많아질수록 읽기 횟수가 줄어듦.
+
+		반직선은 청크들을 진입 t 순서로 검사하고, 이미 찾은 충돌 지점보다 뒤에 있는 청크는 검사하지 않음.
+		그래서 청크를 검사하는 순서가 메모리 안에서 렌더링할 때와 달라도 같은 충돌 지점을 찾게 됨.
+
+	동시에 추적하는 반직선이 많을수록 대기열이 길어져서 한 번에 처리하는 양이 늘지만,
+	반직선 상태도 같은 예산 안에서 메모리를 차지하므로 그만큼 캐시할 수 있는 청크가 줄어듦. (--ooc-bench --rays N 으로 비교해볼 수 있음.)
+*/
@@ -0,0 +1,371 @@
+#ifndef POSTPROCESS_H
+#define POSTPROCESS_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "color.h" // 후처리할 프레임버퍼의 픽셀 타입인 color 를 사용하기 위해 포함
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// SSE2 를 사용할 수 있는 환경(x64 빌드 또는 -msse2)에서만 SIMD 커널을 활성화함. (하단 필기 'SIMD 커널' 참고)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define POSTPROCESS_USE_SSE2 1
+#endif
+
+// 프레임버퍼를 double 배열로 펼쳐서 처리하려면, vec3 가 패딩 없이 double 3개로만 이루어져 있어야 함.
+static_assert(sizeof(color) == 3 * sizeof(double), "color must be tightly packed");
+
+// 톤매핑 연산자 종류
+enum class tonemap_op
+{
+	none, // 톤매핑을 적용하지 않음
+	reinhard, // x / (1 + x)
+	aces // ACES filmic 커브 근사식 (Krzysztof Narkowicz 의 fitted curve)
+};
+
+// 선형 색 공간 -> 출력 색 공간 변환(감마 보정) 방식
+enum class gamma_mode
+{
+	linear, // 감마 보정을 하지 않음 (지금까지 write_color() 가 출력하던 방식)
+	srgb_exact, // 표준 sRGB 공식을 pow() 로 정확하게 계산
+	srgb_fast, // sqrt() 만으로 계산하는 근사식 (SIMD 커널 사용 가능)
+	srgb_lut // 미리 계산해 둔 룩업 테이블을 선형보간해서 사용
+};
+
+// 후처리 단계의 설정값을 모아둔 구조체
+struct postprocess_options
+{
+	double exposure = 1.0; // 톤매핑 전에 곱해줄 노출값
+	tonemap_op tonemap = tonemap_op::none;
+	gamma_mode gamma = gamma_mode::linear;
+	int bit_depth = 8; // 양자화 비트 수 (8 또는 16)
+	bool dither = false; // 양자화 시 4x4 Bayer 행렬로 ordered dithering 을 적용할 지 여부
+	bool use_simd = true; // false 면 스칼라 레퍼런스 경로만 사용 (SIMD 결과 검증용)
+};
+
+/*
+	스칼라 레퍼런스 구현
+
+	아래 함수들은 채널 하나의 값을 변환하는 가장 단순한 구현으로,
+	SIMD 커널의 결과가 허용 오차 내에 있는지 비교할 때 기준으로 사용함.
+
+	NaN 은 모든 비교 연산의 결과가 false 이므로, 비교 순서에 따라 NaN 이 그대로 남을 수도 있음.
+	SSE2 의 maxpd / minpd 는 피연산자 중 하나가 NaN 이면 두 번째 피연산자를 돌려주므로
+	_mm_max_pd(x, 0) 은 NaN 을 0 으로 바꾸는데, 스칼라 구현도 이와 같은 결과가 나오도록 비교 순서를 맞춤.
+	(NaN 인 채널은 검은색으로 출력됨.)
+*/
+inline double clamp01(double x)
+{
+	return x > 0.0 ? (x < 1.0 ? x : 1.0) : 0.0; // NaN 과 음수는 0
+}
+
+// 톤매핑 커브에 넣을 수 있는 가장 큰 값 (+Inf 가 Inf / Inf = NaN 이 되지 않도록 제한함.)
+const double tonemap_max_input = 1e30;
+
+// 톤매핑 전에 입력값을 [0, tonemap_max_input] 로 제한함. (NaN 과 음수는 0)
+/*
+	ACES 커브는 음수 구간에서 다시 양수가 되므로 (x = -1 이면 약 1.25), 음수 입력을 그대로 두면 흰색이 출력됨.
+*/
+inline double tonemap_input(double x)
+{
+	return x > 0.0 ? (x < tonemap_max_input ? x : tonemap_max_input) : 0.0;
+}
+
+inline double tonemap_reinhard(double x)
+{
+	x = tonemap_input(x);
+	return x / (1.0 + x);
+}
+
+inline double tonemap_aces(double x)
+{
+	x = tonemap_input(x);
+	return (x * (2.51 * x + 0.03)) / (x * (2.43 * x + 0.59) + 0.14);
+}
+
+inline double linear_to_srgb_exact(double x)
+{
+	return (x <= 0.0031308) ? 12.92 * x : 1.055 * std::pow(x, 1.0 / 2.4) - 0.055;
+}
+
+// x^(1/2.4) 를 x^(1/2), x^(1/4), x^(1/8) 의 선형결합으로 근사한 식 (0 ~ 1 구간에서 최대 오차 약 1e-3)
+inline double linear_to_srgb_fast(double x)
+{
+	if (x <= 0.0031308) return 12.92 * x;
+
+	double s1 = sqrt(x);
+	double s2 = sqrt(s1);
+	double s3 = sqrt(s2);
+	return 0.662002687 * s1 + 0.684122060 * s2 - 0.323583601 * s3 - 0.0225411470 * x;
+}
+
+// sRGB 룩업 테이블 (0 ~ 1 구간을 4096 칸으로 나눠 정확한 값을 미리 계산해 둠)
+inline const std::vector<double>& srgb_lut()
+{
+	// 함수 내 static 지역변수는 처음 호출될 때 한 번만 초기화됨.
+	static const std::vector<double> table = []()
+	{
+		std::vector<double> t(4097);
+		for (std::size_t i = 0; i < t.size(); ++i)
+			t[i] = linear_to_srgb_exact(static_cast<double>(i) / 4096.0);
+		return t;
+	}();
+	return table;
+}
+
+inline double linear_to_srgb_lut(double x)
+{
+	const std::vector<double>& table = srgb_lut();
+	double f = clamp01(x) * 4096.0;
+	std::size_t i = static_cast<std::size_t>(f);
+	if (i >= 4096) return table[4096];
+
+	// 인접한 두 테이블 값을 선형보간
+	double w = f - static_cast<double>(i);
+	return table[i] + w * (table[i + 1] - table[i]);
+}
+
+/*
+	버퍼 단위 커널
+
+	프레임버퍼의 모든 채널 값은 double 배열로 연속해서 저장되어 있으므로,
+	(r, g, b, r, g, b, ...) 순서에 상관없이 채널별로 동일한 연산을 적용하면 됨.
+	SSE2 에서는 __m128d 레지스터 하나에 double 2개씩 담아서 처리함.
+*/
+inline void apply_exposure(double* data, std::size_t n, double exposure, bool use_simd)
+{
+	std::size_t i = 0;
+#ifdef POSTPROCESS_USE_SSE2
+	if (use_simd)
+	{
+		const __m128d e = _mm_set1_pd(exposure);
+		for (; i + 2 <= n; i += 2)
+			_mm_storeu_pd(data + i, _mm_mul_pd(_mm_loadu_pd(data + i), e));
+	}
+#endif
+	for (; i < n; ++i) data[i] *= exposure;
+}
+
+inline void apply_tonemap(double* data, std::size_t n, tonemap_op op, bool use_simd)
+{
+	if (op == tonemap_op::none) return;
+
+	std::size_t i = 0;
+#ifdef POSTPROCESS_USE_SSE2
+	if (use_simd)
+	{
+		const __m128d one = _mm_set1_pd(1.0);
+		const __m128d a = _mm_set1_pd(2.51), b = _mm_set1_pd(0.03);
+		const __m128d c = _mm_set1_pd(2.43), d = _mm_set1_pd(0.59), e = _mm_set1_pd(0.14);
+		const __m128d zero = _mm_setzero_pd(), max_input = _mm_set1_pd(tonemap_max_input);
+		for (; i + 2 <= n; i += 2)
+		{
+			// tonemap_input() 과 같은 계산 (x 가 NaN 이면 _mm_max_pd 가 두 번째 피연산자인 0 을 돌려줌.)
+			__m128d x = _mm_min_pd(_mm_max_pd(_mm_loadu_pd(data + i), zero), max_input);
+			__m128d y;
+			if (op == tonemap_op::reinhard)
+			{
+				y = _mm_div_pd(x, _mm_add_pd(one, x));
+			}
+			else
+			{
+				__m128d num = _mm_mul_pd(x, _mm_add_pd(_mm_mul_pd(a, x), b));
+				__m128d den = _mm_add_pd(_mm_mul_pd(x, _mm_add_pd(_mm_mul_pd(c, x), d)), e);
+				y = _mm_div_pd(num, den);
+			}
+			_mm_storeu_pd(data + i, y);
+		}
+	}
+#endif
+	for (; i < n; ++i)
+		data[i] = (op == tonemap_op::reinhard) ? tonemap_reinhard(data[i]) : tonemap_aces(data[i]);
+}
+
+inline void apply_clamp(double* data, std::size_t n, bool use_simd)
+{
+	std::size_t i = 0;
+#ifdef POSTPROCESS_USE_SSE2
+	if (use_simd)
+	{
+		const __m128d lo = _mm_setzero_pd(), hi = _mm_set1_pd(1.0);
+		for (; i + 2 <= n; i += 2)
+			_mm_storeu_pd(data + i, _mm_min_pd(_mm_max_pd(_mm_loadu_pd(data + i), lo), hi));
+	}
+#endif
+	for (; i < n; ++i) data[i] = clamp01(data[i]);
+}
+
+inline void apply_gamma(double* data, std::size_t n, gamma_mode mode, bool use_simd)
+{
+	std::size_t i = 0;
+	switch (mode)
+	{
+	case gamma_mode::linear:
+		return;
+	case gamma_mode::srgb_exact:
+		for (; i < n; ++i) data[i] = linear_to_srgb_exact(data[i]);
+		return;
+	case gamma_mode::srgb_lut:
+		// SSE2 에는 gather 명령이 없으므로 룩업 테이블 경로는 스칼라로만 처리함.
+		for (; i < n; ++i) data[i] = linear_to_srgb_lut(data[i]);
+		return;
+	case gamma_mode::srgb_fast:
+#ifdef POSTPROCESS_USE_SSE2
+		if (use_simd)
+		{
+			const __m128d threshold = _mm_set1_pd(0.0031308);
+			const __m128d slope = _mm_set1_pd(12.92);
+			const __m128d k1 = _mm_set1_pd(0.662002687), k2 = _mm_set1_pd(0.684122060);
+			const __m128d k3 = _mm_set1_pd(0.323583601), k4 = _mm_set1_pd(0.0225411470);
+			for (; i + 2 <= n; i += 2)
+			{
+				__m128d x = _mm_max_pd(_mm_loadu_pd(data + i), _mm_setzero_pd());
+				__m128d s1 = _mm_sqrt_pd(x);
+				__m128d s2 = _mm_sqrt_pd(s1);
+				__m128d s3 = _mm_sqrt_pd(s2);
+				__m128d curve = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(k1, s1), _mm_mul_pd(k2, s2)),
+										   _mm_add_pd(_mm_mul_pd(k3, s3), _mm_mul_pd(k4, x)));
+
+				// 분기 대신 비교 마스크로 선형 구간과 커브 구간의 결과를 골라냄
+				__m128d mask = _mm_cmple_pd(x, threshold);
+				__m128d y = _mm_or_pd(_mm_and_pd(mask, _mm_mul_pd(slope, x)), _mm_andnot_pd(mask, curve));
+				_mm_storeu_pd(data + i, y);
+			}
+		}
+#endif
+		for (; i < n; ++i) data[i] = linear_to_srgb_fast(data[i] > 0.0 ? data[i] : 0.0); // NaN 도 _mm_max_pd 와 같이 0 으로 바꿈.
+		return;
+	}
+}
+
+// 명령줄 인자, 배치 매니페스트의 이름을 설정값으로 바꿈. (알 수 없는 이름이면 false 를 반환하고 값을 바꾸지 않음.)
+inline bool parse_tonemap(const std::string& name, tonemap_op& op)
+{
+	if (name == "none") op = tonemap_op::none;
+	else if (name == "reinhard") op = tonemap_op::reinhard;
+	else if (name == "aces") op = tonemap_op::aces;
+	else return false;
+	return true;
+}
+
+inline bool parse_gamma(const std::string& name, gamma_mode& mode)
+{
+	if (name == "linear") mode = gamma_mode::linear;
+	else if (name == "srgb") mode = gamma_mode::srgb_exact;
+	else if (name == "fast") mode = gamma_mode::srgb_fast;
+	else if (name == "lut") mode = gamma_mode::srgb_lut;
+	else return false;
+	return true;
+}
+
+// 양자화된 버퍼를 .ppm 으로 출력할 때의 최댓값
+inline int output_maxval(const postprocess_options& opt)
+{
+	return (opt.bit_depth > 8) ? 65535 : 255;
+}
+
+// 선형 색 공간의 프레임버퍼 전체에 노출 -> 톤매핑 -> 클램핑 -> 감마 보정을 순서대로 적용함.
+inline void postprocess(std::vector<color>& buffer, const postprocess_options& opt)
+{
+	if (buffer.empty()) return;
+
+	double* data = &buffer[0].e[0];
+	std::size_t n = buffer.size() * 3;
+
+	if (opt.exposure != 1.0) apply_exposure(data, n, opt.exposure, opt.use_simd);
+	apply_tonemap(data, n, opt.tonemap, opt.use_simd);
+	apply_clamp(data, n, opt.use_simd);
+	apply_gamma(data, n, opt.gamma, opt.use_simd);
+}
+
+// 4x4 Bayer 행렬 (ordered dithering 에 사용할 임계값)
+inline double bayer4x4(int i, int j)
+{
+	static const int m[4][4] = {
+		{ 0,  8,  2, 10 },
+		{ 12, 4, 14,  6 },
+		{ 3, 11,  1,  9 },
+		{ 15, 7, 13,  5 }
+	};
+	return (m[j & 3][i & 3] + 0.5) / 16.0;
+}
+
+/*
+	0 ~ 1 로 클램핑된 프레임버퍼를 정수형 채널 값으로 양자화
+
+	디더링을 끄면, 기존 write_color() 와 동일하게
+	(최댓값 + 0.999) 를 곱한 뒤 소수점을 버리는 방식으로 계산함.
+	디더링을 켜면, 최댓값을 곱한 뒤 픽셀 위치별 Bayer 임계값을 더하고 소수점을 버림.
+*/
+inline std::vector<std::uint16_t> quantize(const std::vector<color>& buffer, int width, int height, const postprocess_options& opt)
+{
+	const int maxval = output_maxval(opt);
+	std::vector<std::uint16_t> out(buffer.size() * 3);
+	if (buffer.empty()) return out;
+
+	const double* data = &buffer[0].e[0];
+	const double scale = opt.dither ? maxval : maxval + 0.999;
+
+	for (int j = 0; j < height; ++j)
+	{
+		std::size_t row = static_cast<std::size_t>(j) * width * 3;
+		std::size_t row_end = row + static_cast<std::size_t>(width) * 3;
+		std::size_t k = row;
+
+#ifdef POSTPROCESS_USE_SSE2
+		// 디더링이 없는 경우에는 픽셀 위치와 무관하므로 double 2개씩 곱해서 정수로 잘라냄
+		if (opt.use_simd && !opt.dither)
+		{
+			const __m128d s = _mm_set1_pd(scale);
+			for (; k + 2 <= row_end; k += 2)
+			{
+				__m128i q = _mm_cvttpd_epi32(_mm_mul_pd(_mm_loadu_pd(data + k), s));
+				out[k] = static_cast<std::uint16_t>(_mm_cvtsi128_si32(q));
+				out[k + 1] = static_cast<std::uint16_t>(_mm_cvtsi128_si32(_mm_srli_si128(q, 4)));
+			}
+		}
+#endif
+		for (; k < row_end; ++k)
+		{
+			int i = static_cast<int>((k - row) / 3);
+			double offset = opt.dither ? bayer4x4(i, j) : 0.0;
+			int q = static_cast<int>(data[k] * scale + offset);
+			out[k] = static_cast<std::uint16_t>(std::min(q, maxval));
+		}
+	}
+
+	return out;
+}
+
+#endif // !POSTPROCESS_H
+
+/*
+	SIMD 커널
+
+
+	기존의 write_color() 는 픽셀 하나를 출력할 때마다
+	각 채널에 255.999 를 곱하고 int 로 형변환하는 작업을 반복했음.
+
+	감마 보정, 톤매핑, 클램핑 같은 후처리가 추가되면
+	이 작업들이 모든 픽셀마다 반복되므로, 큰 이미지에서는 무시할 수 없는 비용이 됨.
+
+	그래서 렌더링 루프에서는 선형 색상값을 프레임버퍼에 모아두기만 하고,
+	렌더링이 끝난 뒤 버퍼 전체를 한 번에 처리하도록 분리한 것임.
+
+	버퍼 전체를 처리하면 같은 연산을 연속된 메모리에 반복 적용하게 되므로,
+	SSE2 의 __m128d 레지스터로 double 2개를 한 번에 계산할 수 있음.
+
+	이때, 각 SIMD 커널에는 동일한 계산을 하는 스칼라 구현이 항상 함께 있는데,
+	하나는 SIMD 레지스터 크기로 나누어 떨어지지 않고 남는 요소들을 처리하기 위함이고,
+	다른 하나는 postprocess_options::use_simd 를 false 로 두어
+	SIMD 결과를 스칼라 레퍼런스와 비교할 수 있도록 하기 위함임.
+	(--postprocess-check 가 모든 설정 조합에 대해 두 경로의 결과를 비교함.)
+
+	두 경로는 NaN, Inf, 음수 입력에 대해서도 같은 결과를 내야 함.
+	NaN 은 비교 연산의 순서에 따라 결과가 달라지므로, 스칼라 구현의 비교 순서를 maxpd / minpd 의 동작에 맞춰두었음.
+*/
@@ -0,0 +1,560 @@
+#ifndef PREVIEW_SERVER_H
+#define PREVIEW_SERVER_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "camera.h" // 프리뷰 도중에 소켓으로 전달받은 값으로 카메라를 갱신하기 위해 포함
+#include "color.h"
+#include "postprocess.h" // 타일을 8비트로 양자화할 때 clamp01() 을 사용하기 위해 포함
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// 운영체제별 소켓 API 차이를 감춰주는 최소한의 래퍼 (하단 필기 '소켓 API' 참고)
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX // windows.h 의 min / max 매크로가 std::min / std::max 와 충돌하지 않도록 함.
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+using socket_t = SOCKET;
+const socket_t invalid_socket = INVALID_SOCKET;
+inline void close_socket(socket_t s) { closesocket(s); }
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+using socket_t = int;
+const socket_t invalid_socket = -1;
+inline void close_socket(socket_t s) { close(s); }
+#endif
+
+// 카메라 이외의 씬 파라미터들을 "이름 = 값" 형태로 저장해서 셰이딩 함수에 전달하는 구조체
+struct preview_params
+{
+	std::map<std::string, double> values;
+
+	// 이름에 해당하는 값이 없으면 fallback 을 반환함.
+	double get(const std::string& key, double fallback) const
+	{
+		auto it = values.find(key);
+		return (it != values.end()) ? it->second : fallback;
+	}
+};
+
+// 렌더링 중인 프레임버퍼를 localhost HTTP 엔드포인트로 스트리밍하는 프리뷰 서버 클래스
+/*
+	GET /                 : 캔버스에 프레임을 그려주는 뷰어 페이지
+	GET /tiles?since=N    : 버전 N 이후로 변경된 타일들만 RLE 로 압축해서 반환 (변경이 없으면 잠시 대기하는 long polling)
+	GET /update?x=0&z=1.. : 카메라(x, y, z, focal_length, viewport_height) 또는 씬 파라미터를 갱신하고 렌더링을 재시작
+	GET /quit             : 서버 종료
+
+	요청마다 스레드를 따로 만들어서 처리하므로, /tiles 요청이 새 타일을 기다리는 동안에도 /update 가 곧바로 처리됨.
+*/
+class preview_server
+{
+public:
+	// 카메라, 픽셀 좌표, 씬 파라미터를 입력받아 픽셀 색상을 반환하는 셰이딩 함수 타입
+	using shade_function = std::function<color(const camera&, int, int, const preview_params&)>;
+
+	// 새 파라미터로 첫 패스를 렌더링하기 전에 한 번 호출되는 함수 타입
+	/*
+		파라미터를 렌더링 설정값으로 옮겨두는 용도로, 픽셀마다 map 에서 값을 찾지 않도록 하기 위함임.
+		렌더링 스레드에서 패스 사이에 호출되므로, 이 함수가 바꾼 값을 셰이딩 함수에서 잠금 없이 읽어도 됨.
+	*/
+	using prepare_function = std::function<void(const preview_params&)>;
+
+	int port = 8080; // 127.0.0.1 에서 listen 할 포트 번호
+	int tile_size = 16; // 타일 한 변의 픽셀 수
+	int thread_count = 0; // 렌더링 스레드 개수 (0 이면 std::thread::hardware_concurrency() 사용)
+	prepare_function prepare; // 비어있으면 호출하지 않음
+
+	preview_server(const camera& _cam, shade_function _shade) : cam(_cam), shade(std::move(_shade))
+	{
+		cam.initialize();
+	}
+
+	// 렌더링 스레드를 시작하고, /quit 요청을 받을 때까지 HTTP 요청을 처리함.
+	void run()
+	{
+		tiles_x = (cam.image_width + tile_size - 1) / tile_size;
+		tiles_y = (cam.image_height + tile_size - 1) / tile_size;
+		pixels.assign(static_cast<size_t>(cam.image_width) * cam.image_height * 3, 0);
+		tile_versions.assign(static_cast<size_t>(tiles_x) * tiles_y, 0);
+
+#ifdef _WIN32
+		WSADATA wsa;
+		WSAStartup(MAKEWORD(2, 2), &wsa);
+#endif
+		socket_t listener = open_listener();
+		if (listener == invalid_socket)
+		{
+			std::cerr << "Preview server: failed to listen on port " << port << '\n';
+			return;
+		}
+
+		std::clog << "Preview server listening on http://127.0.0.1:" << port << "/\n";
+		std::thread renderer(&preview_server::render_loop, this);
+
+		while (true)
+		{
+			socket_t client = accept(listener, nullptr, nullptr);
+			if (stopping)
+			{
+				// /quit 을 처리한 스레드가 wake_listener() 로 접속해서 accept() 를 깨운 것임.
+				if (client != invalid_socket) close_socket(client);
+				break;
+			}
+			if (client == invalid_socket) continue;
+
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				++active_clients;
+			}
+			std::thread([this, client]()
+			{
+				handle_client(client);
+				close_socket(client);
+
+				std::lock_guard<std::mutex> lock(mtx);
+				--active_clients;
+				clients_cv.notify_all();
+			}).detach();
+		}
+
+		// 처리 중인 요청들이 모두 끝난 뒤에 멤버 변수들을 정리함. (long polling 중인 요청은 stopping 을 보고 곧바로 깨어남.)
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			clients_cv.wait(lock, [this]() { return active_clients == 0; });
+		}
+		renderer.join();
+		close_socket(listener);
+#ifdef _WIN32
+		WSACleanup();
+#endif
+	}
+
+	// 카메라 또는 씬 파라미터를 갱신함. 진행 중인 타일들은 취소되고 가장 낮은 해상도의 패스부터 다시 렌더링함.
+	void update(const std::map<std::string, std::string>& query)
+	{
+		std::lock_guard<std::mutex> lock(mtx);
+		for (const auto& kv : query)
+		{
+			double value = std::atof(kv.second.c_str());
+			if (kv.first == "x") cam.center[0] = value;
+			else if (kv.first == "y") cam.center[1] = value;
+			else if (kv.first == "z") cam.center[2] = value;
+			else if (kv.first == "focal_length") cam.focal_length = value;
+			else if (kv.first == "viewport_height") cam.viewport_height = value;
+			else params.values[kv.first] = value;
+		}
+		cam.initialize();
+
+		++generation; // 렌더링 스레드들은 이 값이 바뀐 것을 보고 진행 중인 타일을 중단함.
+		render_cv.notify_all();
+	}
+
+private:
+	camera cam;
+	shade_function shade;
+	preview_params params;
+
+	std::mutex mtx;
+	std::condition_variable render_cv; // 렌더링을 다시 시작해야 할 때 렌더링 스레드를 깨움
+	std::condition_variable frame_cv; // 타일이 갱신되었을 때 long polling 중인 요청을 깨움
+	std::condition_variable clients_cv; // 요청 처리 스레드가 끝날 때마다 run() 을 깨움
+	int active_clients = 0; // 처리 중인 요청의 개수
+	std::atomic<unsigned> generation{ 1 }; // 카메라 / 씬 파라미터가 바뀔 때마다 증가하는 값
+	unsigned rendered_generation = 0; // 모든 패스를 끝까지 렌더링한 generation
+	std::atomic<bool> stopping{ false };
+
+	int tiles_x = 0;
+	int tiles_y = 0;
+	std::vector<std::uint8_t> pixels; // 뷰어에 전송할 8비트 RGB 프레임버퍼
+	std::vector<std::uint32_t> tile_versions; // 각 타일이 마지막으로 갱신되었을 때의 프레임 버전
+	std::uint32_t version = 0; // 타일이 갱신될 때마다 1씩 증가하는 프레임 버전
+
+	// 파라미터가 바뀔 때마다 8x8 블록 -> 4x4 -> 2x2 -> 1x1 순서로 점점 세밀한 패스를 렌더링함.
+	void render_loop()
+	{
+		while (true)
+		{
+			std::unique_lock<std::mutex> lock(mtx);
+			render_cv.wait(lock, [this]() { return stopping || generation != rendered_generation; });
+			if (stopping) return;
+
+			// 렌더링 도중에 파라미터가 바뀌어도 영향을 받지 않도록 현재 값들을 복사해 둠.
+			unsigned gen = generation;
+			camera snapshot = cam;
+			preview_params snapshot_params = params;
+			lock.unlock();
+
+			if (prepare) prepare(snapshot_params);
+
+			bool completed = true;
+			for (int block : { 8, 4, 2, 1 })
+			{
+				if (!render_pass(gen, snapshot, snapshot_params, block))
+				{
+					completed = false;
+					break;
+				}
+			}
+
+			lock.lock();
+			if (completed && generation == gen) rendered_generation = gen;
+		}
+	}
+
+	// 하나의 패스를 여러 스레드로 나눠서 타일 단위로 렌더링함. 도중에 취소되면 false 반환.
+	bool render_pass(unsigned gen, const camera& c, const preview_params& p, int block)
+	{
+		int workers = thread_count > 0 ? thread_count : static_cast<int>(std::thread::hardware_concurrency());
+		workers = std::max(workers, 1);
+
+		std::atomic<int> next_tile{ 0 };
+		std::atomic<bool> cancelled{ false };
+		auto work = [&]()
+		{
+			std::vector<std::uint8_t> tile;
+			int t;
+			while (!cancelled && (t = next_tile.fetch_add(1)) < tiles_x * tiles_y)
+			{
+				if (!render_tile(gen, c, p, block, t, tile)) cancelled = true;
+			}
+		};
+
+		std::vector<std::thread> threads;
+		for (int k = 1; k < workers; ++k) threads.emplace_back(work);
+		work();
+		for (auto& th : threads) th.join();
+
+		return !cancelled;
+	}
+
+	// 타일 하나를 block x block 크기의 블록 단위로 렌더링한 뒤 프레임버퍼에 복사함.
+	bool render_tile(unsigned gen, const camera& c, const preview_params& p, int block, int t, std::vector<std::uint8_t>& tile)
+	{
+		int x0 = (t % tiles_x) * tile_size, y0 = (t / tiles_x) * tile_size;
+		int w = std::min(tile_size, c.image_width - x0), h = std::min(tile_size, c.image_height - y0);
+		tile.assign(static_cast<size_t>(w) * h * 3, 0);
+
+		for (int by = 0; by < h; by += block)
+		{
+			// 블록 한 줄을 처리할 때마다 파라미터가 바뀌었는지 확인해서 빠르게 취소함.
+			if (generation != gen || stopping) return false;
+
+			for (int bx = 0; bx < w; bx += block)
+			{
+				// 블록의 좌상단 픽셀 하나만 셰이딩하고, 그 색상으로 블록 전체를 채움.
+				color pixel_color = shade(c, x0 + bx, y0 + by, p);
+				std::uint8_t rgb[3];
+				for (int k = 0; k < 3; ++k) rgb[k] = static_cast<std::uint8_t>(255.999 * clamp01(pixel_color[k]));
+
+				for (int y = by; y < std::min(by + block, h); ++y)
+					for (int x = bx; x < std::min(bx + block, w); ++x)
+						std::copy(rgb, rgb + 3, tile.begin() + (static_cast<size_t>(y) * w + x) * 3);
+			}
+		}
+
+		std::lock_guard<std::mutex> lock(mtx);
+		if (generation != gen) return false; // 이전 파라미터로 렌더링된 타일이 프레임버퍼를 덮어쓰지 않도록 함.
+		for (int y = 0; y < h; ++y)
+		{
+			std::copy(tile.begin() + static_cast<size_t>(y) * w * 3, tile.begin() + static_cast<size_t>(y + 1) * w * 3,
+					  pixels.begin() + (static_cast<size_t>(y0 + y) * c.image_width + x0) * 3);
+		}
+		tile_versions[t] = ++version;
+		frame_cv.notify_all();
+		return true;
+	}
+
+	socket_t open_listener()
+	{
+		socket_t s = socket(AF_INET, SOCK_STREAM, 0);
+		if (s == invalid_socket) return invalid_socket;
+
+		int reuse = 1;
+		setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(static_cast<unsigned short>(port));
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK); // 외부에는 노출하지 않고 localhost 에서만 접속 가능
+
+		if (bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || listen(s, 16) != 0)
+		{
+			close_socket(s);
+			return invalid_socket;
+		}
+		return s;
+	}
+
+	// 서버 자신에게 접속했다가 바로 끊어서, accept() 에서 대기 중인 run() 을 깨움.
+	void wake_listener()
+	{
+		socket_t s = socket(AF_INET, SOCK_STREAM, 0);
+		if (s == invalid_socket) return;
+
+		sockaddr_in addr{};
+		addr.sin_family = AF_INET;
+		addr.sin_port = htons(static_cast<unsigned short>(port));
+		addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		connect(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+		close_socket(s);
+	}
+
+	void handle_client(socket_t client)
+	{
+		// 요청 헤더의 끝(빈 줄)까지만 읽고, 첫 줄("GET /path?query HTTP/1.1")에서 경로와 쿼리를 꺼냄.
+		std::string request;
+		char buf[1024];
+		while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+		{
+			int n = static_cast<int>(recv(client, buf, sizeof(buf), 0));
+			if (n <= 0) break;
+			request.append(buf, n);
+		}
+
+		size_t start = request.find(' ');
+		size_t end = request.find(' ', start + 1);
+		if (start == std::string::npos || end == std::string::npos) return;
+
+		std::string target = request.substr(start + 1, end - start - 1);
+		size_t q = target.find('?');
+		std::string path = target.substr(0, q);
+		auto query = parse_query(q == std::string::npos ? std::string() : target.substr(q + 1));
+
+		if (path == "/")
+		{
+			send_response(client, "200 OK", "text/html; charset=utf-8", viewer_page());
+		}
+		else if (path == "/tiles")
+		{
+			auto it = query.find("since");
+			std::uint32_t since = (it != query.end()) ? static_cast<std::uint32_t>(std::strtoul(it->second.c_str(), nullptr, 10)) : 0;
+			send_response(client, "200 OK", "application/octet-stream", encode_tiles(since));
+		}
+		else if (path == "/update")
+		{
+			update(query);
+			send_response(client, "200 OK", "text/plain", "ok");
+		}
+		else if (path == "/quit")
+		{
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				stopping = true;
+			}
+			render_cv.notify_all();
+			frame_cv.notify_all();
+			send_response(client, "200 OK", "text/plain", "bye");
+			wake_listener();
+		}
+		else
+		{
+			send_response(client, "404 Not Found", "text/plain", "not found");
+		}
+	}
+
+	// since 이후로 갱신된 타일들만 골라서 바이너리로 인코딩함. (하단 필기 '타일 델타 포맷' 참고)
+	std::string encode_tiles(std::uint32_t since)
+	{
+		std::unique_lock<std::mutex> lock(mtx);
+
+		// 갱신된 타일이 없으면 최대 250ms 동안 기다려서, 뷰어가 불필요하게 요청을 반복하지 않도록 함.
+		frame_cv.wait_for(lock, std::chrono::milliseconds(250), [&]() { return stopping || version > since; });
+
+		std::string out;
+		std::uint32_t count = 0;
+		put_u32(out, static_cast<std::uint32_t>(cam.image_width));
+		put_u32(out, static_cast<std::uint32_t>(cam.image_height));
+		put_u32(out, version);
+		put_u32(out, 0); // 타일 개수는 마지막에 채워넣음
+
+		for (int t = 0; t < tiles_x * tiles_y; ++t)
+		{
+			if (tile_versions[t] <= since) continue;
+
+			int x0 = (t % tiles_x) * tile_size, y0 = (t / tiles_x) * tile_size;
+			int w = std::min(tile_size, cam.image_width - x0), h = std::min(tile_size, cam.image_height - y0);
+			put_u16(out, static_cast<std::uint16_t>(x0));
+			put_u16(out, static_cast<std::uint16_t>(y0));
+			put_u16(out, static_cast<std::uint16_t>(w));
+			put_u16(out, static_cast<std::uint16_t>(h));
+
+			// 같은 색상이 연속되는 픽셀들을 (개수, r, g, b) 4바이트로 압축함.
+			// 특히 낮은 해상도 패스에서는 블록 단위로 같은 색이 반복되므로 압축률이 높음.
+			std::string rle;
+			for (int y = 0; y < h; ++y)
+			{
+				const std::uint8_t* row = &pixels[(static_cast<size_t>(y0 + y) * cam.image_width + x0) * 3];
+				for (int x = 0; x < w;)
+				{
+					int run = 1;
+					while (x + run < w && run < 255 && std::equal(row + x * 3, row + x * 3 + 3, row + (x + run) * 3)) ++run;
+					rle.push_back(static_cast<char>(run));
+					rle.append(reinterpret_cast<const char*>(row + x * 3), 3);
+					x += run;
+				}
+			}
+			put_u32(out, static_cast<std::uint32_t>(rle.size()));
+			out += rle;
+			++count;
+		}
+
+		for (int k = 0; k < 4; ++k) out[12 + k] = static_cast<char>((count >> (8 * k)) & 0xff);
+		return out;
+	}
+
+	static void put_u16(std::string& out, std::uint16_t v)
+	{
+		out.push_back(static_cast<char>(v & 0xff));
+		out.push_back(static_cast<char>(v >> 8));
+	}
+
+	static void put_u32(std::string& out, std::uint32_t v)
+	{
+		for (int k = 0; k < 4; ++k) out.push_back(static_cast<char>((v >> (8 * k)) & 0xff));
+	}
+
+	static std::map<std::string, std::string> parse_query(const std::string& query)
+	{
+		std::map<std::string, std::string> result;
+		size_t pos = 0;
+		while (pos < query.size())
+		{
+			size_t amp = query.find('&', pos);
+			std::string pair = query.substr(pos, amp == std::string::npos ? std::string::npos : amp - pos);
+			size_t eq = pair.find('=');
+			if (eq != std::string::npos) result[pair.substr(0, eq)] = url_decode(pair.substr(eq + 1));
+			if (amp == std::string::npos) break;
+			pos = amp + 1;
+		}
+		return result;
+	}
+
+	static std::string url_decode(const std::string& s)
+	{
+		std::string out;
+		for (size_t k = 0; k < s.size(); ++k)
+		{
+			if (s[k] == '+') out.push_back(' ');
+			else if (s[k] == '%' && k + 2 < s.size())
+			{
+				out.push_back(static_cast<char>(std::strtol(s.substr(k + 1, 2).c_str(), nullptr, 16)));
+				k += 2;
+			}
+			else out.push_back(s[k]);
+		}
+		return out;
+	}
+
+	static void send_response(socket_t client, const std::string& status, const std::string& type, const std::string& body)
+	{
+		std::string response = "HTTP/1.1 " + status + "\r\nContent-Type: " + type
+			+ "\r\nContent-Length: " + std::to_string(body.size())
+			+ "\r\nCache-Control: no-store\r\nConnection: close\r\n\r\n" + body;
+
+		size_t sent = 0;
+		while (sent < response.size())
+		{
+#ifdef MSG_NOSIGNAL
+			int n = static_cast<int>(send(client, response.data() + sent, static_cast<int>(response.size() - sent), MSG_NOSIGNAL));
+#else
+			int n = static_cast<int>(send(client, response.data() + sent, static_cast<int>(response.size() - sent), 0));
+#endif
+			if (n <= 0) return;
+			sent += n;
+		}
+	}
+
+	std::string viewer_page() const
+	{
+		return std::string(R"html(<!doctype html>
+<html><head><title>raytracing preview</title>
+<style>body{background:#222;color:#ddd;font-family:sans-serif}canvas{image-rendering:pixelated;width:800px;border:1px solid #555}</style>
+</head><body>
+<canvas id="c" width=")html") + std::to_string(cam.image_width) + R"html(" height=")html" + std::to_string(cam.image_height) + R"html("></canvas>
+<form id="f">
+x <input name="x" value="0" size="4"> y <input name="y" value="0" size="4"> z <input name="z" value="0" size="4">
+focal_length <input name="focal_length" value="1" size="4"> viewport_height <input name="viewport_height" value="2" size="4">
+params <input name="extra" placeholder="spp=4&amp;depth=10&amp;diffuse=1&amp;sky_top_r=0.5" size="36"> <button>update</button>
+</form>
+<script>
+const ctx = document.getElementById('c').getContext('2d');
+let since = 0;
+function draw(buf) {
+  const v = new DataView(buf);
+  since = v.getUint32(8, true);
+  const n = v.getUint32(12, true);
+  let o = 16;
+  for (let t = 0; t < n; t++) {
+    const x = v.getUint16(o, true), y = v.getUint16(o + 2, true), w = v.getUint16(o + 4, true), h = v.getUint16(o + 6, true);
+    const end = o + 12 + v.getUint32(o + 8, true);
+    const img = ctx.createImageData(w, h);
+    let p = 0;
+    for (o += 12; o < end; o += 4) {
+      for (let k = 0; k < v.getUint8(o); k++) {
+        img.data[p++] = v.getUint8(o + 1); img.data[p++] = v.getUint8(o + 2); img.data[p++] = v.getUint8(o + 3); img.data[p++] = 255;
+      }
+    }
+    ctx.putImageData(img, x, y);
+  }
+}
+async function poll() {
+  try { draw(await (await fetch('/tiles?since=' + since)).arrayBuffer()); }
+  catch (e) { await new Promise(r => setTimeout(r, 1000)); }
+  poll();
+}
+document.getElementById('f').onsubmit = e => {
+  e.preventDefault();
+  const d = new FormData(e.target);
+  const extra = d.get('extra'); d.delete('extra');
+  fetch('/update?' + new URLSearchParams(d).toString() + (extra ? '&' + extra : ''));
+};
+poll();
+</script></body></html>
+)html";
+	}
+};
+
+#endif // !PREVIEW_SERVER_H
+
+/*
+	소켓 API
+
+
+	Windows 의 Winsock 과 POSIX(Linux, macOS) 소켓은 함수 이름과 사용법이 거의 같지만,
+	소켓 핸들 타입(SOCKET vs int), 소켓을 닫는 함수(closesocket() vs close()),
+	그리고 Winsock 은 사용 전후에 WSAStartup() / WSACleanup() 을 호출해야 한다는 점이 다름.
+
+	그래서 전처리기로 운영체제를 구분해서
+	socket_t, invalid_socket, close_socket() 만 따로 정의해두고,
+	나머지 코드는 공통으로 사용하도록 한 것임.
+
+
+	타일 델타 포맷
+
+
+	/tiles 응답은 아래와 같은 little-endian 바이너리로 구성됨.
+
+	[u32 이미지 너비][u32 이미지 높이][u32 현재 프레임 버전][u32 타일 개수]
+	타일 개수만큼 반복: [u16 x][u16 y][u16 w][u16 h][u32 압축된 바이트 수][(u8 개수, u8 r, u8 g, u8 b) ...]
+
+	뷰어는 응답으로 받은 프레임 버전을 기억해 뒀다가
+	다음 요청의 since 로 다시 전달하기 때문에,
+	이전 요청 이후로 실제로 다시 렌더링된 타일들만 전송받게 됨.
+*/
@@ -9,6 +9,7 @@ class ray {
 public:
 	ray() {} // 매개변수 없는 기본 생성자
 	ray(const point3& origin, const vec3& direction) : orig(origin), dir(direction) {} // 반직선의 출발점, 방향벡터를 매개변수로 받는 생성자 오버로딩 > 반직선 출발점 및 방향 멤버변수 초기화
+	ray(const point3& origin, const vec3& direction, double time) : orig(origin), dir(direction), tm(time) {} // 반직선이 쏘아진 시각까지 지정하는 생성자 (모션 블러에 사용)
 	/*
 		c++ 클래스 멤버변수 초기화 리스트
 
@@ -43,6 +44,7 @@ public:
 	// 각 캡슐화된 멤버변수를 반환하는 getter 메서드를 상수함수로 정의함.
 	point3 origin() const { return orig; }
 	vec3 direction() const { return dir; }
+	double time() const { return tm; }
 
 	// 반직선 상의 특정 점의 좌표를 반환하는 상수함수 (ray 객체의 데이터를 변경하지 않음.)
 	point3 at(double t) const 
@@ -54,6 +56,7 @@ public:
 private:
 	point3 orig; // 반직선의 출발점 멤버변수
 	vec3 dir; // 반직선의 방향 멤버변수
+	double tm = 0; // 반직선이 쏘아진 시각 (카메라 셔터가 열려있는 구간 안의 값. 움직이는 물체는 이 시각의 위치로 교차 검사함.)
 };
 
 
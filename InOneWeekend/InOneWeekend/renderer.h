@@ -0,0 +1,181 @@
+#ifndef RENDERER_H
+#define RENDERER_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "camera.h" // 각 픽셀로 향하는 반직선을 생성하기 위해 포함
+#include "color.h"
+#include "denoiser.h" // 렌더링하면서 보조 버퍼(aux_buffers)를 함께 채우기 위해 포함
+#include "hittable.h"
+#include "trace_stats.h"
+
+#include <iostream>
+#include <vector>
+
+// main.cpp 에 있던 ray_color() 와 렌더링 루프를 옮겨온 헤더
+// 일반 렌더링, 배치 렌더링 등 여러 실행 모드에서 같은 렌더링 코드를 공유하기 위해 분리함.
+
+// 셰이딩 방식
+enum class shading_mode
+{
+	normal, // 충돌 지점의 노멀벡터를 색상으로 시각화
+	diffuse // 램버시안(Lambertian) 난반사로 반직선을 계속 튕겨가며 색상을 계산
+};
+
+// 반직선이 아무 물체와도 충돌하지 않았을 때 보이는 하늘의 수직방향 그라디언트 색상
+struct sky_gradient
+{
+	color bottom = color(1.0, 1.0, 1.0); // 반직선이 아래쪽(-y)을 향할수록 섞이는 색상
+	color top = color(0.5, 0.7, 1.0); // 반직선이 위쪽(+y)을 향할수록 섞이는 색상
+
+	color at(const ray& r) const
+	{
+		// 반직선을 길이가 1인 단위벡터로 정규화한 뒤,
+		// 정규화된 단위벡터의 y값에 따라 색상을 혼합하여 수직방향 그라디언트를 적용해 봄.
+		vec3 unit_direction = unit_vector(r.direction()); // vec3.h 에 정의된 벡터 정규화 유틸 함수 사용
+		auto a = 0.5 * (unit_direction.y() + 1.0); // -1 ~ 1 사이의 정규화된 단위벡터 y 값 범위를 0 ~ 1 사이로 맵핑함.
+
+		// linear interpolation(선형보간)으로 두 색상을 0 ~ 1 사이로 맵핑된 a값에 따라 혼합하여 최종 색상 반환
+		return (1.0 - a) * bottom + a * top;
+	}
+};
+
+inline color ray_color(const ray& r, int depth, const hittable& world, shading_mode shading, aux_sample* aux, const sky_gradient& sky = sky_gradient());
+
+// 반직선이 물체와 충돌한 지점(rec)의 색상을 계산하는 함수
+/*
+	ray_color() 에서 교차 검사 이후의 셰이딩 부분만 분리한 것으로,
+	이미 알고 있는 충돌 정보로부터 셰이딩만 다시 계산할 때도 사용함. (hit_cache.h 참고)
+*/
+inline color shade_hit(const ray& r, const hit_record& rec, int depth, const hittable& world, shading_mode shading,
+					   aux_sample* aux, const sky_gradient& sky)
+{
+	/*
+		구체 표면의 노멀벡터 N 의 컴포넌트들은 
+		-1 ~ 1 범위 사이에 존재하므로,
+		
+		이 값을 0 ~ 1 범위 사이로 맵핑시키고,
+		맵핑된 각각의 x, y, z 값을 r, g, b 색상값으로 사용함
+
+		-> 구체 표면의 노멀벡터를 색상으로 시각화한 것!
+	*/
+	color normal_color = 0.5 * color(rec.normal.x() + 1, rec.normal.y() + 1, rec.normal.z() + 1);
+	color albedo = (shading == shading_mode::normal) ? normal_color : color(0.5, 0.5, 0.5);
+
+	if (aux)
+	{
+		aux->albedo = albedo;
+		aux->normal = rec.normal;
+		aux->depth = rec.t;
+	}
+
+	if (shading == shading_mode::normal) return normal_color;
+
+	// 노멀벡터에 무작위 단위벡터를 더한 방향으로 반직선을 튕겨내면, 램버시안 분포를 따르는 난반사 방향이 됨.
+	// 튕겨나간 반직선도 같은 시각의 씬을 봐야 하므로, 들어온 반직선의 시각을 그대로 물려줌.
+	TRACE_COUNT(bounces, 1);
+	vec3 direction = rec.normal + random_unit_vector();
+	return albedo * ray_color(ray(rec.p, direction, r.time()), depth - 1, world, shading, nullptr, sky);
+}
+
+// 반직선이 아무 물체와도 충돌하지 않았을 때의 색상(하늘)을 계산하는 함수
+inline color shade_miss(const ray& r, aux_sample* aux, const sky_gradient& sky)
+{
+	color background = sky.at(r);
+
+	if (aux)
+	{
+		aux->albedo = background;
+		aux->normal = vec3(0, 0, 0);
+		aux->depth = 0.0;
+	}
+
+	return background;
+}
+
+// 주어진 반직선(ray)에 대한 특정 색상을 반환하는 함수
+/*
+	depth 는 반직선이 앞으로 더 튕겨나갈 수 있는 남은 횟수이고,
+	aux 가 nullptr 이 아니면, 반직선이 처음 충돌한 지점의 알베도, 노멀, 깊이를 기록함. (denoiser.h 참고)
+*/
+inline color ray_color(const ray& r, int depth, const hittable& world, shading_mode shading, aux_sample* aux, const sky_gradient& sky)
+{
+	// 반사 횟수 제한을 초과하면 더 이상 빛을 모으지 않음.
+	if (depth <= 0) return color(0, 0, 0);
+
+	hit_record rec;
+
+	// 씬에 존재하는 물체들 중에서 반직선과 가장 가까운 충돌 지점을 찾음.
+	// 반직선 유효범위 최솟값을 0 이 아닌 0.001 로 둔 것은, 튕겨나간 반직선이 부동소수점 오차 때문에
+	// 출발한 표면 자신과 다시 충돌하는 현상(shadow acne)을 막기 위함임.
+	if (world.hit(r, 0.001, infinity, rec)) return shade_hit(r, rec, depth, world, shading, aux, sky);
+
+	return shade_miss(r, aux, sky);
+}
+
+// 렌더링 설정값
+struct render_settings
+{
+	int samples_per_pixel = 1; // 픽셀 당 샘플 개수 (1 이면 픽셀 중점으로 반직선 하나만 쏨)
+	int max_depth = 10; // 반직선이 튕겨나갈 수 있는 최대 횟수
+	shading_mode shading = shading_mode::normal;
+	sky_gradient sky; // 배경(하늘) 색상
+};
+
+// 이미지의 [x0, x1) x [y0, y1) 영역(타일)만 렌더링해서 framebuffer 에 저장함.
+/*
+	framebuffer 와 aux 는 미리 이미지 크기만큼 할당되어 있어야 함.
+	서로 겹치지 않는 영역이라면 여러 스레드에서 동시에 호출해도 안전함.
+*/
+inline void render_region(const camera& cam, const hittable& world, const render_settings& settings,
+						  std::vector<color>& framebuffer, aux_buffers* aux, int x0, int y0, int x1, int y1)
+{
+	for (int j = y0; j < y1; ++j)
+	{
+		for (int i = x0; i < x1; ++i)
+		{
+			color pixel_color(0, 0, 0);
+			aux_sample aux_sum;
+
+			for (int s = 0; s < settings.samples_per_pixel; ++s)
+			{
+				// 카메라 ~ 뷰포트 각 픽셀 중점(샘플이 여러 개면 픽셀 내 무작위 지점)까지 향하는 반직선(ray) 타입 변수 r 선언 및 초기화
+				ray r = (settings.samples_per_pixel == 1) ? cam.get_ray(i, j) : cam.get_sample_ray(i, j, s, settings.samples_per_pixel);
+
+				aux_sample sample;
+				pixel_color += ray_color(r, settings.max_depth, world, settings.shading, aux ? &sample : nullptr, settings.sky); // 주어진 반직선(ray) r 을 입력받아 특정 색상을 반환받아 픽셀 색상 계산
+				aux_sum.albedo += sample.albedo;
+				aux_sum.normal += sample.normal;
+				aux_sum.depth += sample.depth;
+			}
+
+			size_t index = static_cast<size_t>(j) * cam.image_width + i;
+			framebuffer[index] = pixel_color / settings.samples_per_pixel; // 샘플들의 평균 색상을 프레임버퍼의 (i, j) 위치에 저장
+			if (aux) aux->store(index, aux_sum, settings.samples_per_pixel);
+		}
+	}
+}
+
+// 씬 전체를 렌더링해서 선형 색상값을 framebuffer 에 저장함. aux 가 nullptr 이 아니면 보조 버퍼도 함께 채움.
+inline void render(const camera& cam, const hittable& world, const render_settings& settings,
+				   std::vector<color>& framebuffer, aux_buffers* aux, bool show_progress)
+{
+	int image_width = cam.image_width;
+	int image_height = cam.image_height;
+
+	framebuffer.assign(static_cast<size_t>(image_width) * image_height, color(0, 0, 0));
+	if (aux) aux->resize(image_width, image_height);
+
+	// 각 픽셀의 색상값(r, g, b)을 한 줄(row)씩 계산하여 프레임버퍼에 저장
+	for (int j = 0; j < image_height; ++j)
+	{
+		// ppm 에 출력할 색상값을 한 줄(row)씩 처리할 때마다 남아있는 줄을 std::clog 로 출력함 > 에러 출력 스트림
+		// 참고로, std::flush 는 스트림에 대기중인 버퍼의 내용을 비운 후, 강제로 출력시킴.
+		// std::cout 은 색상값 출력 시 사용되므로, 이에 대한 대체제로써 std::clog 를 사용한 것!
+		if (show_progress) std::clog << "\rScanlines remaining: " << (image_height - j) << ' ' << std::flush;
+		render_region(cam, world, settings, framebuffer, aux, 0, j, image_width, j + 1);
+	}
+}
+
+#endif // !RENDERER_H
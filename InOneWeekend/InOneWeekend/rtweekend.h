@@ -0,0 +1,70 @@
+#ifndef RTWEEKEND_H
+#define RTWEEKEND_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include <atomic>
+#include <cmath>
+#include <limits> // std::numeric_limits 를 사용하기 위해 포함
+#include <memory> // std::shared_ptr 를 사용하기 위해 포함
+#include <random> // 난수 생성기를 사용하기 위해 포함
+
+// 여러 헤더 파일에서 공통으로 사용할 상수와 유틸 함수들을 모아둔 헤더
+
+// using 을 이용해서 namespace 안의 특정 요소만 가져옴. (vec3.h 관련 필기 참고)
+using std::shared_ptr;
+using std::make_shared;
+
+// Constants
+
+const double infinity = std::numeric_limits<double>::infinity(); // 반직선의 유효범위 최댓값 등으로 사용할 무한대
+const double pi = 3.1415926535897932385;
+
+// Utility Functions
+
+// 육십분법 각도를 호도법 각도로 변환
+inline double degrees_to_radians(double degrees)
+{
+	return degrees * pi / 180.0;
+}
+
+// 스레드가 처음 난수를 사용할 때 그 스레드의 난수 생성기를 만듦.
+/*
+	std::mt19937 을 기본 생성자로 만들면 모든 스레드가 같은 시드(default_seed)로 같은 수열을 반복하게 되어,
+	여러 스레드가 나눠 렌더링한 줄(row)이나 타일의 노이즈가 서로 똑같은 패턴이 됨. (노이즈가 독립적이지 않음.)
+
+	그래서 난수를 사용하기 시작한 순서대로 스레드마다 번호를 붙이고, 그 번호를 seed_seq 로 섞어서 서로 다른 시드를 줌.
+	처음 난수를 사용하는 스레드(단일 스레드 렌더링에서는 메인 스레드)는 기본 시드를 그대로 사용하므로,
+	단일 스레드 렌더링 결과는 이전과 같음.
+*/
+inline std::mt19937 make_thread_generator()
+{
+	static std::atomic<unsigned> next_thread(0);
+	const unsigned thread_index = next_thread.fetch_add(1);
+	if (thread_index == 0) return std::mt19937();
+
+	std::seed_seq seed{ static_cast<unsigned>(std::mt19937::default_seed), thread_index };
+	return std::mt19937(seed);
+}
+
+// 0 이상 1 미만의 무작위 실수를 반환
+/*
+	여러 스레드에서 동시에 렌더링하는 경우가 있으므로,
+	난수 생성기를 thread_local 로 선언해서 스레드마다 각자의 생성기를 사용하도록 함.
+
+	std::rand() 처럼 하나의 전역 상태를 공유하면
+	스레드 간 경합이 발생하거나 결과가 꼬일 수 있기 때문!
+*/
+inline double random_double()
+{
+	thread_local std::mt19937 generator = make_thread_generator();
+	thread_local std::uniform_real_distribution<double> distribution(0.0, 1.0);
+	return distribution(generator);
+}
+
+// min 이상 max 미만의 무작위 실수를 반환
+inline double random_double(double min, double max)
+{
+	return min + (max - min) * random_double();
+}
+
+#endif // !RTWEEKEND_H
@@ -0,0 +1,284 @@
+#ifndef SPECTRAL_H
+#define SPECTRAL_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "camera.h"
+#include "color.h"
+#include "hittable.h"
+#include "renderer.h" // render_settings, shading_mode, sky_gradient 를 그대로 사용하기 위해 포함
+#include "trace_stats.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// 반직선 하나가 함께 운반하는 파장 수 (SSE 레지스터 하나에 float 4개)
+/*
+	AVX 를 사용하면 8개까지 늘릴 수 있지만, 이 프로젝트의 다른 SIMD 코드(postprocess.h, kernels.h, fast_math.h)와
+	마찬가지로 추가 컴파일 옵션 없이 x64 에서 항상 사용할 수 있는 SSE2 만 사용함.
+*/
+const int spectrum_samples = 4;
+
+// 가시광선 파장 범위 (nm)
+const double spectral_lambda_min = 380.0;
+const double spectral_lambda_max = 780.0;
+
+// SSE2 를 사용할 수 있는 환경에서는 파장 4개의 값을 __m128 하나로 한 번에 계산함. (postprocess.h 와 같은 조건)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define SPECTRAL_USE_SSE2 1
+#endif
+
+// 파장 spectrum_samples 개에서의 값 (반사율, 복사휘도, 처리량 등)
+/*
+	RGB 의 color 는 채널 3개를 vec3 로 묶은 것이고, spectrum 은 반직선마다 고른 파장들에서의 값을 묶은 것임.
+	어떤 파장들인지는 spectrum 이 아니라 함께 넘기는 wavelength_sample 이 알고 있음.
+*/
+struct spectrum
+{
+#ifdef SPECTRAL_USE_SSE2
+	__m128 v;
+
+	spectrum() : v(_mm_setzero_ps()) {}
+	explicit spectrum(float s) : v(_mm_set1_ps(s)) {}
+	spectrum(float a, float b, float c, float d) : v(_mm_setr_ps(a, b, c, d)) {}
+	explicit spectrum(__m128 _v) : v(_v) {}
+
+	void store(float* lanes) const { _mm_storeu_ps(lanes, v); }
+
+	spectrum& operator+=(const spectrum& s) { v = _mm_add_ps(v, s.v); return *this; }
+	spectrum& operator*=(const spectrum& s) { v = _mm_mul_ps(v, s.v); return *this; }
+#else
+	float v[4];
+
+	spectrum() : v{ 0, 0, 0, 0 } {}
+	explicit spectrum(float s) : v{ s, s, s, s } {}
+	spectrum(float a, float b, float c, float d) : v{ a, b, c, d } {}
+
+	void store(float* lanes) const { std::copy(v, v + 4, lanes); }
+
+	spectrum& operator+=(const spectrum& s) { for (int i = 0; i < 4; ++i) v[i] += s.v[i]; return *this; }
+	spectrum& operator*=(const spectrum& s) { for (int i = 0; i < 4; ++i) v[i] *= s.v[i]; return *this; }
+#endif
+};
+
+inline spectrum operator+(spectrum a, const spectrum& b) { return a += b; }
+inline spectrum operator*(spectrum a, const spectrum& b) { return a *= b; }
+inline spectrum operator*(float s, spectrum a) { return a *= spectrum(s); }
+
+// CIE 1931 등색 함수(color matching function)의 해석적 근사 (Wyman, Sloan, Shirley 2013 의 다중 가우시안 피팅)
+inline double cie_lobe(double lambda, double mu, double sigma_left, double sigma_right)
+{
+	const double t = (lambda - mu) / (lambda < mu ? sigma_left : sigma_right);
+	return std::exp(-0.5 * t * t);
+}
+
+inline vec3 cie_xyz(double lambda)
+{
+	return vec3(1.056 * cie_lobe(lambda, 599.8, 37.9, 31.0) + 0.362 * cie_lobe(lambda, 442.0, 16.0, 26.7) - 0.065 * cie_lobe(lambda, 501.1, 20.4, 26.2),
+				0.821 * cie_lobe(lambda, 568.8, 46.9, 40.5) + 0.286 * cie_lobe(lambda, 530.9, 16.3, 31.1),
+				1.217 * cie_lobe(lambda, 437.0, 11.8, 36.0) + 0.681 * cie_lobe(lambda, 459.0, 26.0, 13.8));
+}
+
+// XYZ -> 선형 sRGB (D65) 변환 행렬
+inline color xyz_to_linear_srgb(const vec3& xyz)
+{
+	return color(3.2404542 * xyz.x() - 1.5371385 * xyz.y() - 0.4985314 * xyz.z(),
+				 -0.9692660 * xyz.x() + 1.8760108 * xyz.y() + 0.0415560 * xyz.z(),
+				 0.0556434 * xyz.x() - 0.2040259 * xyz.y() + 1.0572252 * xyz.z());
+}
+
+// RGB 값을 스펙트럼으로 바꿀 때 쓰는 세 개의 기저 함수 (단파장, 중간, 장파장 쪽을 덮는 매끄러운 띠)
+/*
+	세 함수의 합은 모든 파장에서 1 이므로, 회색 (g, g, g) 은 정확히 평평한 스펙트럼 g 가 됨.
+	채도가 높은 색은 스펙트럼으로 갔다가 RGB 로 돌아왔을 때 원래 값과 조금 달라짐. (하단 필기 '스펙트럴 렌더링' 참고)
+*/
+inline void spectral_basis(double lambda, double& b, double& g, double& r)
+{
+	auto smoothstep = [](double e0, double e1, double x)
+	{
+		const double t = std::min(std::max((x - e0) / (e1 - e0), 0.0), 1.0);
+		return t * t * (3.0 - 2.0 * t);
+	};
+	b = 1.0 - smoothstep(440.0, 520.0, lambda);
+	r = smoothstep(560.0, 640.0, lambda);
+	g = 1.0 - b - r;
+}
+
+// 반직선 하나가 운반하는 파장들과, 그 파장들에서 미리 계산해둔 값들
+/*
+	hero wavelength 방식 : 하나의 파장(hero)만 무작위로 고르고, 나머지는 가시광선 범위를 spectrum_samples 등분한 간격만큼 떨어진 파장들로 정함.
+	(범위를 벗어나면 반대쪽으로 돌아옴.) 그래서 반직선 하나로 가시광선 범위 전체를 고르게 덮음.
+
+	파장마다 필요한 지수 함수 계산(등색 함수, 기저 함수)은 카메라 반직선마다 한 번만 하고,
+	튕겨나가는 동안의 셰이딩은 이 값들을 곱하고 더하는 SIMD 연산만으로 처리함.
+*/
+struct wavelength_sample
+{
+	double lambda[spectrum_samples];
+	spectrum basis_b, basis_g, basis_r; // RGB -> 스펙트럼 변환 기저
+	vec3 cmf[spectrum_samples]; // 파장마다의 등색 함수 값
+
+	// u (0 ~ 1) 로 hero 파장을 고름.
+	static wavelength_sample hero(double u)
+	{
+		const double range = spectral_lambda_max - spectral_lambda_min;
+		double lambdas[spectrum_samples];
+		for (int i = 0; i < spectrum_samples; ++i) lambdas[i] = spectral_lambda_min + std::fmod(u * range + i * range / spectrum_samples, range);
+		return wavelength_sample(lambdas);
+	}
+
+	// 모든 레인이 같은 파장 하나를 운반함. (파장마다 반직선을 따로 쏘는 방식과 비교하기 위해 사용)
+	static wavelength_sample single(double u)
+	{
+		double lambdas[spectrum_samples];
+		std::fill(lambdas, lambdas + spectrum_samples, spectral_lambda_min + u * (spectral_lambda_max - spectral_lambda_min));
+		return wavelength_sample(lambdas);
+	}
+
+	// RGB 반사율(또는 복사휘도)을 이 파장들에서의 스펙트럼 값으로 바꿈.
+	spectrum upsample(const color& c) const
+	{
+		return static_cast<float>(c.x()) * basis_r + static_cast<float>(c.y()) * basis_g + static_cast<float>(c.z()) * basis_b;
+	}
+
+	// 이 파장들에서 측정한 값 s 의 선형 sRGB 추정값 (파장들을 균등분포로 골랐으므로, 몬테카를로 추정 XYZ = 범위 x 평균(s * cmf))
+	color to_rgb(const spectrum& s) const
+	{
+		float values[spectrum_samples];
+		s.store(values);
+
+		vec3 xyz(0, 0, 0);
+		for (int i = 0; i < spectrum_samples; ++i) xyz += values[i] * cmf[i];
+		xyz *= (spectral_lambda_max - spectral_lambda_min) / spectrum_samples;
+
+		const color white = white_balance();
+		const color rgb = xyz_to_linear_srgb(xyz);
+		return color(rgb.x() * white.x(), rgb.y() * white.y(), rgb.z() * white.z());
+	}
+
+private:
+	explicit wavelength_sample(const double* lambdas)
+	{
+		double b[spectrum_samples], g[spectrum_samples], r[spectrum_samples];
+		for (int i = 0; i < spectrum_samples; ++i)
+		{
+			lambda[i] = lambdas[i];
+			spectral_basis(lambda[i], b[i], g[i], r[i]);
+			cmf[i] = cie_xyz(lambda[i]);
+		}
+		basis_b = spectrum(float(b[0]), float(b[1]), float(b[2]), float(b[3]));
+		basis_g = spectrum(float(g[0]), float(g[1]), float(g[2]), float(g[3]));
+		basis_r = spectrum(float(r[0]), float(r[1]), float(r[2]), float(r[3]));
+	}
+
+	// 평평한 스펙트럼 1 이 RGB (1, 1, 1) 이 되도록 채널마다 곱할 값 (등에너지 백색과 sRGB 백색점 D65 의 차이를 보정)
+	static color white_balance()
+	{
+		static const color scale = []()
+		{
+			vec3 xyz(0, 0, 0);
+			for (double lambda = spectral_lambda_min + 0.5; lambda < spectral_lambda_max; lambda += 1.0) xyz += cie_xyz(lambda);
+			const color rgb = xyz_to_linear_srgb(xyz);
+			return color(1.0 / rgb.x(), 1.0 / rgb.y(), 1.0 / rgb.z());
+		}();
+		return scale;
+	}
+};
+
+static_assert(spectrum_samples == 4, "spectrum stores exactly 4 lanes");
+
+// 반직선 r 이 운반하는 파장들에서의 복사휘도 (renderer.h 의 ray_color() 와 같은 셰이딩을 스펙트럼으로 계산)
+/*
+	교차 검사는 파장과 상관없으므로, 파장 spectrum_samples 개가 한 번의 교차 검사를 공유함.
+	튕겨나갈 때마다 처리량(throughput)에 알베도 스펙트럼을 곱해가는 반복문으로 계산함.
+*/
+inline spectrum spectral_ray_color(ray r, int depth, const hittable& world, const render_settings& settings, const wavelength_sample& ws)
+{
+	spectrum throughput(1.0f);
+	for (; depth > 0; --depth)
+	{
+		hit_record rec;
+		if (!world.hit(r, 0.001, infinity, rec)) return throughput * ws.upsample(settings.sky.at(r));
+
+		if (settings.shading == shading_mode::normal)
+			return throughput * ws.upsample(0.5 * color(rec.normal.x() + 1, rec.normal.y() + 1, rec.normal.z() + 1));
+
+		TRACE_COUNT(bounces, 1);
+		throughput *= ws.upsample(color(0.5, 0.5, 0.5));
+		r = ray(rec.p, rec.normal + random_unit_vector(), r.time());
+	}
+	return spectrum(); // 반사 횟수 제한을 넘으면 더 이상 빛을 모으지 않음.
+}
+
+// 스펙트럼 렌더링에서 파장을 고르는 방식
+enum class spectral_sampling
+{
+	hero, // 반직선 하나가 파장 spectrum_samples 개를 함께 운반함.
+	per_wavelength // 파장마다 반직선을 따로 쏨. (같은 수의 파장을 얻는 데 반직선이 spectrum_samples 배 필요함.)
+};
+
+// 씬 전체를 스펙트럼으로 렌더링해서 선형 sRGB 색상값을 framebuffer 에 저장함. (render() 와 같은 픽셀 샘플, 출력 형식)
+inline void render_spectral(const camera& cam, const hittable& world, const render_settings& settings, spectral_sampling sampling,
+							std::vector<color>& framebuffer, bool show_progress)
+{
+	framebuffer.assign(static_cast<size_t>(cam.image_width) * cam.image_height, color(0, 0, 0));
+
+	const int spp = settings.samples_per_pixel;
+	const int rays_per_sample = (sampling == spectral_sampling::hero) ? 1 : spectrum_samples;
+	for (int j = 0; j < cam.image_height; ++j)
+	{
+		if (show_progress) std::clog << "\rScanlines remaining: " << (cam.image_height - j) << ' ' << std::flush;
+		for (int i = 0; i < cam.image_width; ++i)
+		{
+			color pixel_color(0, 0, 0);
+			for (int s = 0; s < spp; ++s)
+			{
+				const ray r = (spp == 1) ? cam.get_ray(i, j) : cam.get_sample_ray(i, j, s, spp);
+				const double u = random_double();
+
+				// 파장마다 따로 쏘는 경우에도 hero 방식과 같은 파장들을 고르고, 하나씩 다른 반직선에 실어 보냄.
+				for (int k = 0; k < rays_per_sample; ++k)
+				{
+					const wavelength_sample ws = (sampling == spectral_sampling::hero)
+						? wavelength_sample::hero(u) : wavelength_sample::single(std::fmod(u + static_cast<double>(k) / spectrum_samples, 1.0));
+					pixel_color += ws.to_rgb(spectral_ray_color(r, settings.max_depth, world, settings, ws));
+				}
+			}
+			framebuffer[static_cast<size_t>(j) * cam.image_width + i] = pixel_color / (spp * rays_per_sample);
+		}
+	}
+}
+
+#endif // !SPECTRAL_H
+
+/*
+	스펙트럴 렌더링 (spectral rendering)
+
+
+	RGB 렌더링은 빛을 세 개의 채널로만 다루므로, 파장에 따라 굴절률이 달라지는 분산(dispersion)이나
+	반사율이 파장마다 다른 재질을 정확하게 표현할 수 없음.
+	스펙트럴 렌더링은 반직선마다 파장을 골라서 그 파장에서의 값으로 셰이딩하고,
+	프레임버퍼에 더할 때 CIE 등색 함수로 XYZ 를 구한 뒤 RGB 로 바꿈.
+
+	1. 파장마다 반직선을 따로 쏘는 방식
+
+		반직선 하나가 파장 하나만 운반하면, RGB 만큼의 색 정보를 얻기 위해 반직선을 여러 번 쏴야 하고,
+		그만큼 교차 검사 비용도 몇 배가 됨.
+
+	2. hero wavelength 방식 (Wilkie et al. 2014)
+
+		반직선 하나가 가시광선 범위에 고르게 흩어진 파장 4개를 함께 운반함.
+		교차 검사는 파장과 상관없으므로 한 번만 하고, 셰이딩만 파장 4개에 대해 SSE 명령 하나로 함께 계산함.
+		(분산처럼 파장마다 경로가 갈라지는 재질을 만나면, 그때부터는 hero 파장 하나만 남기고 나머지는 버리면 됨.)
+
+	3. RGB -> 스펙트럼 변환
+
+		지금의 재질과 하늘 색상은 RGB 로 지정되어 있으므로, 세 개의 매끄러운 기저 함수(단파장, 중간, 장파장)의 합으로 스펙트럼을 만듦.
+		회색은 평평한 스펙트럼이 되어 정확하게 보존되지만, 채도가 높은 색은 스펙트럼을 거쳐 RGB 로 돌아오면 조금 탁해짐.
+		(정확하게 보존하려면 Jakob, Hanika 2019 처럼 미리 계산한 표가 필요함.)
+
+	--spectral-bench 로 RGB 렌더링, hero wavelength, 파장별 반직선 방식의 시간과 오차를 비교해볼 수 있음.
+*/
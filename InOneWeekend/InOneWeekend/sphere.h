@@ -2,7 +2,10 @@
 #define SPHERE_H
 // 헤더 가드를 위한 전처리기 선언
 
+#include "rtweekend.h" // clone() 에서 make_shared 를 사용하기 위해 포함
+
 #include "hittable.h" // 구체 클래스가 상속받을 hittable(피충돌 물체) 추상 클래스 사용을 위해 포함
+#include "trace_stats.h" // 교차 검사 횟수를 세기 위해 포함
 #include "vec3.h" // hit() 메서드 재정의 시, 벡터 연산을 수행하기 위해 vec3 클래스 포함
 
 // sphere(구체) 클래스를 hittable(피충돌 물체) 추상 클래스로부터 상속받아 정의
@@ -11,13 +14,25 @@ class sphere : public hittable
 public:
 	// 구체의 중점 좌표와 반지름을 매개변수로 받는 생성자 정의
 	// 멤버변수 초기화 리스트 사용 (https://github.com/jooo0922/raytracing-study/blob/main/InOneWeekend/InOneWeekend/ray.h 관련 필기 참고)
-	sphere(point3 _center, double _radius) : center(_center), radius(_radius) {}
+	sphere(point3 _center, double _radius) : center(_center), radius(_radius), inv_radius(1.0 / _radius), is_moving(false) {}
+
+	// 시각 _time0 ~ _time1 동안 _center1 에서 _center2 로 일정한 속도로 움직이는 구체 (모션 블러에 사용)
+	/*
+		_time0 이전에는 _center1, _time1 이후에는 _center2 에 멈춰있는 것으로 취급함. (sphere_center() 참고)
+		그래서 카메라의 셔터 구간이 [_time0, _time1] 을 벗어나더라도 bounding_box() 가 항상 구체를 감쌈.
+	*/
+	sphere(point3 _center1, point3 _center2, double _radius, double _time0 = 0.0, double _time1 = 1.0)
+		: center(_center1), radius(_radius), inv_radius(1.0 / _radius), is_moving(true), center_vec(_center2 - _center1),
+		  time0(_time0), inv_duration(_time1 > _time0 ? 1.0 / (_time1 - _time0) : 0.0) {}
 
 	// 순수 가상 함수 hit 재정의(override) -> 하단 필기 참고
 	bool hit(const ray& r, double ray_tmin, double ray_tmax, hit_record& rec) const override
 	{
 		// 반직선-구체 교차 여부를 검증하는 판별식 구현 (main.cpp > '근의 공식과 판별식 관련 필기 참고')
-		vec3 oc = r.origin() - center; // 반직선 출발점 ~ 구체의 중점까지의 벡터 (본문 공식에서 (A-C) 에 해당)
+		TRACE_COUNT(primitive_tests, 1);
+
+		point3 current_center = is_moving ? sphere_center(r.time()) : center; // 움직이는 구체는 반직선이 쏘아진 시각의 중점으로 검사
+		vec3 oc = r.origin() - current_center; // 반직선 출발점 ~ 구체의 중점까지의 벡터 (본문 공식에서 (A-C) 에 해당)
 		auto a = r.direction().length_squared(); // 반직선 방향벡터 자신과의 내적 (본문 공식에서 b⋅b 에 해당) > 벡터 자신과의 내적을 벡터 길이 제곱으로 리팩터링
 		auto half_b = dot(oc, r.direction()); // 2 * 반직선 방향벡터와 (A-C) 벡터와의 내적 (본문 공식에서 2tb⋅(A−C) 에 해당) > half_b 로 변경
 		auto c = oc.length_squared() - radius * radius; // (A-C) 벡터 자신과의 내적 - 반직선 제곱 (본문 공식에서 (A−C)⋅(A−C)−r^2 에 해당) > 벡터 자신과의 내적을 벡터 길이 제곱으로 리팩터링
@@ -33,13 +48,23 @@ public:
 
 		// main.cpp 에 필기 정리 해놓았던 것처럼, 
 		// 반직선과 구체의 교차점들 중에서 더 가까운 교차점에 해당하는 반직선 상의 비율값 t 를 먼저 계산
+#if RT_FAST_MATH
+		// 두 근 모두 a 로 나눠야 하므로, 나눗셈 대신 역수를 한 번만 구해서 곱함. (fast_math.h 참고)
+		const auto inv_a = 1.0 / a;
+		auto root = (-half_b - sqrtd) * inv_a;
+#else
 		auto root = (-half_b - sqrtd) / a;
+#endif
 
 		if (root <= ray_tmin || ray_tmax <= root)
 		{
 			// 만약, 더 가까운 교차점에 해당하는 반직선 상의 비율값 t 가 반직선의 유효범위를 벗어난다면,
 			// 나머지 교차점에 대한 반직선 상의 비율값 t 를 다시 계산함.
+#if RT_FAST_MATH
+			root = (-half_b + sqrtd) * inv_a;
+#else
 			root = (-half_b + sqrtd) / a;
+#endif
 		
 			if (root <= ray_tmin || ray_tmax <= root)
 			{
@@ -54,16 +79,56 @@ public:
 		// (https://raytracing.github.io/books/RayTracingInOneWeekend.html#surfacenormalsandmultipleobjects/shadingwithsurfacenormals > 구체 표면 상의 노멀벡터 계산 관련 Figure 6 참고)
 		rec.t = root; // 반직선 상에서 충돌 지점이 위치하는 비율값 t 저장
 		rec.p = r.at(rec.t); // 충돌 지점의 좌표값 저장
-		rec.normal = (rec.p - center) / radius; // 구체 표면 상에서 충돌 지점의 노멀벡터(방향벡터) 저장
+		rec.normal = inv_radius * (rec.p - current_center); // 구체 표면 상에서 충돌 지점의 노멀벡터(방향벡터) 저장 (미리 구해둔 반지름의 역수를 곱함.)
 		
 		// 반직선 유효범위 내의 비율값 t가 존재한다면, 구체와 반직선의 충돌 지점이 존재하는 것으로 판단하여 true 반환
 		return true;
 	}
 
+	// 중점에서 각 축으로 반지름만큼 떨어진 두 꼭지점으로 구체를 감싸는 상자를 만듦.
+	// 움직이는 구체는 시작 위치와 끝 위치의 상자를 모두 감싸므로, 시각과 상관없이 모든 위치를 포함함. (구간 밖의 시각에는 양 끝에 멈춰있음.)
+	aabb bounding_box() const override
+	{
+		vec3 rvec(radius, radius, radius);
+		aabb box(center - rvec, center + rvec);
+		if (!is_moving) return box;
+		return aabb(box, aabb(center + center_vec - rvec, center + center_vec + rvec));
+	}
+
+	shared_ptr<hittable> clone() const override { return make_shared<sphere>(*this); }
+
+	// 구체 데이터를 읽기 전용으로 반환하는 getter 메서드 (kernels.h 에서 구체들을 배열로 펼칠 때 사용)
+	point3 get_center() const { return center; }
+	double get_radius() const { return radius; }
+	double get_inv_radius() const { return inv_radius; }
+	vec3 get_velocity() const { return is_moving ? center_vec : vec3(0, 0, 0); } // 시각 time0 ~ time1 동안 중점이 이동하는 벡터
+	double get_time0() const { return time0; }
+	double get_inv_duration() const { return inv_duration; } // 1 / (time1 - time0) (시각을 0 ~ 1 의 이동 비율로 바꿀 때 곱함.)
+
+	// 시각 time 을 [time0, time1] 구간 안에서의 이동 비율(0 ~ 1)로 바꿈. (kernels.h 의 sphere_soa 도 같은 식을 사용함.)
+	template <typename T>
+	static T motion_fraction(T time, T start, T inv_length)
+	{
+		const T s = (time - start) * inv_length;
+		return s < T(0) ? T(0) : (s > T(1) ? T(1) : s);
+	}
+
 private:
 	// 구체를 정의하는 데이터를 private 멤버변수로 정의
 	point3 center; // 구체의 중심점 좌표 멤버변수
 	double radius; // 구체의 반지름 멤버변수
+	double inv_radius; // 1 / radius (충돌할 때마다 반지름으로 나누지 않도록 생성 시점에 미리 계산해 둠.)
+	bool is_moving; // 움직이는 구체인지 여부
+	vec3 center_vec; // 시각 time0 의 중점에서 시각 time1 의 중점으로 향하는 벡터
+	double time0 = 0.0; // 움직이기 시작하는 시각
+	double inv_duration = 1.0; // 1 / (time1 - time0) (time1 <= time0 이면 0 으로 두어 움직이지 않게 함.)
+
+	// 시각 time 에서의 구체 중점 (time0 이전이면 center, time1 이후면 center + center_vec)
+	point3 sphere_center(double time) const
+	{
+		return center + motion_fraction(time, time0, inv_duration) * center_vec;
+	}
+
 };
 
 #endif // !SPHERE_H
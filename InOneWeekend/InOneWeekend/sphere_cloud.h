@@ -0,0 +1,727 @@
+#ifndef SPHERE_CLOUD_H
+#define SPHERE_CLOUD_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "aabb.h"
+#include "bvh.h"
+#include "camera.h" // 클러스터가 화면에 투영되는 크기로 LOD 를 고르기 위해 포함
+#include "hittable.h"
+#include "hittable_list.h"
+#include "trace_stats.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+// 작은 구체 수백만 ~ 수억 개로 이루어진 포인트 클라우드 같은 씬 (하단 필기 '구체 클라우드의 LOD 와 지연 로딩' 참고)
+/*
+	구체들은 공간을 격자로 나눈 클러스터 단위로 디스크 파일에 저장되어 있고,
+	메모리에는 클러스터마다 경계 상자와 대체 구체(proxy) 하나씩만 올려둠.
+
+	1. 카메라에서 멀어서 화면에 작게 투영되는 클러스터는 대체 구체 하나로 렌더링함. (구체 데이터를 읽지 않음.)
+	2. 가까운 클러스터는 반직선이 경계 상자와 처음 만날 때 디스크에서 구체 데이터를 읽어옴.
+	3. 읽어온 데이터가 메모리 예산을 넘으면, 최근에 사용하지 않은 클러스터부터 메모리에서 내보냄.
+*/
+
+// 파일에 저장되는 클러스터 하나의 정보 (56 바이트)
+struct sphere_cloud_cluster_header
+{
+	float box_min[3], box_max[3]; // 클러스터의 모든 구체를 감싸는 상자
+	float proxy[4]; // 클러스터를 대신하는 구체 (중점 x, y, z, 반지름)
+	std::uint32_t count; // 클러스터에 속한 구체 수
+	std::uint32_t reserved; // offset 을 8 바이트 단위로 정렬하기 위한 여분
+	std::uint64_t offset; // 파일 안에서 구체 데이터가 시작하는 위치 (바이트)
+};
+
+static_assert(sizeof(sphere_cloud_cluster_header) == 56, "sphere_cloud_cluster_header must be tightly packed");
+
+// 구체 하나는 파일과 메모리 모두 float 4개(중점 x, y, z, 반지름)로 저장함.
+const size_t sphere_cloud_floats_per_sphere = 4;
+const char sphere_cloud_magic[8] = { 'R', 'T', 'S', 'C', 'L', 'D', '0', '1' };
+
+// write_sphere_cloud() 로 만들 구체 클라우드의 설정값
+struct sphere_cloud_params
+{
+	aabb region = aabb(point3(-8, -3, -40), point3(8, 6, -1.5)); // 지형의 x, z 범위와 높이 범위
+	std::uint64_t sphere_count = 1000000;
+	int spheres_per_cluster = 256; // 클러스터 하나에 들어갈 구체 수 (x, z 평면을 이 크기에 맞는 격자로 나눔.)
+	double radius = 0.008; // 구체 반지름의 평균 (0.5 ~ 1.5 배 사이에서 무작위로 정함.)
+	unsigned seed = 1;
+};
+
+// 지형 스캔 데이터처럼, 카메라에서 멀어질수록 높아지는 완만한 지형 표면 위에 점(구체)들을 흩뿌림.
+inline double sphere_cloud_height(const sphere_cloud_params& params, double x, double z)
+{
+	const double far = (params.region.maximum.z() - z) / (params.region.maximum.z() - params.region.minimum.z()); // 가장 가까운 쪽 0 ~ 가장 먼 쪽 1
+	const double bumps = 0.5 + 0.5 * std::sin(1.3 * x) * std::cos(0.9 * z);
+	return params.region.minimum.y() + (params.region.maximum.y() - params.region.minimum.y()) * (0.9 * far + 0.1 * bumps);
+}
+
+// 지형 표면 위에 무작위 구체들을 흩뿌려서 클러스터 단위로 path 에 저장함.
+/*
+	클러스터 하나씩 만들어서 바로 파일에 쓰므로, 구체 수가 메모리보다 커도 만들 수 있음.
+	(메모리에는 클러스터 정보만 남겨뒀다가, 마지막에 파일 앞부분으로 돌아가서 기록함.)
+*/
+inline bool write_sphere_cloud(const std::string& path, const sphere_cloud_params& params)
+{
+	std::ofstream out(path, std::ios::binary);
+	if (!out)
+	{
+		std::cerr << "Cannot create sphere cloud: " << path << '\n';
+		return false;
+	}
+
+	// 클러스터 수에 맞게 x, z 평면을 정사각형에 가까운 격자로 나눔.
+	const vec3 extent = params.region.maximum - params.region.minimum;
+	const double target_clusters = std::max(1.0, std::ceil(static_cast<double>(params.sphere_count) / std::max(1, params.spheres_per_cluster)));
+	const double cell_size = std::sqrt(extent.x() * extent.z() / target_clusters);
+	const int cells_x = std::max(1, static_cast<int>(std::lround(extent.x() / cell_size)));
+	const int cells_z = std::max(1, static_cast<int>(std::lround(extent.z() / cell_size)));
+
+	const std::uint64_t cluster_count = static_cast<std::uint64_t>(cells_x) * cells_z;
+	std::vector<sphere_cloud_cluster_header> headers(cluster_count);
+
+	out.write(sphere_cloud_magic, sizeof(sphere_cloud_magic));
+	out.write(reinterpret_cast<const char*>(&cluster_count), sizeof(cluster_count));
+	const std::uint64_t header_offset = static_cast<std::uint64_t>(out.tellp());
+	out.write(reinterpret_cast<const char*>(headers.data()), headers.size() * sizeof(sphere_cloud_cluster_header));
+
+	std::mt19937 generator(params.seed);
+	std::uniform_real_distribution<double> uniform(0.0, 1.0);
+	std::uint64_t offset = static_cast<std::uint64_t>(out.tellp());
+	std::vector<float> data;
+
+	for (std::uint64_t k = 0; k < cluster_count; ++k)
+	{
+		const int cx = static_cast<int>(k % cells_x), cz = static_cast<int>(k / cells_x);
+		const double x0 = params.region.minimum.x() + extent.x() * cx / cells_x, z0 = params.region.minimum.z() + extent.z() * cz / cells_z;
+		const double cell_x = extent.x() / cells_x, cell_z = extent.z() / cells_z;
+
+		// 구체 수를 클러스터들에 최대한 고르게 나눔. (앞쪽 클러스터들이 나머지를 하나씩 더 가짐.)
+		const std::uint32_t count = static_cast<std::uint32_t>(params.sphere_count / cluster_count + (k < params.sphere_count % cluster_count ? 1 : 0));
+
+		data.resize(static_cast<size_t>(count) * sphere_cloud_floats_per_sphere);
+		aabb box;
+		vec3 center_sum(0, 0, 0);
+		double area_sum = 0.0; // 반지름 제곱의 합 (구체들의 단면적 합 / pi)
+		for (std::uint32_t s = 0; s < count; ++s)
+		{
+			const double x = x0 + uniform(generator) * cell_x, z = z0 + uniform(generator) * cell_z;
+			const double r = params.radius * (0.5 + uniform(generator));
+			const point3 c(x, sphere_cloud_height(params, x, z) + r * (uniform(generator) - 0.5), z);
+
+			float* sphere_data = &data[static_cast<size_t>(s) * sphere_cloud_floats_per_sphere];
+			sphere_data[0] = static_cast<float>(c.x());
+			sphere_data[1] = static_cast<float>(c.y());
+			sphere_data[2] = static_cast<float>(c.z());
+			sphere_data[3] = static_cast<float>(r);
+
+			box = aabb(box, aabb(c - vec3(r, r, r), c + vec3(r, r, r)));
+			center_sum += c;
+			area_sum += r * r;
+		}
+
+		sphere_cloud_cluster_header& h = headers[k];
+		h.count = count;
+		h.reserved = 0;
+		h.offset = offset;
+		if (box.empty()) box = aabb(point3(x0, params.region.minimum.y(), z0), point3(x0, params.region.minimum.y(), z0));
+		for (int a = 0; a < 3; ++a)
+		{
+			h.box_min[a] = static_cast<float>(box.minimum[a]);
+			h.box_max[a] = static_cast<float>(box.maximum[a]);
+		}
+
+		// 대체 구체 : 구체들의 중점 평균에 놓고, 단면적의 합이 같도록 반지름을 정함. (경계 상자보다 커지지는 않게 함.)
+		const point3 proxy_center = (count > 0) ? center_sum / count : box.centroid();
+		const double bound_radius = 0.5 * (box.maximum - box.minimum).length();
+		h.proxy[0] = static_cast<float>(proxy_center.x());
+		h.proxy[1] = static_cast<float>(proxy_center.y());
+		h.proxy[2] = static_cast<float>(proxy_center.z());
+		h.proxy[3] = static_cast<float>(std::min(bound_radius, std::sqrt(area_sum)));
+
+		out.write(reinterpret_cast<const char*>(data.data()), data.size() * sizeof(float));
+		offset += data.size() * sizeof(float);
+	}
+
+	out.seekp(static_cast<std::streamoff>(header_offset));
+	out.write(reinterpret_cast<const char*>(headers.data()), headers.size() * sizeof(sphere_cloud_cluster_header));
+	if (!out)
+	{
+		std::cerr << "Cannot write sphere cloud: " << path << '\n';
+		return false;
+	}
+	return true;
+}
+
+// 디스크에서 읽어온 클러스터 하나 (청크)
+/*
+	구체 데이터와 함께, 그 구체들만으로 만든 BVH(청크 내부의 계층 구조)를 가지고 있음.
+	청크를 읽어올 때마다 새로 만들고 청크를 내보낼 때 같이 버리므로, 메모리에는 읽어온 청크의 BVH 만 존재함.
+
+	BVH 노드 배치는 triangle_mesh 의 BVH 와 같음. (32 바이트 노드, 깊이 우선 순서, 리프가 가리키는 구체들은 연속된 구간)
+*/
+class sphere_cloud_chunk
+{
+public:
+	std::vector<float> spheres; // 구체마다 float 4개 (build() 이후에는 BVH 리프 순서로 재배열됨.)
+
+	size_t sphere_count() const { return spheres.size() / sphere_cloud_floats_per_sphere; }
+
+	// spheres 를 채운 뒤 반드시 호출해야 함. BVH 를 만들면서 구체 순서를 재배열함.
+	void build()
+	{
+		nodes.clear();
+		const size_t n = sphere_count();
+		if (n == 0) return;
+
+		std::vector<std::uint32_t> order(n);
+		for (size_t s = 0; s < n; ++s) order[s] = static_cast<std::uint32_t>(s);
+
+		nodes.reserve(2 * n / leaf_size + 1);
+		build_node(order, 0, static_cast<std::uint32_t>(n));
+		nodes.shrink_to_fit(); // memory_bytes() 가 실제로 사용하는 크기가 되도록 여유 공간을 돌려줌.
+
+		std::vector<float> sorted(spheres.size());
+		for (size_t s = 0; s < n; ++s)
+			std::copy_n(&spheres[static_cast<size_t>(order[s]) * sphere_cloud_floats_per_sphere], sphere_cloud_floats_per_sphere,
+						&sorted[s * sphere_cloud_floats_per_sphere]);
+		spheres.swap(sorted);
+	}
+
+	bool hit(const ray& r, double ray_tmin, double ray_tmax, hit_record& rec) const
+	{
+		if (nodes.empty()) return false;
+
+		const vec3 inv_dir(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+
+		std::uint32_t stack[64]; // 순회할 노드 인덱스를 저장하는 스택 (재귀 호출 대신 사용)
+		int sp = 0;
+		std::uint32_t node = 0;
+
+		double closest = ray_tmax;
+		const float* best = nullptr;
+
+		while (true)
+		{
+			const bvh_node& n = nodes[node];
+			TRACE_COUNT(node_visits, 1);
+
+			if (!node_hit(n, r, inv_dir, ray_tmin, closest))
+			{
+				if (sp == 0) break;
+				node = stack[--sp];
+				continue;
+			}
+
+			if (n.count > 0)
+			{
+				closest_sphere(&spheres[static_cast<size_t>(n.first) * sphere_cloud_floats_per_sphere], n.count, r, ray_tmin, closest, best);
+				if (sp == 0) break;
+				node = stack[--sp];
+			}
+			else
+			{
+				// 반직선 방향상 가까운 자식 노드부터 방문함.
+				std::uint32_t left = node + 1, right = n.first;
+				if (r.direction()[n.axis] < 0) std::swap(left, right);
+				stack[sp++] = right;
+				node = left;
+			}
+		}
+
+		return set_hit_record(best, closest, r, rec);
+	}
+
+	// 청크가 메모리에서 차지하는 크기 (캐시의 메모리 예산은 이 값으로 계산함.)
+	size_t memory_bytes() const { return sizeof(*this) + spheres.capacity() * sizeof(float) + nodes.capacity() * sizeof(bvh_node); }
+
+	// float 4개(중점 x, y, z, 반지름)씩 저장된 구체 count 개 중에서 가장 가까운 충돌 지점을 찾음. (대체 구체처럼 BVH 가 없는 구체들에 사용)
+	static bool hit_spheres(const float* spheres, size_t count, const ray& r, double ray_tmin, double ray_tmax, hit_record& rec)
+	{
+		double closest = ray_tmax;
+		const float* best = nullptr;
+		closest_sphere(spheres, count, r, ray_tmin, closest, best);
+		return set_hit_record(best, closest, r, rec);
+	}
+
+private:
+	// BVH 노드 (32 바이트, triangle_mesh 와 같은 배치)
+	struct bvh_node
+	{
+		float bmin[3];
+		float bmax[3];
+		std::uint32_t first;
+		std::uint16_t count;
+		std::uint16_t axis; // 내부 노드를 분할한 축
+	};
+
+	// 리프 노드 하나에 담을 최대 구체 개수
+	/*
+		구체 하나(16 바이트)가 노드 하나(32 바이트)보다 작으므로, 삼각형 메쉬(4개)보다 리프를 크게 잡아서
+		BVH 가 구체 데이터보다 메모리를 많이 차지하지 않도록 함. (노드 수가 약 n / 4 개가 되어 데이터의 절반 정도)
+	*/
+	static const std::uint32_t leaf_size = 8;
+
+	std::vector<bvh_node> nodes;
+
+	float center(std::uint32_t s, int axis) const { return spheres[static_cast<size_t>(s) * sphere_cloud_floats_per_sphere + axis]; }
+	float radius(std::uint32_t s) const { return spheres[static_cast<size_t>(s) * sphere_cloud_floats_per_sphere + 3]; }
+	static float infinity_f() { return std::numeric_limits<float>::infinity(); }
+
+	// closest 보다 가까운 충돌 지점이 있으면 closest 와 best(충돌한 구체)를 갱신함. (sphere::hit() 과 같은 계산)
+	static void closest_sphere(const float* spheres, size_t count, const ray& r, double ray_tmin, double& closest, const float*& best)
+	{
+		TRACE_COUNT(primitive_tests, count);
+
+		const vec3& d = r.direction();
+		const double a = d.length_squared();
+
+		for (size_t s = 0; s < count; ++s)
+		{
+			const float* sphere_data = spheres + s * sphere_cloud_floats_per_sphere;
+			const vec3 oc = r.origin() - point3(sphere_data[0], sphere_data[1], sphere_data[2]);
+			const double radius = sphere_data[3];
+			const double half_b = dot(oc, d);
+			const double c = oc.length_squared() - radius * radius;
+			const double discriminant = half_b * half_b - a * c;
+			if (discriminant < 0) continue;
+
+			const double sqrtd = std::sqrt(discriminant);
+			double root = (-half_b - sqrtd) / a;
+			if (root <= ray_tmin || closest <= root)
+			{
+				root = (-half_b + sqrtd) / a;
+				if (root <= ray_tmin || closest <= root) continue;
+			}
+			closest = root;
+			best = sphere_data;
+		}
+	}
+
+	static bool set_hit_record(const float* best, double t, const ray& r, hit_record& rec)
+	{
+		if (!best) return false;
+
+		rec.t = t;
+		rec.p = r.at(rec.t);
+		rec.normal = (rec.p - point3(best[0], best[1], best[2])) / static_cast<double>(best[3]);
+		return true;
+	}
+
+	static bool node_hit(const bvh_node& n, const ray& r, const vec3& inv_dir, double ray_tmin, double ray_tmax)
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			double t0 = (n.bmin[a] - r.origin()[a]) * inv_dir[a];
+			double t1 = (n.bmax[a] - r.origin()[a]) * inv_dir[a];
+			if (inv_dir[a] < 0.0) std::swap(t0, t1);
+			ray_tmin = t0 > ray_tmin ? t0 : ray_tmin;
+			ray_tmax = t1 < ray_tmax ? t1 : ray_tmax;
+			if (ray_tmax < ray_tmin) return false;
+		}
+		return true;
+	}
+
+	// order[begin, end) 구간의 구체들을 감싸는 노드를 만들고, 구체가 많으면 중점 기준으로 둘로 나눠서 재귀적으로 자식 노드를 만듦.
+	void build_node(std::vector<std::uint32_t>& order, std::uint32_t begin, std::uint32_t end)
+	{
+		const std::uint32_t index = static_cast<std::uint32_t>(nodes.size());
+		nodes.push_back(bvh_node());
+
+		bvh_node n;
+		float cmin[3], cmax[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			n.bmin[a] = cmin[a] = infinity_f();
+			n.bmax[a] = cmax[a] = -infinity_f();
+		}
+
+		for (std::uint32_t k = begin; k < end; ++k)
+		{
+			const std::uint32_t s = order[k];
+			for (int a = 0; a < 3; ++a)
+			{
+				n.bmin[a] = std::min(n.bmin[a], center(s, a) - radius(s));
+				n.bmax[a] = std::max(n.bmax[a], center(s, a) + radius(s));
+				cmin[a] = std::min(cmin[a], center(s, a));
+				cmax[a] = std::max(cmax[a], center(s, a));
+			}
+		}
+
+		int axis = 0;
+		for (int a = 1; a < 3; ++a)
+			if (cmax[a] - cmin[a] > cmax[axis] - cmin[axis]) axis = a;
+
+		// 중점이 모두 같은 구체들은 나눌 기준이 없으므로 리프로 만듦. (count 필드에 담을 수 없을 만큼 많으면 순서대로 반씩 나눔.)
+		const bool degenerate = cmax[axis] <= cmin[axis];
+		if (end - begin <= leaf_size || (degenerate && end - begin <= 0xffff))
+		{
+			n.first = begin;
+			n.count = static_cast<std::uint16_t>(end - begin);
+			n.axis = 0;
+			nodes[index] = n;
+			return;
+		}
+
+		const std::uint32_t mid = begin + (end - begin) / 2;
+		if (!degenerate)
+		{
+			std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+							 [&](std::uint32_t a, std::uint32_t b) { return center(a, axis) < center(b, axis); });
+		}
+
+		build_node(order, begin, mid); // 왼쪽 자식은 바로 다음 인덱스에 만들어짐.
+		n.first = static_cast<std::uint32_t>(nodes.size()); // 오른쪽 자식의 인덱스
+		n.count = 0;
+		n.axis = static_cast<std::uint16_t>(axis);
+		build_node(order, mid, end);
+		nodes[index] = n;
+	}
+};
+
+// 청크를 필요할 때 디스크에서 읽어들이고, 메모리 예산 안에서만 보관하는 LRU 캐시
+/*
+	여러 스레드에서 동시에 acquire() 를 호출해도 안전함.
+
+	이미 메모리에 있는 청크는 잠금 없이 shared_ptr 를 원자적으로 읽어서 반환하고,
+	디스크에서 읽거나 다른 청크를 내보낼 때만 mutex 로 잠금.
+
+	청크를 사용할 때마다 전역 카운터를 하나 증가시킨 값을 그 청크의 마지막 사용 시각(last_used)으로 기록하고,
+	내보낼 때는 메모리에 있는 청크 중에서 이 값이 가장 작은(가장 오래 전에 사용한) 청크를 고름. (LRU, least recently used)
+	메모리에 있는 청크 수는 예산 / 청크 크기 정도로 작으므로, 매번 전체를 훑어서 찾아도 디스크에서 읽는 시간에 비하면 무시할 수 있음.
+
+	반직선이 사용 중인 청크가 내보내지더라도, acquire() 가 반환한 shared_ptr 가 살아있는 동안은 데이터가 해제되지 않음.
+	그래서 실제 메모리 사용량은 예산보다 (스레드 수 x 청크 하나의 크기)만큼 잠깐 커질 수 있음.
+	읽어오는 중인 청크도 BVH 를 다 만든 뒤에야 크기를 알 수 있으므로, 그때 다른 청크를 내보내서 예산을 맞춤.
+*/
+class sphere_cloud_store
+{
+public:
+	// path 의 클러스터 정보(인덱스)만 읽어들임.
+	bool open(const std::string& _path)
+	{
+		path = _path;
+		file.open(path, std::ios::binary);
+		char magic[sizeof(sphere_cloud_magic)];
+		std::uint64_t cluster_count = 0;
+		if (!file || !file.read(magic, sizeof(magic)) || !std::equal(magic, magic + sizeof(magic), sphere_cloud_magic)
+			|| !file.read(reinterpret_cast<char*>(&cluster_count), sizeof(cluster_count)))
+		{
+			std::cerr << "Not a sphere cloud file: " << path << '\n';
+			return false;
+		}
+
+		headers.resize(static_cast<size_t>(cluster_count));
+		if (!file.read(reinterpret_cast<char*>(headers.data()), headers.size() * sizeof(sphere_cloud_cluster_header)))
+		{
+			std::cerr << "Unexpected end of sphere cloud index: " << path << '\n';
+			return false;
+		}
+
+		resident.assign(headers.size(), nullptr);
+		last_used.reset(new std::atomic<std::uint64_t>[headers.size()]);
+		for (size_t k = 0; k < headers.size(); ++k) last_used[k].store(0, std::memory_order_relaxed);
+		return true;
+	}
+
+	// 메모리에 올려둘 청크의 최대 크기 (0 이면 제한하지 않음.)
+	void set_data_budget(size_t bytes)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		data_budget = bytes;
+		evict_to_fit(0);
+	}
+
+	size_t data_budget_bytes() const { std::lock_guard<std::mutex> lock(mutex); return data_budget; }
+
+	size_t cluster_count() const { return headers.size(); }
+	const sphere_cloud_cluster_header& header(size_t k) const { return headers[k]; }
+
+	// 청크 k 를 반환함. 메모리에 없으면 디스크에서 읽어옴.
+	std::shared_ptr<const sphere_cloud_chunk> acquire(size_t k)
+	{
+		std::shared_ptr<const sphere_cloud_chunk> data = std::atomic_load(&resident[k]);
+		if (!data)
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			data = std::atomic_load(&resident[k]);
+			if (!data) data = load(k); // 기다리는 동안 다른 스레드가 이미 읽어왔을 수 있으므로 다시 확인함.
+		}
+		touch(k);
+		return data;
+	}
+
+	// 청크 k 가 메모리에 있으면 반환하고, 없으면 읽어오지 않고 nullptr 를 반환함.
+	std::shared_ptr<const sphere_cloud_chunk> try_acquire(size_t k)
+	{
+		std::shared_ptr<const sphere_cloud_chunk> data = std::atomic_load(&resident[k]);
+		if (data) touch(k);
+		return data;
+	}
+
+	// 메모리에 항상 올라가 있는 클러스터 정보의 크기
+	size_t index_bytes() const
+	{
+		return headers.capacity() * sizeof(sphere_cloud_cluster_header) + headers.size() * (sizeof(resident[0]) + sizeof(last_used[0]));
+	}
+
+	// 지금 메모리에 올라와 있는 청크의 크기와 지금까지의 최댓값
+	size_t resident_bytes() const { std::lock_guard<std::mutex> lock(mutex); return data_bytes; }
+	size_t peak_resident_bytes() const { std::lock_guard<std::mutex> lock(mutex); return peak_data_bytes; }
+	size_t load_count() const { std::lock_guard<std::mutex> lock(mutex); return loads; }
+	size_t eviction_count() const { std::lock_guard<std::mutex> lock(mutex); return evictions; }
+
+	// 모든 청크를 내보내고 통계를 초기화함. (벤치마크에서 같은 조건으로 다시 렌더링할 때 사용)
+	void reset()
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		for (size_t k : resident_list) std::atomic_store(&resident[k], std::shared_ptr<const sphere_cloud_chunk>());
+		resident_list.clear();
+		resident_bytes_list.clear();
+		data_bytes = peak_data_bytes = loads = evictions = 0;
+	}
+
+private:
+	std::string path;
+	std::ifstream file; // mutex 로 잠근 상태에서만 사용
+	std::vector<sphere_cloud_cluster_header> headers;
+	std::vector<std::shared_ptr<const sphere_cloud_chunk>> resident; // 메모리에 없는 청크는 nullptr (std::atomic_load / atomic_store 로만 접근)
+	std::unique_ptr<std::atomic<std::uint64_t>[]> last_used; // 청크마다 마지막으로 사용한 시각
+	std::atomic<std::uint64_t> use_clock{ 0 };
+
+	mutable std::mutex mutex;
+	std::vector<size_t> resident_list; // 메모리에 있는 청크 번호들
+	std::vector<size_t> resident_bytes_list; // resident_list 의 각 청크의 크기
+	size_t data_budget = 0;
+	size_t data_bytes = 0, peak_data_bytes = 0;
+	size_t loads = 0, evictions = 0;
+
+	void touch(size_t k) { last_used[k].store(use_clock.fetch_add(1, std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+	// mutex 로 잠근 상태에서 호출해야 함.
+	std::shared_ptr<const sphere_cloud_chunk> load(size_t k)
+	{
+		const sphere_cloud_cluster_header& h = headers[k];
+		const size_t file_bytes = static_cast<size_t>(h.count) * sphere_cloud_floats_per_sphere * sizeof(float);
+
+		auto chunk = std::make_shared<sphere_cloud_chunk>();
+		chunk->spheres.resize(static_cast<size_t>(h.count) * sphere_cloud_floats_per_sphere);
+		file.clear();
+		file.seekg(static_cast<std::streamoff>(h.offset));
+		if (!file.read(reinterpret_cast<char*>(chunk->spheres.data()), file_bytes))
+		{
+			// 읽지 못한 청크는 비어있는 것으로 취급함. (렌더링을 멈추지 않고 구멍으로 남김.)
+			std::cerr << "Cannot read sphere cloud cluster " << k << ": " << path << '\n';
+			chunk->spheres.clear();
+			chunk->spheres.shrink_to_fit();
+		}
+		chunk->build();
+
+		const size_t bytes = chunk->memory_bytes();
+		evict_to_fit(bytes);
+
+		std::shared_ptr<const sphere_cloud_chunk> result = chunk;
+		std::atomic_store(&resident[k], result);
+		resident_list.push_back(k);
+		resident_bytes_list.push_back(bytes);
+		data_bytes += bytes;
+		peak_data_bytes = std::max(peak_data_bytes, data_bytes);
+		++loads;
+		return result;
+	}
+
+	// 새로 incoming 바이트를 올려도 예산을 넘지 않을 때까지 가장 오래 전에 사용한 청크부터 내보냄. (mutex 로 잠근 상태에서 호출해야 함.)
+	void evict_to_fit(size_t incoming)
+	{
+		if (data_budget == 0) return;
+
+		while (!resident_list.empty() && data_bytes + incoming > data_budget)
+		{
+			size_t oldest = 0;
+			for (size_t i = 1; i < resident_list.size(); ++i)
+			{
+				if (last_used[resident_list[i]].load(std::memory_order_relaxed) < last_used[resident_list[oldest]].load(std::memory_order_relaxed))
+					oldest = i;
+			}
+
+			std::atomic_store(&resident[resident_list[oldest]], std::shared_ptr<const sphere_cloud_chunk>());
+			data_bytes -= resident_bytes_list[oldest];
+			resident_list[oldest] = resident_list.back();
+			resident_list.pop_back();
+			resident_bytes_list[oldest] = resident_bytes_list.back();
+			resident_bytes_list.pop_back();
+			++evictions;
+		}
+	}
+};
+
+// 구체 클라우드의 클러스터 하나 (BVH 의 리프)
+/*
+	use_proxy 가 true 면 대체 구체 하나로, false 면 캐시에서 가져온 구체들로 교차 검사를 함.
+*/
+class sphere_cloud_cluster : public hittable
+{
+public:
+	sphere_cloud_cluster(std::shared_ptr<sphere_cloud_store> _store, size_t _index) : store(_store), index(_index)
+	{
+		const sphere_cloud_cluster_header& h = store->header(index);
+		box = aabb(point3(h.box_min[0], h.box_min[1], h.box_min[2]), point3(h.box_max[0], h.box_max[1], h.box_max[2]));
+	}
+
+	bool use_proxy = false;
+
+	bool hit(const ray& r, double ray_tmin, double ray_tmax, hit_record& rec) const override
+	{
+		TRACE_COUNT(node_visits, 1);
+		if (!box.hit(r, ray_tmin, ray_tmax)) return false;
+
+		// 대체 구체는 클러스터 정보에 구체 데이터와 같은 형식(float 4개)으로 들어있음.
+		if (use_proxy) return sphere_cloud_chunk::hit_spheres(store->header(index).proxy, 1, r, ray_tmin, ray_tmax, rec);
+
+		// 반직선이 경계 상자와 만났을 때 처음으로 구체 데이터가 필요해지므로, 이때 디스크에서 읽어옴.
+		return store->acquire(index)->hit(r, ray_tmin, ray_tmax, rec);
+	}
+
+	aabb bounding_box() const override { return box; }
+
+	// 캐시는 복사하지 않고 공유함. (클러스터 데이터는 읽기 전용이고, 캐시는 여러 스레드에서 사용해도 안전함.)
+	shared_ptr<hittable> clone() const override { return make_shared<sphere_cloud_cluster>(*this); }
+
+	// 클러스터의 경계 구(bounding sphere)가 화면에 투영되었을 때의 지름 (픽셀 단위, 카메라가 경계 구 안에 있으면 무한대)
+	double projected_pixels(const camera& cam) const
+	{
+		const double bound_radius = 0.5 * (box.maximum - box.minimum).length();
+		const double distance = (box.centroid() - cam.center).length() - bound_radius;
+		if (distance <= 0.0) return infinity;
+		return 2.0 * bound_radius * cam.focal_length / distance * (cam.image_height / cam.viewport_height);
+	}
+
+private:
+	std::shared_ptr<sphere_cloud_store> store;
+	size_t index;
+	aabb box;
+};
+
+// 클러스터들을 BVH 로 묶은 구체 클라우드 전체
+class sphere_cloud : public hittable
+{
+public:
+	// path 의 구체 클라우드를 열어서 클러스터 정보만 읽어들임. (구체 데이터는 렌더링 중에 필요할 때 읽어옴.)
+	/*
+		budget_bytes 는 클러스터 정보와 BVH 까지 포함한 전체 메모리 예산이고, 0 이면 제한하지 않음.
+		항상 메모리에 있어야 하는 부분(fixed_bytes())을 뺀 나머지가 구체 데이터를 캐시할 수 있는 크기가 됨.
+	*/
+	bool open(const std::string& path, size_t budget_bytes)
+	{
+		store = std::make_shared<sphere_cloud_store>();
+		if (!store->open(path)) return false;
+
+		hittable_list list;
+		clusters.clear();
+		for (size_t k = 0; k < store->cluster_count(); ++k)
+		{
+			clusters.push_back(make_shared<sphere_cloud_cluster>(store, k));
+			list.add(clusters.back());
+		}
+		root = list.objects().empty() ? shared_ptr<hittable>(make_shared<hittable_list>()) : shared_ptr<hittable>(make_shared<bvh_node>(list));
+
+		set_memory_budget(budget_bytes);
+		return true;
+	}
+
+	// 전체 메모리 예산을 다시 정함. other_bytes 는 구체 클라우드 밖에서 같은 예산으로 사용하는 메모리(out_of_core.h 의 반직선 큐 등)
+	void set_memory_budget(size_t budget_bytes, size_t other_bytes = 0)
+	{
+		const size_t fixed = fixed_bytes() + other_bytes;
+		if (budget_bytes > 0 && budget_bytes <= fixed)
+			std::cerr << "Sphere cloud index (" << fixed << " bytes) does not fit in the memory budget; clusters will be reloaded on every use.\n";
+		store->set_data_budget(budget_bytes == 0 ? 0 : std::max<size_t>(budget_bytes > fixed ? budget_bytes - fixed : 0, 1));
+	}
+
+	// 렌더링하는 동안 항상 메모리에 있는 부분의 크기 (클러스터 정보, 클러스터 객체, BVH 노드의 대략적인 합)
+	size_t fixed_bytes() const
+	{
+		// 클러스터마다 객체 하나와 BVH 노드 하나(내부 노드 수는 리프 수와 거의 같음.), make_shared 의 제어 블록 두 개가 생김.
+		const size_t per_cluster = sizeof(sphere_cloud_cluster) + sizeof(bvh_node) + 2 * 16 + sizeof(shared_ptr<sphere_cloud_cluster>);
+		return store->index_bytes() + clusters.size() * per_cluster;
+	}
+
+	// 카메라에 투영된 지름이 max_proxy_pixels 픽셀 이하인 클러스터들은 대체 구체로 렌더링하도록 설정함.
+	/*
+		max_proxy_pixels 가 0 이면 모든 클러스터를 원래의 구체들로 렌더링함.
+		대체 구체로 바뀐 클러스터 때문에 달라지는 픽셀은 그 클러스터가 투영된 max_proxy_pixels 지름의 원 안에만 생기므로,
+		이 값이 화면 공간에서의 오차 한계가 됨.
+
+		대체 구체로 렌더링하기로 한 클러스터의 데이터는 더 이상 필요 없으므로 캐시에서 내보내질 수 있음.
+		반환값은 대체 구체로 렌더링할 클러스터 수.
+	*/
+	size_t select_lod(const camera& cam, double max_proxy_pixels)
+	{
+		size_t proxies = 0;
+		for (auto& cluster : clusters)
+		{
+			cluster->use_proxy = max_proxy_pixels > 0.0 && cluster->projected_pixels(cam) <= max_proxy_pixels;
+			if (cluster->use_proxy) ++proxies;
+		}
+		return proxies;
+	}
+
+	bool hit(const ray& r, double ray_tmin, double ray_tmax, hit_record& rec) const override { return root->hit(r, ray_tmin, ray_tmax, rec); }
+
+	aabb bounding_box() const override { return root->bounding_box(); }
+
+	// 클러스터 정보와 캐시를 공유하는 얕은 복사본 (구체 데이터는 어차피 필요할 때 각자 읽어가므로 노드별로 복사할 필요가 없음.)
+	shared_ptr<hittable> clone() const override { return make_shared<sphere_cloud>(*this); }
+
+	sphere_cloud_store& cache() const { return *store; }
+	size_t cluster_count() const { return clusters.size(); }
+	bool uses_proxy(size_t k) const { return clusters[k]->use_proxy; }
+
+private:
+	std::shared_ptr<sphere_cloud_store> store;
+	std::vector<shared_ptr<sphere_cloud_cluster>> clusters;
+	shared_ptr<hittable> root;
+};
+
+#endif // !SPHERE_CLOUD_H
+
+/*
+	구체 클라우드의 LOD 와 지연 로딩
+
+
+	포인트 클라우드처럼 아주 작은 구체가 수억 개 있는 씬은 구체 데이터만으로도 메모리보다 커질 수 있고,
+	멀리 있는 구체들은 어차피 한 픽셀보다 작아서 하나하나 구분되어 보이지도 않음.
+
+	1. LOD (level of detail)
+
+		구체들을 공간적으로 가까운 것끼리 클러스터로 묶고, 클러스터마다 대체 구체를 하나씩 미리 만들어둠.
+		대체 구체는 구체들의 중점 평균에 놓고, 반지름은 구체들의 단면적 합과 같은 단면적을 갖도록 정함.
+		(구체들이 서로 가리지 않는다고 가정했을 때, 멀리서 보면 화면을 가리는 넓이가 비슷해짐.)
+
+		카메라에서 본 클러스터의 투영 크기가 기준(max_proxy_pixels)보다 작으면 대체 구체로 렌더링하는데,
+		이렇게 바뀌는 부분은 그 클러스터가 차지하는 몇 픽셀 안에서만 원래 이미지와 달라지므로 오차가 화면 공간에서 제한됨.
+
+	2. 지연 로딩 (lazy loading)
+
+		처음에는 클러스터 정보(경계 상자, 대체 구체, 파일 위치)만 읽어두고,
+		대체 구체로 렌더링하지 않는 클러스터의 경계 상자에 반직선이 처음 닿을 때 구체 데이터를 디스크에서 읽어옴.
+		화면에 보이지 않거나 멀리 있는 클러스터는 끝까지 읽지 않음.
+
+	3. 메모리 예산
+
+		읽어온 데이터의 합이 예산을 넘으면 가장 오래 전에 사용한 클러스터부터 내보냄. (LRU)
+		내보낸 클러스터가 다시 필요해지면 디스크에서 다시 읽으므로, 예산이 작을수록 메모리는 적게 쓰는 대신 읽기 횟수가 늘어남.
+		LOD 로 대체 구체를 쓰는 클러스터가 많아질수록 읽어야 할 데이터 자체가 줄어들어서 같은 예산으로도 덜 다시 읽게 됨.
+*/
@@ -0,0 +1,101 @@
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// 미리 만들어 둔 스레드들이 작업 큐에서 작업을 하나씩 꺼내 실행하는 스레드 풀 클래스
+/*
+	작업이 생길 때마다 std::thread 를 새로 만들면,
+	스레드 생성 / 종료 비용이 작은 작업(작은 이미지의 타일 하나 등)보다 커질 수 있음.
+
+	그래서 스레드들은 처음에 한 번만 만들어두고,
+	submit() 으로 들어온 작업들을 먼저 들어온 순서대로(FIFO) 나눠서 실행하도록 함.
+*/
+class thread_pool
+{
+public:
+	// thread_count 가 0 이면 std::thread::hardware_concurrency() 개수만큼 스레드를 생성함.
+	explicit thread_pool(int thread_count = 0)
+	{
+		int n = thread_count > 0 ? thread_count : static_cast<int>(std::thread::hardware_concurrency());
+		n = std::max(n, 1);
+		for (int k = 0; k < n; ++k) workers.emplace_back(&thread_pool::worker_loop, this);
+	}
+
+	// 소멸자에서는 큐에 남은 작업을 모두 끝낸 뒤 스레드들을 종료시킴.
+	~thread_pool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			stopping = true;
+		}
+		task_cv.notify_all();
+		for (auto& th : workers) th.join();
+	}
+
+	// 복사하면 같은 스레드들을 두 객체가 관리하게 되므로 복사를 금지함.
+	thread_pool(const thread_pool&) = delete;
+	thread_pool& operator=(const thread_pool&) = delete;
+
+	int size() const { return static_cast<int>(workers.size()); }
+
+	// 작업을 큐에 추가함.
+	void submit(std::function<void()> task)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mtx);
+			tasks.push_back(std::move(task));
+		}
+		task_cv.notify_one();
+	}
+
+	// 큐가 비고 실행 중인 작업도 없을 때까지 기다림.
+	void wait_idle()
+	{
+		std::unique_lock<std::mutex> lock(mtx);
+		idle_cv.wait(lock, [this]() { return tasks.empty() && active == 0; });
+	}
+
+private:
+	std::vector<std::thread> workers;
+	std::deque<std::function<void()>> tasks; // 실행을 기다리는 작업 큐
+	std::mutex mtx;
+	std::condition_variable task_cv; // 작업이 추가되었거나 종료할 때 스레드를 깨움
+	std::condition_variable idle_cv; // 모든 작업이 끝났을 때 wait_idle() 을 깨움
+	int active = 0; // 실행 중인 작업 개수
+	bool stopping = false;
+
+	void worker_loop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+			{
+				std::unique_lock<std::mutex> lock(mtx);
+				task_cv.wait(lock, [this]() { return stopping || !tasks.empty(); });
+				if (tasks.empty()) return; // stopping 이면서 남은 작업이 없으면 종료
+
+				task = std::move(tasks.front());
+				tasks.pop_front();
+				++active;
+			}
+
+			task();
+
+			{
+				std::lock_guard<std::mutex> lock(mtx);
+				--active;
+				if (tasks.empty() && active == 0) idle_cv.notify_all();
+			}
+		}
+	}
+};
+
+#endif // !THREAD_POOL_H
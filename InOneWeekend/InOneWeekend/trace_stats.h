@@ -0,0 +1,65 @@
+#ifndef TRACE_STATS_H
+#define TRACE_STATS_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include <chrono>
+#include <cstdint>
+
+// 교차 검사 통계 카운터 (heatmap.h 의 통계 렌더링 모드에서 사용)
+/*
+	RT_TRACE_STATS 가 1 이면 hit() 함수들과 셰이딩 함수들이 스레드별 카운터를 증가시키고,
+	0 이면 TRACE_COUNT() 가 아무 코드도 만들지 않으므로 카운터가 완전히 제거됨.
+
+	따로 지정하지 않으면 Debug 빌드에서는 켜지고, Release 빌드(NDEBUG)에서는 꺼짐.
+	스테이징 환경처럼 최적화된 빌드에서 통계를 보고 싶다면 전처리기 정의에 RT_TRACE_STATS=1 을 추가하면 됨.
+*/
+#ifndef RT_TRACE_STATS
+#ifdef NDEBUG
+#define RT_TRACE_STATS 0
+#else
+#define RT_TRACE_STATS 1
+#endif
+#endif
+
+// 사이클 카운터를 읽기 위한 intrinsic 헤더 (x86 / x64 에서만 사용 가능)
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define TRACE_STATS_HAS_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define TRACE_STATS_HAS_RDTSC 1
+#endif
+
+// 스레드 하나가 지금까지 수행한 작업량
+struct trace_counters
+{
+	std::uint64_t primitive_tests = 0; // 물체(구체, 삼각형)와의 교차 검사 횟수
+	std::uint64_t node_visits = 0; // 가속 구조(BVH) 노드 방문 횟수
+	std::uint64_t bounces = 0; // 물체에 부딪혀 튕겨나간 반직선의 개수
+};
+
+#if RT_TRACE_STATS
+// 스레드마다 따로 존재하는 카운터 (thread_local 이므로 원자적 연산이나 잠금 없이 증가시킬 수 있음.)
+inline trace_counters& thread_trace_counters()
+{
+	thread_local trace_counters counters;
+	return counters;
+}
+
+#define TRACE_COUNT(field, n) (thread_trace_counters().field += static_cast<std::uint64_t>(n))
+#else
+#define TRACE_COUNT(field, n) ((void)0)
+#endif
+
+// 현재 시각을 CPU 사이클 단위로 반환 (rdtsc 를 사용할 수 없는 환경에서는 나노초 단위)
+inline std::uint64_t read_cycle_counter()
+{
+#ifdef TRACE_STATS_HAS_RDTSC
+	return __rdtsc();
+#else
+	return static_cast<std::uint64_t>(
+		std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+#endif // !TRACE_STATS_H
@@ -0,0 +1,737 @@
+#ifndef TRIANGLE_MESH_H
+#define TRIANGLE_MESH_H
+// 헤더 가드를 위한 전처리기 선언
+
+#include "rtweekend.h"
+
+#include "aabb.h"
+#include "hittable.h"
+#include "trace_stats.h"
+#include "vec3.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+
+// SSE2 를 사용할 수 있는 환경 (fast_math.h 와 같은 조건)
+/*
+	TRIANGLE_MESH_USE_SSE2      : 리프의 삼각형 2개씩을 __m128d 의 두 레인에 담아서 교차 검사함. (intersect_pair())
+	TRIANGLE_MESH_USE_PREFETCH  : 캐시 프리페치 명령(prefetcht0)을 사용함. (hit_interleaved())
+*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define TRIANGLE_MESH_USE_SSE2 1
+#define TRIANGLE_MESH_USE_PREFETCH 1
+#endif
+
+// 삼각형 메쉬 클래스를 hittable(피충돌 물체) 추상 클래스로부터 상속받아 정의
+/*
+	삼각형마다 객체를 하나씩 만들면, 수백만 개의 삼각형에 대해
+	객체 헤더, shared_ptr, 가상 함수 테이블 포인터, 중복된 정점 좌표가 모두 따로 저장됨.
+
+	그래서 정점 좌표와 노멀은 공유되는 하나의 버퍼에 float 로 저장하고,
+	삼각형은 그 버퍼를 가리키는 인덱스 3개로만 표현함. (indexed vertex buffer)
+
+	또한, 메쉬 내부에 자체적인 BVH(bounding volume hierarchy)를 만들어서
+	hit() 에서 모든 삼각형을 검사하지 않고 반직선이 지나가는 노드의 삼각형들만 검사함.
+*/
+class triangle_mesh : public hittable
+{
+public:
+	std::vector<float> positions; // 정점 좌표 (x, y, z 순서로 정점마다 3개씩)
+	std::vector<float> normals; // 정점 노멀 (x, y, z 순서로 노멀마다 3개씩, 없으면 비어있음)
+	std::vector<std::uint32_t> indices; // 삼각형마다 정점 인덱스 3개
+	std::vector<std::uint32_t> normal_indices; // 삼각형마다 노멀 인덱스 3개 (비어있으면 indices 를 그대로 사용)
+
+	size_t vertex_count() const { return positions.size() / 3; }
+	size_t triangle_count() const { return indices.size() / 3; }
+
+	// 정점 / 인덱스 버퍼를 모두 채운 뒤 반드시 호출해야 함. BVH 를 만들면서 삼각형 순서를 재배열함.
+	void build()
+	{
+		nodes.clear();
+		const size_t n = triangle_count();
+		if (n == 0) return;
+
+		// 각 삼각형의 경계 상자 중점을 미리 계산해 둠 (BVH 를 분할할 때 기준으로 사용)
+		std::vector<float> centroids(n * 3);
+		for (size_t t = 0; t < n; ++t)
+		{
+			for (int a = 0; a < 3; ++a)
+			{
+				float lo = vertex(indices[t * 3], a), hi = lo;
+				for (int k = 1; k < 3; ++k)
+				{
+					lo = std::min(lo, vertex(indices[t * 3 + k], a));
+					hi = std::max(hi, vertex(indices[t * 3 + k], a));
+				}
+				centroids[t * 3 + a] = 0.5f * (lo + hi);
+			}
+		}
+
+		std::vector<std::uint32_t> order(n);
+		for (size_t t = 0; t < n; ++t) order[t] = static_cast<std::uint32_t>(t);
+
+		nodes.reserve(2 * n / leaf_size + 1);
+		build_node(order, centroids, 0, static_cast<std::uint32_t>(n));
+
+		// BVH 리프 노드들이 연속된 삼각형 구간을 가리키도록 인덱스 버퍼를 재배열함.
+		reorder(indices, order);
+		if (!normal_indices.empty()) reorder(normal_indices, order);
+	}
+
+	bool hit(const ray& r, double ray_tmin, double ray_tmax, hit_record& rec) const override
+	{
+		if (nodes.empty()) return false;
+
+		const watertight_ray wr(r);
+		const vec3 inv_dir(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+
+		std::uint32_t stack[64]; // 순회할 노드 인덱스를 저장하는 스택 (재귀 호출 대신 사용)
+		int sp = 0;
+		std::uint32_t node = 0;
+
+		double closest = ray_tmax;
+		std::uint32_t best = 0;
+		double best_b0 = 0, best_b1 = 0, best_b2 = 0;
+		bool hit_anything = false;
+
+		while (true)
+		{
+			const bvh_node& n = nodes[node];
+			TRACE_COUNT(node_visits, 1);
+
+			if (!node_hit(n, r, inv_dir, ray_tmin, closest))
+			{
+				if (sp == 0) break;
+				node = stack[--sp];
+				continue;
+			}
+
+			if (n.count > 0)
+			{
+				// 리프 노드: 가리키는 삼각형들을 모두 검사
+				TRACE_COUNT(primitive_tests, n.count);
+				if (intersect_leaf(n, wr, ray_tmin, closest, best, best_b0, best_b1, best_b2)) hit_anything = true;
+				if (sp == 0) break;
+				node = stack[--sp];
+			}
+			else
+			{
+				// 내부 노드: 반직선 방향상 가까운 자식 노드부터 방문해야 closest 가 빨리 줄어들어 더 많은 노드를 건너뛸 수 있음.
+				std::uint32_t left = node + 1, right = n.first;
+				if (r.direction()[n.axis] < 0) std::swap(left, right);
+				stack[sp++] = right;
+				node = left;
+			}
+		}
+
+		if (!hit_anything) return false;
+
+		set_hit_record(r, closest, best, best_b0, best_b1, best_b2, rec);
+		return true;
+	}
+
+	// 반직선 count 개의 가장 가까운 충돌 지점을 group_size 개씩 번갈아 진행시키면서 찾음. (하단 필기 '반직선 인터리빙' 참고)
+	/*
+		반직선마다 hit() 를 호출한 것과 같은 노드를 같은 순서로 방문하므로 결과도 같음.
+		hits[k] 에 반직선 k 의 충돌 여부를 저장하고, 충돌했으면 recs[k] 를 채움.
+
+		각 반직선은 노드 하나(또는 리프의 삼각형들)를 처리할 때마다 다음에 읽을 데이터를 프리페치하고 다음 반직선에게 차례를 넘기므로,
+		메쉬가 캐시보다 클 때 한 반직선이 메모리를 기다리는 동안 다른 반직선들의 계산이 진행됨.
+		group_size 가 1 이면 hit() 와 같은 순서로 실행됨. (프리페치만 추가됨.)
+	*/
+	void hit_interleaved(const ray* rays, size_t count, double ray_tmin, double ray_tmax, hit_record* recs, bool* hits, int group_size) const
+	{
+		if (nodes.empty())
+		{
+			std::fill(hits, hits + count, false);
+			return;
+		}
+
+		std::vector<traversal_state> group(std::max<size_t>(1, std::min<size_t>(count, static_cast<size_t>(std::max(group_size, 1)))));
+		size_t active = 0, next_ray = 0;
+		for (; active < group.size() && next_ray < count; ++active, ++next_ray) start_traversal(group[active], rays[next_ray], next_ray, ray_tmax);
+
+		// 살아있는 반직선들을 차례대로 한 단계씩 진행시킴. 끝난 반직선의 자리는 다음 반직선으로 채우고, 남은 반직선이 없으면 맨 뒤의 반직선과 바꿈.
+		while (active > 0)
+		{
+			for (size_t k = 0; k < active;)
+			{
+				traversal_state& state = group[k];
+				if (!step_traversal(state, rays[state.ray_index], ray_tmin))
+				{
+					++k;
+					continue;
+				}
+
+				hits[state.ray_index] = state.hit_anything;
+				if (state.hit_anything) finish_traversal(state, rays[state.ray_index], recs[state.ray_index]);
+
+				if (next_ray < count)
+				{
+					start_traversal(state, rays[next_ray], next_ray, ray_tmax);
+					++next_ray;
+					++k;
+				}
+				else
+				{
+					state = group[--active];
+				}
+			}
+		}
+	}
+
+	aabb bounding_box() const override
+	{
+		if (nodes.empty()) return aabb();
+		const bvh_node& root = nodes[0];
+		return aabb(point3(root.bmin[0], root.bmin[1], root.bmin[2]), point3(root.bmax[0], root.bmax[1], root.bmax[2]));
+	}
+
+	shared_ptr<hittable> clone() const override { return make_shared<triangle_mesh>(*this); }
+
+	// 메쉬가 사용하는 메모리 크기 (바이트)
+	size_t memory_bytes() const
+	{
+		return positions.capacity() * sizeof(float) + normals.capacity() * sizeof(float)
+			+ indices.capacity() * sizeof(std::uint32_t) + normal_indices.capacity() * sizeof(std::uint32_t)
+			+ nodes.capacity() * sizeof(bvh_node);
+	}
+
+private:
+	// BVH 노드 (32 바이트)
+	/*
+		깊이 우선 순서로 저장하기 때문에, 내부 노드의 왼쪽 자식은 항상 바로 다음 인덱스(node + 1)에 있고,
+		오른쪽 자식의 인덱스만 first 에 저장함.
+		리프 노드는 count > 0 이고, first 부터 count 개의 삼각형을 가리킴.
+	*/
+	struct bvh_node
+	{
+		float bmin[3];
+		float bmax[3];
+		std::uint32_t first;
+		std::uint16_t count;
+		std::uint16_t axis; // 내부 노드를 분할한 축
+	};
+
+	static const std::uint32_t leaf_size = 4; // 리프 노드 하나에 담을 최대 삼각형 개수
+
+	std::vector<bvh_node> nodes;
+
+	float vertex(std::uint32_t v, int axis) const { return positions[static_cast<size_t>(v) * 3 + axis]; }
+	point3 vertex_point(std::uint32_t v) const { return point3(vertex(v, 0), vertex(v, 1), vertex(v, 2)); }
+
+	// 반직선마다 한 번만 계산해두는 watertight 교차 검사용 값들 (하단 필기 'watertight 교차 검사' 참고)
+	struct watertight_ray
+	{
+		int kx, ky, kz;
+		double sx, sy, sz;
+		point3 origin;
+
+		watertight_ray() : kx(0), ky(1), kz(2), sx(0), sy(0), sz(0) {}
+
+		explicit watertight_ray(const ray& r) : origin(r.origin())
+		{
+			const vec3 d = r.direction();
+
+			// 방향벡터 성분의 절댓값이 가장 큰 축을 kz 로 삼음.
+			kz = (std::fabs(d.x()) > std::fabs(d.y())) ? (std::fabs(d.x()) > std::fabs(d.z()) ? 0 : 2)
+													   : (std::fabs(d.y()) > std::fabs(d.z()) ? 1 : 2);
+			kx = (kz + 1) % 3;
+			ky = (kx + 1) % 3;
+			if (d[kz] < 0) std::swap(kx, ky); // 삼각형의 감기 방향이 뒤집히지 않도록 함.
+
+			sx = d[kx] / d[kz];
+			sy = d[ky] / d[kz];
+			sz = 1.0 / d[kz];
+		}
+	};
+
+	// 삼각형 t 와 반직선의 교차 검사 (스칼라 구현)
+	/*
+		분기가 거의 없는 산술 연산만으로 이루어져 있어서, intersect_pair() 가 같은 연산을 같은 순서로 레인마다 수행함.
+		SSE2 를 사용할 수 없는 환경과, 리프의 삼각형 개수가 홀수일 때 남는 삼각형에 사용함.
+	*/
+	bool intersect(std::uint32_t t, const watertight_ray& wr, double ray_tmin, double ray_tmax,
+				   double& t_hit, double& b0, double& b1, double& b2) const
+	{
+		const vec3 A = vertex_point(indices[t * 3]) - wr.origin;
+		const vec3 B = vertex_point(indices[t * 3 + 1]) - wr.origin;
+		const vec3 C = vertex_point(indices[t * 3 + 2]) - wr.origin;
+
+		// 반직선 방향이 +z 축이 되도록 정점들을 기울이고(shear) 평행이동한 좌표계로 변환
+		const double ax = A[wr.kx] - wr.sx * A[wr.kz], ay = A[wr.ky] - wr.sy * A[wr.kz];
+		const double bx = B[wr.kx] - wr.sx * B[wr.kz], by = B[wr.ky] - wr.sy * B[wr.kz];
+		const double cx = C[wr.kx] - wr.sx * C[wr.kz], cy = C[wr.ky] - wr.sy * C[wr.kz];
+
+		// 2D 로 투영된 삼각형의 세 변에 대한 edge function (원점이 삼각형 안에 있으면 모두 같은 부호)
+		const double u = cx * by - cy * bx;
+		const double v = ax * cy - ay * cx;
+		const double w = bx * ay - by * ax;
+
+		if ((u < 0 || v < 0 || w < 0) && (u > 0 || v > 0 || w > 0)) return false;
+
+		const double det = u + v + w;
+		if (det == 0.0) return false;
+
+		const double az = wr.sz * A[wr.kz], bz = wr.sz * B[wr.kz], cz = wr.sz * C[wr.kz];
+		const double inv_det = 1.0 / det;
+		const double t_value = (u * az + v * bz + w * cz) * inv_det;
+		if (t_value <= ray_tmin || ray_tmax <= t_value) return false;
+
+		t_hit = t_value;
+		b0 = u * inv_det;
+		b1 = v * inv_det;
+		b2 = w * inv_det;
+		return true;
+	}
+
+#ifdef TRIANGLE_MESH_USE_SSE2
+	// 삼각형 t, t + 1 을 __m128d 의 두 레인에 나눠 담아서 intersect() 와 같은 계산을 함.
+	/*
+		intersect() 와 같은 연산을 같은 순서로 수행하므로, 각 레인의 결과는 스칼라 구현과 비트 단위로 같음.
+		edge function 의 부호와 det 검사를 통과한 레인을 비트마스크(레인 0 -> 비트 0)로 반환하고,
+		그 레인의 t 값과 무게중심 좌표를 t_values, bary 에 저장함. (t 의 범위 검사는 호출하는 쪽에서 함.)
+	*/
+	int intersect_pair(std::uint32_t t, const watertight_ray& wr, double t_values[2], double bary[3][2]) const
+	{
+		// 정점 좌표를 반직선 원점 기준으로 옮겨서 [축][레인] 순서로 모음. (kx, ky, kz 축만 필요함.)
+		const int axes[3] = { wr.kx, wr.ky, wr.kz };
+		alignas(16) double a[3][2], b[3][2], c[3][2];
+		for (int lane = 0; lane < 2; ++lane)
+		{
+			const size_t tri = static_cast<size_t>(t + lane) * 3;
+			for (int k = 0; k < 3; ++k)
+			{
+				a[k][lane] = vertex(indices[tri], axes[k]) - wr.origin[axes[k]];
+				b[k][lane] = vertex(indices[tri + 1], axes[k]) - wr.origin[axes[k]];
+				c[k][lane] = vertex(indices[tri + 2], axes[k]) - wr.origin[axes[k]];
+			}
+		}
+
+		const __m128d sx = _mm_set1_pd(wr.sx), sy = _mm_set1_pd(wr.sy), sz = _mm_set1_pd(wr.sz), zero = _mm_setzero_pd();
+		const __m128d akz = _mm_load_pd(a[2]), bkz = _mm_load_pd(b[2]), ckz = _mm_load_pd(c[2]);
+
+		// 반직선 방향이 +z 축이 되도록 기울인(shear) 좌표
+		const __m128d ax = _mm_sub_pd(_mm_load_pd(a[0]), _mm_mul_pd(sx, akz)), ay = _mm_sub_pd(_mm_load_pd(a[1]), _mm_mul_pd(sy, akz));
+		const __m128d bx = _mm_sub_pd(_mm_load_pd(b[0]), _mm_mul_pd(sx, bkz)), by = _mm_sub_pd(_mm_load_pd(b[1]), _mm_mul_pd(sy, bkz));
+		const __m128d cx = _mm_sub_pd(_mm_load_pd(c[0]), _mm_mul_pd(sx, ckz)), cy = _mm_sub_pd(_mm_load_pd(c[1]), _mm_mul_pd(sy, ckz));
+
+		// edge function
+		const __m128d u = _mm_sub_pd(_mm_mul_pd(cx, by), _mm_mul_pd(cy, bx));
+		const __m128d v = _mm_sub_pd(_mm_mul_pd(ax, cy), _mm_mul_pd(ay, cx));
+		const __m128d w = _mm_sub_pd(_mm_mul_pd(bx, ay), _mm_mul_pd(by, ax));
+
+		// 부호가 섞여 있거나 det 가 0 인 레인은 탈락 (NaN 은 intersect() 와 마찬가지로 모든 비교가 false)
+		const __m128d negative = _mm_or_pd(_mm_or_pd(_mm_cmplt_pd(u, zero), _mm_cmplt_pd(v, zero)), _mm_cmplt_pd(w, zero));
+		const __m128d positive = _mm_or_pd(_mm_or_pd(_mm_cmpgt_pd(u, zero), _mm_cmpgt_pd(v, zero)), _mm_cmpgt_pd(w, zero));
+		const __m128d det = _mm_add_pd(_mm_add_pd(u, v), w);
+		const __m128d rejected = _mm_or_pd(_mm_and_pd(negative, positive), _mm_cmpeq_pd(det, zero));
+		const int mask = ~_mm_movemask_pd(rejected) & 3;
+		if (mask == 0) return 0;
+
+		const __m128d az = _mm_mul_pd(sz, akz), bz = _mm_mul_pd(sz, bkz), cz = _mm_mul_pd(sz, ckz);
+		const __m128d inv_det = _mm_div_pd(_mm_set1_pd(1.0), det);
+		const __m128d t_value = _mm_mul_pd(_mm_add_pd(_mm_add_pd(_mm_mul_pd(u, az), _mm_mul_pd(v, bz)), _mm_mul_pd(w, cz)), inv_det);
+
+		_mm_storeu_pd(t_values, t_value);
+		_mm_storeu_pd(bary[0], _mm_mul_pd(u, inv_det));
+		_mm_storeu_pd(bary[1], _mm_mul_pd(v, inv_det));
+		_mm_storeu_pd(bary[2], _mm_mul_pd(w, inv_det));
+		return mask;
+	}
+#endif
+
+	// 리프 노드 n 의 삼각형들 중 (ray_tmin, closest) 구간에서 가장 가까운 교차 지점을 찾음.
+	/*
+		교차하는 삼각형이 있으면 closest, best, b0 ~ b2 를 갱신하고 true 를 반환함.
+		삼각형 순서대로 closest 를 줄여가며 비교하므로, t 가 같으면 앞쪽 삼각형이 선택됨. (스칼라 구현과 같은 결과)
+	*/
+	bool intersect_leaf(const bvh_node& n, const watertight_ray& wr, double ray_tmin, double& closest, std::uint32_t& best,
+						double& b0, double& b1, double& b2) const
+	{
+		bool hit_anything = false;
+		std::uint32_t t = n.first;
+		const std::uint32_t end = n.first + n.count;
+
+#ifdef TRIANGLE_MESH_USE_SSE2
+		for (; t + 2 <= end; t += 2)
+		{
+			double t_values[2], bary[3][2];
+			const int mask = intersect_pair(t, wr, t_values, bary);
+			for (int lane = 0; lane < 2; ++lane)
+			{
+				// intersect() 의 범위 검사와 같은 조건 (closest 는 앞 레인의 결과로 줄어들었을 수 있음.)
+				if (!(mask & (1 << lane)) || t_values[lane] <= ray_tmin || closest <= t_values[lane]) continue;
+				closest = t_values[lane];
+				best = t + lane;
+				b0 = bary[0][lane]; b1 = bary[1][lane]; b2 = bary[2][lane];
+				hit_anything = true;
+			}
+		}
+#endif
+		for (; t < end; ++t)
+		{
+			double t_hit, u, v, w;
+			if (intersect(t, wr, ray_tmin, closest, t_hit, u, v, w))
+			{
+				closest = t_hit;
+				best = t;
+				b0 = u; b1 = v; b2 = w;
+				hit_anything = true;
+			}
+		}
+		return hit_anything;
+	}
+
+	// 정점 노멀이 있으면 무게중심 좌표(barycentric)로 보간하고, 없으면 삼각형 면의 노멀을 사용함.
+	vec3 shading_normal(std::uint32_t t, double b0, double b1, double b2) const
+	{
+		if (!normals.empty())
+		{
+			const std::vector<std::uint32_t>& ni = normal_indices.empty() ? indices : normal_indices;
+			auto n = [&](int k)
+			{
+				size_t i = static_cast<size_t>(ni[t * 3 + k]) * 3;
+				return vec3(normals[i], normals[i + 1], normals[i + 2]);
+			};
+			vec3 interpolated = b0 * n(0) + b1 * n(1) + b2 * n(2);
+			if (interpolated.length_squared() > 0) return unit_vector(interpolated);
+		}
+
+		const point3 p0 = vertex_point(indices[t * 3]);
+		return unit_vector(cross(vertex_point(indices[t * 3 + 1]) - p0, vertex_point(indices[t * 3 + 2]) - p0));
+	}
+
+	void set_hit_record(const ray& r, double t, std::uint32_t triangle, double b0, double b1, double b2, hit_record& rec) const
+	{
+		rec.t = t;
+		rec.p = r.at(rec.t);
+		rec.normal = shading_normal(triangle, b0, b1, b2);
+
+		// 메쉬의 삼각형 감기 방향(winding)이 일정하지 않을 수 있으므로, 노멀이 항상 반직선 쪽을 향하도록 뒤집어 줌.
+		if (dot(rec.normal, r.direction()) > 0) rec.normal = -rec.normal;
+	}
+
+	// p 가 가리키는 캐시 라인을 미리 읽어오도록 요청함. (읽기가 끝날 때까지 기다리지 않음.)
+	static void prefetch(const void* p)
+	{
+#ifdef TRIANGLE_MESH_USE_PREFETCH
+		_mm_prefetch(static_cast<const char*>(p), _MM_HINT_T0);
+#else
+		(void)p;
+#endif
+	}
+
+public:
+	// 아래의 순회 상태와 단계 함수들은 scene_hierarchy (interleaved.h) 가 장면 순회 중에 만난 메쉬의 안쪽을 순회할 때도 사용함.
+	// hit_interleaved() 에서 반직선 하나의 순회 상태 (hit() 의 지역 변수들과 다음에 할 일)
+	struct traversal_state
+	{
+		enum step_kind
+		{
+			visit_node, // node 의 경계 상자를 검사 (노드는 프리페치해둔 상태)
+			load_leaf, // 리프 node 의 삼각형 인덱스는 프리페치해둔 상태 -> 정점 좌표를 프리페치
+			test_leaf // 리프 node 의 정점 좌표는 프리페치해둔 상태 -> 삼각형들과 교차 검사
+		};
+
+		size_t ray_index;
+		step_kind step;
+		watertight_ray wr;
+		vec3 inv_dir;
+		std::uint32_t stack[64];
+		int sp;
+		std::uint32_t node;
+		double closest;
+		std::uint32_t best;
+		double b0, b1, b2;
+		bool hit_anything;
+	};
+
+	void start_traversal(traversal_state& state, const ray& r, size_t ray_index, double ray_tmax) const
+	{
+		state.ray_index = ray_index;
+		state.step = traversal_state::visit_node;
+		state.wr = watertight_ray(r);
+		state.inv_dir = vec3(1.0 / r.direction().x(), 1.0 / r.direction().y(), 1.0 / r.direction().z());
+		state.sp = 0;
+		state.node = 0;
+		state.closest = ray_tmax;
+		state.best = 0;
+		state.b0 = state.b1 = state.b2 = 0;
+		state.hit_anything = false;
+		prefetch(&nodes[0]);
+	}
+
+	// 반직선 하나를 한 단계 진행시킴. 순회가 끝나면 true 를 반환함. (hit() 의 반복문 한 번을 메모리 읽기 단위로 나눈 것)
+	bool step_traversal(traversal_state& state, const ray& r, double ray_tmin) const
+	{
+		const bvh_node& n = nodes[state.node];
+		switch (state.step)
+		{
+		case traversal_state::visit_node:
+			TRACE_COUNT(node_visits, 1);
+			if (!node_hit(n, r, state.inv_dir, ray_tmin, state.closest)) return pop_node(state);
+
+			if (n.count > 0)
+			{
+				// 리프 노드의 삼각형 인덱스 구간의 처음과 끝을 프리페치함. (리프 하나의 인덱스는 최대 48 바이트)
+				prefetch(&indices[static_cast<size_t>(n.first) * 3]);
+				prefetch(&indices[(static_cast<size_t>(n.first) + n.count) * 3 - 1]);
+				state.step = traversal_state::load_leaf;
+			}
+			else
+			{
+				std::uint32_t left = state.node + 1, right = n.first;
+				if (r.direction()[n.axis] < 0) std::swap(left, right);
+				state.stack[state.sp++] = right;
+				state.node = left;
+				prefetch(&nodes[left]);
+			}
+			return false;
+
+		case traversal_state::load_leaf:
+			for (std::uint32_t t = n.first; t < n.first + n.count; ++t)
+				for (int v = 0; v < 3; ++v) prefetch(&positions[static_cast<size_t>(indices[t * 3 + v]) * 3]);
+			state.step = traversal_state::test_leaf;
+			return false;
+
+		default:
+			TRACE_COUNT(primitive_tests, n.count);
+			if (intersect_leaf(n, state.wr, ray_tmin, state.closest, state.best, state.b0, state.b1, state.b2)) state.hit_anything = true;
+			return pop_node(state);
+		}
+	}
+
+	// 순회가 끝난 state 의 가장 가까운 충돌로 rec 을 채움. (state.hit_anything 이 true 일 때만 호출)
+	void finish_traversal(const traversal_state& state, const ray& r, hit_record& rec) const
+	{
+		set_hit_record(r, state.closest, state.best, state.b0, state.b1, state.b2, rec);
+	}
+
+private:
+	// 스택에서 다음 노드를 꺼내서 프리페치함. 스택이 비어있으면 순회가 끝난 것이므로 true 를 반환함.
+	bool pop_node(traversal_state& state) const
+	{
+		if (state.sp == 0) return true;
+		state.node = state.stack[--state.sp];
+		state.step = traversal_state::visit_node;
+		prefetch(&nodes[state.node]);
+		return false;
+	}
+
+	bool node_hit(const bvh_node& n, const ray& r, const vec3& inv_dir, double ray_tmin, double ray_tmax) const
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			double t0 = (n.bmin[a] - r.origin()[a]) * inv_dir[a];
+			double t1 = (n.bmax[a] - r.origin()[a]) * inv_dir[a];
+			if (inv_dir[a] < 0.0) std::swap(t0, t1);
+			ray_tmin = t0 > ray_tmin ? t0 : ray_tmin;
+			ray_tmax = t1 < ray_tmax ? t1 : ray_tmax;
+			if (ray_tmax < ray_tmin) return false;
+		}
+		return true;
+	}
+
+	// order[begin, end) 구간의 삼각형들을 감싸는 노드를 만들고, 삼각형이 많으면 둘로 나눠서 재귀적으로 자식 노드를 만듦.
+	void build_node(std::vector<std::uint32_t>& order, const std::vector<float>& centroids, std::uint32_t begin, std::uint32_t end)
+	{
+		const std::uint32_t index = static_cast<std::uint32_t>(nodes.size());
+		nodes.push_back(bvh_node());
+
+		bvh_node n;
+		float cmin[3], cmax[3];
+		for (int a = 0; a < 3; ++a)
+		{
+			n.bmin[a] = cmin[a] = infinity_f();
+			n.bmax[a] = cmax[a] = -infinity_f();
+		}
+
+		for (std::uint32_t k = begin; k < end; ++k)
+		{
+			const std::uint32_t t = order[k];
+			for (int a = 0; a < 3; ++a)
+			{
+				for (int v = 0; v < 3; ++v)
+				{
+					float p = vertex(indices[t * 3 + v], a);
+					n.bmin[a] = std::min(n.bmin[a], p);
+					n.bmax[a] = std::max(n.bmax[a], p);
+				}
+				cmin[a] = std::min(cmin[a], centroids[t * 3 + a]);
+				cmax[a] = std::max(cmax[a], centroids[t * 3 + a]);
+			}
+		}
+
+		// 중점들이 가장 넓게 퍼져있는 축을 분할 축으로 선택
+		int axis = 0;
+		for (int a = 1; a < 3; ++a)
+			if (cmax[a] - cmin[a] > cmax[axis] - cmin[axis]) axis = a;
+
+		if (end - begin <= leaf_size || cmax[axis] <= cmin[axis])
+		{
+			n.first = begin;
+			n.count = static_cast<std::uint16_t>(std::min<std::uint32_t>(end - begin, 0xffff));
+			n.axis = 0;
+			nodes[index] = n;
+
+			// 중점이 모두 같은데 삼각형 개수가 많은 경우, 개수 제한을 넘는 나머지는 별도의 리프들로 나눔.
+			if (end - begin > 0xffff) split_oversized_leaf(index, order, centroids, begin, end);
+			return;
+		}
+
+		// 중점 기준으로 정렬했을 때 가운데에 오는 삼각형을 기준으로 절반씩 나눔. (전체 정렬 대신 nth_element 로 O(n))
+		const std::uint32_t mid = begin + (end - begin) / 2;
+		std::nth_element(order.begin() + begin, order.begin() + mid, order.begin() + end,
+						 [&](std::uint32_t a, std::uint32_t b) { return centroids[a * 3 + axis] < centroids[b * 3 + axis]; });
+
+		build_node(order, centroids, begin, mid); // 왼쪽 자식은 바로 다음 인덱스에 만들어짐.
+		n.first = static_cast<std::uint32_t>(nodes.size()); // 오른쪽 자식의 인덱스
+		n.count = 0;
+		n.axis = static_cast<std::uint16_t>(axis);
+		build_node(order, centroids, mid, end);
+		nodes[index] = n;
+	}
+
+	// count 필드(16비트)에 담을 수 없을 만큼 큰 리프는 인덱스 순서대로 반씩 나눈 내부 노드로 바꿔줌.
+	void split_oversized_leaf(std::uint32_t index, std::vector<std::uint32_t>& order, const std::vector<float>& centroids,
+							  std::uint32_t begin, std::uint32_t end)
+	{
+		bvh_node n = nodes[index];
+		const std::uint32_t mid = begin + (end - begin) / 2;
+		nodes.resize(index + 1);
+		build_leaf_range(order, centroids, begin, mid);
+		n.first = static_cast<std::uint32_t>(nodes.size());
+		n.count = 0;
+		build_leaf_range(order, centroids, mid, end);
+		nodes[index] = n;
+	}
+
+	void build_leaf_range(std::vector<std::uint32_t>& order, const std::vector<float>& centroids, std::uint32_t begin, std::uint32_t end)
+	{
+		const std::uint32_t index = static_cast<std::uint32_t>(nodes.size());
+		nodes.push_back(bvh_node());
+		bvh_node n = nodes[index];
+		for (int a = 0; a < 3; ++a)
+		{
+			n.bmin[a] = infinity_f();
+			n.bmax[a] = -infinity_f();
+		}
+		for (std::uint32_t k = begin; k < end; ++k)
+			for (int v = 0; v < 3; ++v)
+				for (int a = 0; a < 3; ++a)
+				{
+					n.bmin[a] = std::min(n.bmin[a], vertex(indices[order[k] * 3 + v], a));
+					n.bmax[a] = std::max(n.bmax[a], vertex(indices[order[k] * 3 + v], a));
+				}
+
+		n.first = begin;
+		n.count = static_cast<std::uint16_t>(std::min<std::uint32_t>(end - begin, 0xffff));
+		n.axis = 0;
+		nodes[index] = n;
+		if (end - begin > 0xffff) split_oversized_leaf(index, order, centroids, begin, end);
+	}
+
+	static float infinity_f() { return std::numeric_limits<float>::infinity(); }
+
+	// 삼각형 단위(인덱스 3개씩)로 order 순서에 맞게 버퍼를 재배열
+	static void reorder(std::vector<std::uint32_t>& buffer, const std::vector<std::uint32_t>& order)
+	{
+		std::vector<std::uint32_t> sorted(buffer.size());
+		for (size_t k = 0; k < order.size(); ++k)
+			for (int v = 0; v < 3; ++v)
+				sorted[k * 3 + v] = buffer[static_cast<size_t>(order[k]) * 3 + v];
+		buffer.swap(sorted);
+	}
+};
+
+// 위도 / 경도 방향으로 나눈 구체 메쉬를 생성 (파일 없이 큰 메쉬를 테스트할 때 사용)
+// 삼각형 개수는 약 2 * rings * segments 개
+inline void make_uv_sphere_mesh(triangle_mesh& mesh, const point3& center, double radius, int rings, int segments)
+{
+	mesh.positions.clear();
+	mesh.normals.clear();
+	mesh.indices.clear();
+	mesh.normal_indices.clear();
+
+	for (int i = 0; i <= rings; ++i)
+	{
+		double theta = pi * i / rings;
+		for (int j = 0; j <= segments; ++j)
+		{
+			double phi = 2.0 * pi * j / segments;
+			vec3 n(std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi));
+			point3 p = center + radius * n;
+			for (int a = 0; a < 3; ++a)
+			{
+				mesh.positions.push_back(static_cast<float>(p[a]));
+				mesh.normals.push_back(static_cast<float>(n[a]));
+			}
+		}
+	}
+
+	auto vertex_index = [&](int i, int j) { return static_cast<std::uint32_t>(i * (segments + 1) + j); };
+	for (int i = 0; i < rings; ++i)
+	{
+		for (int j = 0; j < segments; ++j)
+		{
+			std::uint32_t a = vertex_index(i, j), b = vertex_index(i + 1, j), c = vertex_index(i + 1, j + 1), d = vertex_index(i, j + 1);
+			if (i != 0) mesh.indices.insert(mesh.indices.end(), { a, b, d }); // 북극점에서는 넓이가 0 인 삼각형이 생기므로 제외
+			if (i != rings - 1) mesh.indices.insert(mesh.indices.end(), { b, c, d }); // 남극점도 마찬가지
+		}
+	}
+
+	mesh.build();
+}
+
+#endif // !TRIANGLE_MESH_H
+
+/*
+	watertight 교차 검사 (Woop, Benthin, Wald 2013)
+
+
+	흔히 쓰는 Möller–Trumbore 알고리즘은 인접한 두 삼각형이 공유하는 변(edge) 위를
+	정확히 지나가는 반직선에 대해, 부동소수점 오차 때문에 두 삼각형 모두와 교차하지 않는다고
+	판단하는 경우가 있음. 그러면 메쉬 표면에 작은 구멍이 뚫린 것처럼 보이게 됨.
+
+	watertight 알고리즘은 반직선 방향이 +z 축이 되도록 삼각형의 정점들을 변환한 뒤,
+	2D 로 투영된 삼각형에 원점이 포함되는지를 edge function 으로 검사함.
+
+	이때, 공유하는 변에 대한 edge function 은 두 삼각형에서 정확히 같은 연산으로 계산되기 때문에
+	(부호만 반대), 변 위를 지나가는 반직선은 적어도 한 쪽 삼각형과는 반드시 교차하게 됨.
+
+	SSE2 에서는 리프의 삼각형(최대 4개)을 2개씩 __m128d 의 두 레인에 담아서 검사함. (intersect_pair())
+	정점 좌표는 인덱스를 따라 흩어져 있으므로 레인별로 모아오는(gather) 부분은 스칼라로 읽고,
+	shear, edge function, det, t 계산은 레인마다 스칼라 구현과 같은 연산을 같은 순서로 수행하므로,
+	watertight 성질과 교차 결과가 스칼라 구현과 비트 단위로 같음.
+	AVX 를 가정하지 않으므로 삼각형 4개를 한 레지스터에 담지는 않음.
+*/
+
+/*
+	반직선 인터리빙 (hit_interleaved)
+
+
+	메쉬가 마지막 단계 캐시(LLC)보다 크면, 반직선 하나가 BVH 를 순회하면서 읽는 노드와 삼각형은 대부분 캐시에 없음.
+	hit() 는 다음에 읽을 노드의 주소가 방금 읽은 노드에서 나오기 때문에(pointer chasing),
+	메모리에서 데이터가 올 때까지 CPU 가 할 일 없이 기다리는 시간이 순회 시간의 대부분을 차지하게 됨.
+
+	hit_interleaved() 는 순회를 메모리 읽기 단위의 단계로 나누고, 반직선마다의 지역 변수(스택, 현재 노드, 가장 가까운 충돌)를
+	traversal_state 에 담아서, 손으로 만든 코루틴(상태 기계)처럼 여러 반직선을 번갈아 실행함.
+
+		1. visit_node : 노드의 경계 상자를 검사하고, 다음에 방문할 노드(또는 리프의 인덱스)를 프리페치
+		2. load_leaf  : 리프의 삼각형 인덱스를 읽어서 정점 좌표를 프리페치
+		3. test_leaf  : 삼각형들과 교차 검사하고, 스택에서 꺼낸 다음 노드를 프리페치
+
+	각 단계가 끝날 때 프리페치만 요청하고 바로 다음 반직선으로 넘어가므로,
+	group_size 개의 반직선이 있으면 한 반직선의 데이터가 메모리에서 오는 동안 나머지 반직선들의 단계가 실행됨.
+	(C++20 코루틴의 co_await 로도 같은 구조를 만들 수 있지만, 이 프로젝트는 C++14 로 빌드하므로 상태 기계로 직접 구현함.)
+
+	메쉬가 캐시 안에 들어가는 크기라면 기다리는 시간이 원래 짧으므로, 상태를 저장하고 반직선을 바꾸는 비용만큼 오히려 느려짐. (30 ~ 40%)
+	그래서 hit() 를 대체하지 않고, 큰 메쉬에 많은 반직선을 한꺼번에 추적할 때 골라서 사용하는 별도의 함수로 둠.
+	--interleave-bench 로 캐시보다 큰 메쉬와 작은 메쉬에서의 속도를 비교해볼 수 있음.
+*/
@@ -2,6 +2,9 @@
 #define VEC3_H
 // 헤더 가드를 위한 전처리기 선언
 
+#include "rtweekend.h" // 무작위 벡터 생성 시 random_double() 을 사용하기 위해 포함
+#include "fast_math.h" // RT_FAST_MATH 빌드에서 근사 역제곱근으로 정규화하기 위해 포함
+
 #include <cmath> // std::sqrt() 사용하기 위해 포함
 #include <iostream>
 
@@ -127,6 +130,16 @@ public:
     double length_squared() const {
         return e[0] * e[0] + e[1] * e[1] + e[2] * e[2];
     }
+
+    // 각 컴포넌트가 무작위 값인 vec3 를 생성하는 정적 멤버함수들
+    // 객체 없이 vec3::random() 처럼 클래스 이름으로 호출할 수 있음.
+    static vec3 random() {
+        return vec3(random_double(), random_double(), random_double());
+    }
+
+    static vec3 random(double min, double max) {
+        return vec3(random_double(min, max), random_double(min, max), random_double(min, max));
+    }
 };
 
 // vec3 에 대한 별칭으로써 point3 선언
@@ -234,9 +247,38 @@ inline vec3 cross(const vec3& u, const vec3& v) {
         u.e[0] * v.e[1] - u.e[1] * v.e[0]);
 }
 
-// 벡터 정규화 연산
-inline vec3 unit_vector(vec3 v) {
+// sqrt() 와 나눗셈으로 정확하게 계산하는 벡터 정규화 연산
+inline vec3 unit_vector_exact(vec3 v) {
     return v / v.length();
 }
 
+// 근사 역제곱근을 곱하는 벡터 정규화 연산 (길이의 상대 오차는 fast_rsqrt_max_rel_error 이내, fast_math.h 참고)
+inline vec3 unit_vector_fast(vec3 v) {
+    return rsqrt_fast(v.length_squared()) * v;
+}
+
+// 벡터 정규화 연산 (RT_FAST_MATH 빌드에서는 근사 역제곱근을 사용함.)
+inline vec3 unit_vector(vec3 v) {
+#if RT_FAST_MATH
+    return unit_vector_fast(v);
+#else
+    return unit_vector_exact(v);
+#endif
+}
+
+// 단위 구체 내부의 무작위 점을 반환
+// 정육면체 범위에서 무작위 점을 뽑은 뒤, 단위 구체 바깥에 있는 점은 버리고 다시 뽑는 방식(rejection method)
+inline vec3 random_in_unit_sphere() {
+    while (true) {
+        auto p = vec3::random(-1, 1);
+        if (p.length_squared() < 1)
+            return p;
+    }
+}
+
+// 단위 구체 표면 위의 무작위 점(= 무작위 방향의 단위벡터)을 반환
+inline vec3 random_unit_vector() {
+    return unit_vector(random_in_unit_sphere());
+}
+
 #endif // !VEC3_H